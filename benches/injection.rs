@@ -0,0 +1,278 @@
+//! Injection latency and throughput benchmarks.
+//!
+//! Uses the `hook-inject-fixture-target` / `hook-inject-fixture-agent` crates,
+//! like the smoke tests. Run with `cargo bench --bench injection`.
+//!
+//! Every group uses whichever injector the process was started with, and
+//! `injector_mode` is named after it; compare modes with separate runs, e.g.
+//! `HOOK_INJECT_INJECTOR=inprocess cargo bench --bench injection -- injector_mode`.
+//! The variable is never changed from here, since the backend's threads may
+//! read the environment at any time.
+
+use std::path::PathBuf;
+use std::process::{Child, Command};
+use std::time::Duration;
+
+use criterion::{BatchSize, BenchmarkId, Criterion, Throughput, criterion_group, criterion_main};
+use hook_inject::{BackendPool, InjectedProgram, Library, Process, Program, Stdio};
+
+const PAYLOAD_PADDING: [usize; 3] = [0, 1 << 20, 8 << 20];
+const CONCURRENT_TARGETS: [usize; 2] = [4, 16];
+
+struct Fixtures {
+    target: PathBuf,
+    agent: PathBuf,
+}
+
+/// Fixture target process, killed when dropped.
+struct Target {
+    child: Child,
+    process: Process,
+}
+
+impl Drop for Target {
+    fn drop(&mut self) {
+        let _ = self.child.kill();
+        let _ = self.child.wait();
+    }
+}
+
+/// Program launched by the injector, killed and reaped when dropped.
+struct Launched(InjectedProgram);
+
+impl Drop for Launched {
+    fn drop(&mut self) {
+        kill_and_reap(self.0.process());
+    }
+}
+
+#[cfg(unix)]
+fn kill_and_reap(process: Process) {
+    let pid = process.pid();
+    unsafe {
+        libc::kill(pid, libc::SIGKILL);
+        if libc::waitpid(pid, std::ptr::null_mut(), 0) == pid {
+            return;
+        }
+    }
+    // Spawned through Frida's helper, which reaps it; wait for that.
+    let deadline = std::time::Instant::now() + Duration::from_secs(5);
+    while unsafe { libc::kill(pid, 0) } == 0 && std::time::Instant::now() < deadline {
+        std::thread::sleep(Duration::from_millis(1));
+    }
+}
+
+#[cfg(windows)]
+fn kill_and_reap(process: Process) {
+    let _ = Command::new("taskkill")
+        .args(["/F", "/PID", &process.pid().to_string()])
+        .output();
+}
+
+fn fixtures() -> Fixtures {
+    let root = PathBuf::from(env!("CARGO_MANIFEST_DIR"));
+    for package in ["hook-inject-fixture-target", "hook-inject-fixture-agent"] {
+        let status = Command::new("cargo")
+            .args(["build", "--release", "-p", package])
+            .current_dir(&root)
+            .status()
+            .expect("failed to build fixture");
+        assert!(status.success());
+    }
+
+    let out = root.join("target").join("release");
+    let agent = out.join(format!(
+        "{}hook_inject_fixture_agent{}",
+        std::env::consts::DLL_PREFIX,
+        std::env::consts::DLL_SUFFIX
+    ));
+    let target = out.join(format!(
+        "hook-inject-fixture-target{}",
+        std::env::consts::EXE_SUFFIX
+    ));
+    Fixtures { target, agent }
+}
+
+fn spawn_target(fixtures: &Fixtures) -> Target {
+    let child = Command::new(&fixtures.target)
+        .arg("600000")
+        .spawn()
+        .expect("failed to spawn fixture target");
+    let process = Process::from_pid(child.id() as i32).expect("target pid should exist");
+    Target { child, process }
+}
+
+/// Agent image padded with trailing zeros to `padding` extra bytes.
+fn padded_agent(fixtures: &Fixtures, padding: usize) -> (PathBuf, Vec<u8>) {
+    let mut bytes = std::fs::read(&fixtures.agent).expect("read fixture agent");
+    bytes.resize(bytes.len() + padding, 0);
+
+    let path = std::env::temp_dir().join(format!(
+        "hook-inject-bench-{}-{padding}{}",
+        std::process::id(),
+        std::env::consts::DLL_SUFFIX
+    ));
+    std::fs::write(&path, &bytes).expect("write padded agent");
+    (path, bytes)
+}
+
+fn inject_once(pool: &BackendPool, process: Process, library: &Library) {
+    pool.inject_process(process, library.clone())
+        .expect("injection should succeed")
+        .uninject()
+        .expect("uninject should succeed");
+}
+
+fn bench_init(c: &mut Criterion) {
+    let mut group = c.benchmark_group("init");
+    group.sample_size(10);
+    // Returned pools are dropped after the timer stops, so teardown is
+    // not measured.
+    group.bench_function("backend", |b| {
+        b.iter_batched(
+            || (),
+            |_| BackendPool::new(1).expect("backend should start"),
+            BatchSize::PerIteration,
+        )
+    });
+    group.bench_function("warm_up/cold", |b| {
+        b.iter_batched(
+            || BackendPool::new(1).expect("backend should start"),
+            |pool| {
+                pool.warm_up().expect("warm up should succeed");
+                pool
+            },
+            BatchSize::PerIteration,
+        )
+    });
+
+    let pool = BackendPool::new(1).expect("backend should start");
+    pool.warm_up().expect("warm up should succeed");
+    group.bench_function("warm_up/warm", |b| {
+        b.iter(|| pool.warm_up().expect("warm up should succeed"))
+    });
+    group.finish();
+}
+
+fn bench_payload(c: &mut Criterion) {
+    let fixtures = fixtures();
+    let target = spawn_target(&fixtures);
+    let pool = BackendPool::new(1).expect("backend should start");
+    pool.warm_up().expect("warm up should succeed");
+
+    let mut group = c.benchmark_group("inject_payload");
+    for padding in PAYLOAD_PADDING {
+        let (path, bytes) = padded_agent(&fixtures, padding);
+        group.throughput(Throughput::Bytes(bytes.len() as u64));
+
+        let from_path = Library::from_path(&path).expect("path library");
+        group.bench_with_input(BenchmarkId::new("path", padding), &from_path, |b, lib| {
+            b.iter(|| inject_once(&pool, target.process, lib))
+        });
+
+        let from_blob = Library::from_bytes(bytes).expect("blob library");
+        group.bench_with_input(BenchmarkId::new("blob", padding), &from_blob, |b, lib| {
+            b.iter(|| inject_once(&pool, target.process, lib))
+        });
+
+        let _ = std::fs::remove_file(path);
+    }
+    group.finish();
+}
+
+fn bench_injector_mode(c: &mut Criterion) {
+    let fixtures = fixtures();
+    let target = spawn_target(&fixtures);
+    let library = Library::from_path(&fixtures.agent).expect("fixture lib");
+
+    let mode = std::env::var("HOOK_INJECT_INJECTOR").unwrap_or_else(|_| "helper".into());
+    let pool = BackendPool::new(1).expect("backend should start");
+    pool.warm_up().expect("warm up should succeed");
+
+    let mut group = c.benchmark_group("injector_mode");
+    group.bench_function(mode, |b| {
+        b.iter(|| inject_once(&pool, target.process, &library))
+    });
+    group.finish();
+}
+
+fn bench_launch(c: &mut Criterion) {
+    let fixtures = fixtures();
+    let library = Library::from_path(&fixtures.agent).expect("fixture lib");
+    let pool = BackendPool::new(1).expect("backend should start");
+    pool.warm_up().expect("warm up should succeed");
+
+    let mut group = c.benchmark_group("launch");
+    group.sample_size(10);
+    // Each child is killed and reaped after the timer stops.
+    group.bench_function("spawn+inject+resume", |b| {
+        b.iter_batched(
+            || {
+                let mut program = Program::new(&fixtures.target);
+                program.arg("100");
+                program.stdio(Stdio::Null)
+            },
+            |program| {
+                let launched = pool
+                    .inject_program(program, library.clone())
+                    .expect("launch should succeed");
+                Launched(launched)
+            },
+            BatchSize::PerIteration,
+        )
+    });
+    group.finish();
+}
+
+fn bench_concurrent(c: &mut Criterion) {
+    let fixtures = fixtures();
+    let library = Library::from_path(&fixtures.agent).expect("fixture lib");
+    let pools = [
+        ("single", BackendPool::new(1).expect("backend should start")),
+        ("pool4", BackendPool::new(4).expect("pool should start")),
+    ];
+    for (_, pool) in &pools {
+        pool.warm_up().expect("warm up should succeed");
+    }
+
+    let mut group = c.benchmark_group("concurrent");
+    for count in CONCURRENT_TARGETS {
+        let targets: Vec<Target> = (0..count).map(|_| spawn_target(&fixtures)).collect();
+        let processes: Vec<Process> = targets.iter().map(|target| target.process).collect();
+        group.throughput(Throughput::Elements(count as u64));
+        for (name, pool) in &pools {
+            group.bench_with_input(
+                BenchmarkId::new(*name, count),
+                &processes,
+                |b, processes| {
+                    b.iter(|| {
+                        let results = pool
+                            .inject_processes(processes, library.clone())
+                            .expect("backend should be available");
+                        for result in results {
+                            let _ = result.expect("injection should succeed").uninject();
+                        }
+                    })
+                },
+            );
+        }
+    }
+    group.finish();
+}
+
+fn config() -> Criterion {
+    // Injection latency is dominated by IPC with the helper; longer windows
+    // and a 5% noise floor keep CI runs comparable.
+    Criterion::default()
+        .sample_size(20)
+        .warm_up_time(Duration::from_secs(2))
+        .measurement_time(Duration::from_secs(10))
+        .noise_threshold(0.05)
+}
+
+criterion_group! {
+    name = benches;
+    config = config();
+    targets = bench_init, bench_payload, bench_injector_mode, bench_launch, bench_concurrent
+}
+criterion_main!(benches);
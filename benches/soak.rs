@@ -0,0 +1,516 @@
+//! Injection soak test: thousands of cycles, checked for leaks.
+//!
+//! Runs inject → uninject cycles against long-lived fixture targets, with
+//! the agent loaded from its path and then from an in-memory copy, then
+//! spawn → inject → resume cycles of short-lived ones, from several threads
+//! sharing the default backend. Throughput, latency percentiles, live
+//! backend objects, open descriptors and the RSS of this process and the
+//! Frida helper are written as JSON so runs can be diffed between releases.
+//!
+//! ```bash
+//! HOOK_INJECT_SOAK_CYCLES=10000 cargo bench --bench soak
+//! ```
+//!
+//! | Variable                     | Default                    |
+//! |------------------------------|----------------------------|
+//! | `HOOK_INJECT_SOAK_CYCLES`    | 2000 inject cycles         |
+//! | `HOOK_INJECT_SOAK_LAUNCHES`  | 200 launch cycles          |
+//! | `HOOK_INJECT_SOAK_THREADS`   | 4                          |
+//! | `HOOK_INJECT_SOAK_REPORT`    | `target/soak-report.json`  |
+
+use std::fmt::Write as _;
+use std::path::{Path, PathBuf};
+use std::process::{Child, Command};
+use std::time::{Duration, Instant, SystemTime, UNIX_EPOCH};
+
+use hook_inject::{Library, LiveObjects, Process, Program, Stdio};
+
+struct Config {
+    cycles: usize,
+    launches: usize,
+    threads: usize,
+    report: PathBuf,
+}
+
+impl Config {
+    fn from_env(root: &Path) -> Config {
+        Config {
+            cycles: env_usize("HOOK_INJECT_SOAK_CYCLES", 2000),
+            launches: env_usize("HOOK_INJECT_SOAK_LAUNCHES", 200),
+            threads: env_usize("HOOK_INJECT_SOAK_THREADS", 4).max(1),
+            report: std::env::var_os("HOOK_INJECT_SOAK_REPORT")
+                .map(PathBuf::from)
+                .unwrap_or_else(|| root.join("target").join("soak-report.json")),
+        }
+    }
+}
+
+fn env_usize(name: &str, default: usize) -> usize {
+    match std::env::var(name) {
+        Ok(value) => value
+            .parse()
+            .unwrap_or_else(|_| panic!("{name} must be a number, got {value:?}")),
+        Err(_) => default,
+    }
+}
+
+struct Fixtures {
+    target: PathBuf,
+    agent: PathBuf,
+}
+
+/// Fixture target process, killed when dropped.
+struct Target {
+    child: Child,
+    process: Process,
+}
+
+impl Drop for Target {
+    fn drop(&mut self) {
+        let _ = self.child.kill();
+        let _ = self.child.wait();
+    }
+}
+
+fn fixtures(root: &Path) -> Fixtures {
+    for package in ["hook-inject-fixture-target", "hook-inject-fixture-agent"] {
+        let status = Command::new("cargo")
+            .args(["build", "--release", "-p", package])
+            .current_dir(root)
+            .status()
+            .expect("failed to build fixture");
+        assert!(status.success());
+    }
+
+    let out = root.join("target").join("release");
+    let agent = out.join(format!(
+        "{}hook_inject_fixture_agent{}",
+        std::env::consts::DLL_PREFIX,
+        std::env::consts::DLL_SUFFIX
+    ));
+    let target = out.join(format!(
+        "hook-inject-fixture-target{}",
+        std::env::consts::EXE_SUFFIX
+    ));
+    Fixtures { target, agent }
+}
+
+fn spawn_target(fixtures: &Fixtures) -> Target {
+    let child = Command::new(&fixtures.target)
+        .arg("600000")
+        .spawn()
+        .expect("failed to spawn fixture target");
+    let process = Process::from_pid(child.id() as i32).expect("target pid should exist");
+    Target { child, process }
+}
+
+/// Latencies of one kind of operation, in microseconds.
+#[derive(Default)]
+struct Latencies {
+    samples: Vec<u64>,
+    errors: usize,
+}
+
+impl Latencies {
+    fn time<T, E: std::fmt::Display>(&mut self, op: impl FnOnce() -> Result<T, E>) -> Option<T> {
+        let start = Instant::now();
+        match op() {
+            Ok(value) => {
+                self.samples.push(start.elapsed().as_micros() as u64);
+                Some(value)
+            }
+            Err(err) => {
+                // Report the first few failures; the rest only count.
+                if self.errors < 5 {
+                    eprintln!("soak: operation failed: {err}");
+                }
+                self.errors += 1;
+                None
+            }
+        }
+    }
+
+    fn merge(&mut self, other: Latencies) {
+        self.samples.extend(other.samples);
+        self.errors += other.errors;
+    }
+
+    fn write_json(&mut self, out: &mut String) {
+        self.samples.sort_unstable();
+        let percentile = |p: f64| -> u64 {
+            if self.samples.is_empty() {
+                return 0;
+            }
+            let rank = ((self.samples.len() - 1) as f64 * p).round() as usize;
+            self.samples[rank]
+        };
+        let mean = if self.samples.is_empty() {
+            0
+        } else {
+            self.samples.iter().sum::<u64>() / self.samples.len() as u64
+        };
+        let _ = write!(
+            out,
+            "{{\"ok\": {}, \"errors\": {}, \"mean_us\": {mean}, \"p50_us\": {}, \"p90_us\": {}, \
+             \"p99_us\": {}, \"p999_us\": {}, \"max_us\": {}}}",
+            self.samples.len(),
+            self.errors,
+            percentile(0.50),
+            percentile(0.90),
+            percentile(0.99),
+            percentile(0.999),
+            self.samples.last().copied().unwrap_or(0),
+        );
+    }
+}
+
+/// One timed phase of the soak and the operations it measured.
+struct Phase {
+    name: &'static str,
+    cycles: usize,
+    wall: Duration,
+    ops: Vec<(&'static str, Latencies)>,
+}
+
+impl Phase {
+    fn write_json(&mut self, out: &mut String) {
+        let throughput = self.cycles as f64 / self.wall.as_secs_f64().max(f64::EPSILON);
+        let _ = write!(
+            out,
+            "\"{}\": {{\"cycles\": {}, \"wall_s\": {:.3}, \"cycles_per_s\": {throughput:.1}, \"latency\": {{",
+            self.name,
+            self.cycles,
+            self.wall.as_secs_f64()
+        );
+        for (index, (op, latencies)) in self.ops.iter_mut().enumerate() {
+            let _ = write!(out, "{}\"{op}\": ", if index == 0 { "" } else { ", " });
+            latencies.write_json(out);
+        }
+        out.push_str("}}");
+    }
+
+    fn summary(&self) -> String {
+        let errors: usize = self.ops.iter().map(|(_, latencies)| latencies.errors).sum();
+        format!(
+            "{}: {} cycles in {:.1}s ({:.1}/s), {errors} errors",
+            self.name,
+            self.cycles,
+            self.wall.as_secs_f64(),
+            self.cycles as f64 / self.wall.as_secs_f64().max(f64::EPSILON)
+        )
+    }
+}
+
+/// Process-level resources at one point of the run.
+#[derive(Clone, Copy)]
+struct Resources {
+    live: LiveObjects,
+    fds: Option<u64>,
+    rss_kib: Option<u64>,
+    helper_rss_kib: Option<u64>,
+}
+
+impl Resources {
+    fn sample() -> Resources {
+        Resources {
+            live: hook_inject::live_objects(),
+            fds: open_fds(),
+            rss_kib: rss_kib("self"),
+            helper_rss_kib: helper_rss_kib(),
+        }
+    }
+
+    fn write_json(&self, out: &mut String) {
+        let _ = write!(
+            out,
+            "{{\"contexts\": {}, \"async_ops\": {}, \"payloads\": {}, \"fds\": {}, \
+             \"rss_kib\": {}, \"helper_rss_kib\": {}}}",
+            self.live.contexts(),
+            self.live.async_ops(),
+            self.live.payloads(),
+            json_opt(self.fds),
+            json_opt(self.rss_kib),
+            json_opt(self.helper_rss_kib),
+        );
+    }
+
+    /// `self - baseline` for every counter both samples have.
+    fn write_growth_json(&self, baseline: &Resources, out: &mut String) {
+        let delta = |now: Option<u64>, then: Option<u64>| match (now, then) {
+            (Some(now), Some(then)) => (now as i64 - then as i64).to_string(),
+            _ => "null".to_string(),
+        };
+        let _ = write!(
+            out,
+            "{{\"contexts\": {}, \"async_ops\": {}, \"payloads\": {}, \"fds\": {}, \
+             \"rss_kib\": {}, \"helper_rss_kib\": {}}}",
+            delta(Some(self.live.contexts()), Some(baseline.live.contexts())),
+            delta(Some(self.live.async_ops()), Some(baseline.live.async_ops())),
+            delta(Some(self.live.payloads()), Some(baseline.live.payloads())),
+            delta(self.fds, baseline.fds),
+            delta(self.rss_kib, baseline.rss_kib),
+            delta(self.helper_rss_kib, baseline.helper_rss_kib),
+        );
+    }
+}
+
+fn json_opt(value: Option<u64>) -> String {
+    value.map_or_else(|| "null".to_string(), |value| value.to_string())
+}
+
+#[cfg(any(target_os = "linux", target_os = "android"))]
+fn open_fds() -> Option<u64> {
+    Some(std::fs::read_dir("/proc/self/fd").ok()?.count() as u64)
+}
+
+#[cfg(target_vendor = "apple")]
+fn open_fds() -> Option<u64> {
+    Some(std::fs::read_dir("/dev/fd").ok()?.count() as u64)
+}
+
+#[cfg(not(any(target_os = "linux", target_os = "android", target_vendor = "apple")))]
+fn open_fds() -> Option<u64> {
+    None
+}
+
+#[cfg(any(target_os = "linux", target_os = "android"))]
+fn rss_kib(pid: &str) -> Option<u64> {
+    let status = std::fs::read_to_string(format!("/proc/{pid}/status")).ok()?;
+    let line = status.lines().find(|line| line.starts_with("VmRSS:"))?;
+    line.split_whitespace().nth(1)?.parse().ok()
+}
+
+#[cfg(not(any(target_os = "linux", target_os = "android")))]
+fn rss_kib(_pid: &str) -> Option<u64> {
+    None
+}
+
+/// Summed RSS of Frida helper processes started by this process.
+#[cfg(any(target_os = "linux", target_os = "android"))]
+fn helper_rss_kib() -> Option<u64> {
+    let own = std::process::id().to_string();
+    let mut total = None;
+    for entry in std::fs::read_dir("/proc").ok()?.flatten() {
+        let pid = entry.file_name().to_string_lossy().into_owned();
+        let Ok(stat) = std::fs::read_to_string(format!("/proc/{pid}/stat")) else {
+            continue;
+        };
+        // `pid (comm) state ppid ...`; comm may contain spaces.
+        let Some((comm, rest)) = stat
+            .split_once(" (")
+            .and_then(|(_, rest)| rest.rsplit_once(") "))
+        else {
+            continue;
+        };
+        let parent = rest.split_whitespace().nth(1);
+        if comm.starts_with("frida") && parent == Some(own.as_str()) {
+            *total.get_or_insert(0) += rss_kib(&pid).unwrap_or(0);
+        }
+    }
+    total
+}
+
+#[cfg(not(any(target_os = "linux", target_os = "android")))]
+fn helper_rss_kib() -> Option<u64> {
+    None
+}
+
+/// Phases 1 and 2: inject → uninject against one long-lived target per thread.
+fn inject_phase(
+    name: &'static str,
+    config: &Config,
+    fixtures: &Fixtures,
+    library: &Library,
+) -> Phase {
+    let targets: Vec<Target> = (0..config.threads)
+        .map(|_| spawn_target(fixtures))
+        .collect();
+    let per_thread = config.cycles.div_ceil(config.threads);
+
+    let start = Instant::now();
+    let (inject, uninject) = std::thread::scope(|scope| {
+        let workers: Vec<_> = targets
+            .iter()
+            .map(|target| {
+                let process = target.process;
+                scope.spawn(move || {
+                    let mut inject = Latencies::default();
+                    let mut uninject = Latencies::default();
+                    for _ in 0..per_thread {
+                        if let Some(injected) =
+                            inject.time(|| hook_inject::inject_process(process, library.clone()))
+                        {
+                            uninject.time(|| injected.uninject());
+                        }
+                    }
+                    (inject, uninject)
+                })
+            })
+            .collect();
+        merge_workers(workers.into_iter().map(|worker| worker.join().unwrap()))
+    });
+
+    Phase {
+        name,
+        cycles: per_thread * config.threads,
+        wall: start.elapsed(),
+        ops: vec![("inject", inject), ("uninject", uninject)],
+    }
+}
+
+/// Phase 3: spawn → inject → resume of short-lived targets.
+fn launch_phase(config: &Config, fixtures: &Fixtures, library: &Library) -> Phase {
+    let per_thread = config.launches.div_ceil(config.threads);
+
+    let start = Instant::now();
+    let (spawn, inject_resume) = std::thread::scope(|scope| {
+        let workers: Vec<_> = (0..config.threads)
+            .map(|_| {
+                scope.spawn(move || {
+                    let mut spawn = Latencies::default();
+                    let mut inject_resume = Latencies::default();
+                    for _ in 0..per_thread {
+                        let mut program = Program::new(&fixtures.target);
+                        program.arg("50");
+                        let program = program.stdio(Stdio::Null);
+                        let Some(suspended) = spawn.time(|| hook_inject::spawn(program)) else {
+                            continue;
+                        };
+                        let process = suspended.process();
+                        match inject_resume.time(|| suspended.inject(library.clone())) {
+                            Some(_) => wait_for_exit(process),
+                            // A failed injection can leave the child suspended.
+                            None => kill_and_reap(process),
+                        }
+                    }
+                    (spawn, inject_resume)
+                })
+            })
+            .collect();
+        merge_workers(workers.into_iter().map(|worker| worker.join().unwrap()))
+    });
+
+    Phase {
+        name: "spawn_inject_resume",
+        cycles: per_thread * config.threads,
+        wall: start.elapsed(),
+        ops: vec![("spawn", spawn), ("inject_resume", inject_resume)],
+    }
+}
+
+fn merge_workers(results: impl Iterator<Item = (Latencies, Latencies)>) -> (Latencies, Latencies) {
+    let mut merged = (Latencies::default(), Latencies::default());
+    for (first, second) in results {
+        merged.0.merge(first);
+        merged.1.merge(second);
+    }
+    merged
+}
+
+fn wait_for_exit(process: Process) {
+    // A target that already exited cannot be opened, which is just as good.
+    if let Ok(handle) = process.open() {
+        let _ = handle.wait_timeout(Duration::from_secs(10));
+    }
+}
+
+#[cfg(unix)]
+fn kill_and_reap(process: Process) {
+    let pid = process.pid();
+    unsafe {
+        libc::kill(pid, libc::SIGKILL);
+        if libc::waitpid(pid, std::ptr::null_mut(), 0) == pid {
+            return;
+        }
+    }
+    // Spawned through Frida's helper, which reaps it.
+    wait_for_exit(process);
+}
+
+#[cfg(windows)]
+fn kill_and_reap(process: Process) {
+    let _ = Command::new("taskkill")
+        .args(["/F", "/PID", &process.pid().to_string()])
+        .output();
+    wait_for_exit(process);
+}
+
+fn main() {
+    let root = PathBuf::from(env!("CARGO_MANIFEST_DIR"));
+    let config = Config::from_env(&root);
+    let fixtures = fixtures(&root);
+    // The fixture entrypoint returns at once for empty data, so cycles
+    // measure the injector rather than the agent.
+    let library = Library::from_path(&fixtures.agent)
+        .expect("fixture lib")
+        .with_entrypoint(c"hook_inject_entry");
+    // Blob injections upload a payload each time, which the path phase never
+    // does; this phase is what moves the `payloads` counter.
+    let blob = Library::from_bytes(std::fs::read(&fixtures.agent).expect("read fixture agent"))
+        .expect("blob lib")
+        .with_entrypoint(c"hook_inject_entry");
+
+    // Settle the backend first so start-up allocations are not counted as growth.
+    hook_inject::warm_up().expect("warm up should succeed");
+    {
+        let target = spawn_target(&fixtures);
+        for library in [&library, &blob] {
+            hook_inject::inject_process(target.process, library.clone())
+                .and_then(|injected| injected.uninject())
+                .expect("first injection should succeed");
+        }
+    }
+    let baseline = Resources::sample();
+
+    eprintln!(
+        "soak: {} inject and {} launch cycles on {} threads",
+        config.cycles, config.launches, config.threads
+    );
+    let mut inject = inject_phase("inject_uninject", &config, &fixtures, &library);
+    let after_inject = Resources::sample();
+    eprintln!("soak: {}", inject.summary());
+    let mut blob_inject = inject_phase("blob_inject_uninject", &config, &fixtures, &blob);
+    let after_blob = Resources::sample();
+    eprintln!("soak: {}", blob_inject.summary());
+    let mut launch = launch_phase(&config, &fixtures, &library);
+    let after_launch = Resources::sample();
+    eprintln!("soak: {}", launch.summary());
+
+    let mut out = String::new();
+    let _ = write!(
+        out,
+        "{{\n  \"version\": \"{}\",\n  \"os\": \"{}\",\n  \"arch\": \"{}\",\n  \"timestamp\": {},\n  \
+         \"config\": {{\"cycles\": {}, \"launches\": {}, \"threads\": {}}},\n  \"phases\": {{\n    ",
+        env!("CARGO_PKG_VERSION"),
+        std::env::consts::OS,
+        std::env::consts::ARCH,
+        SystemTime::now()
+            .duration_since(UNIX_EPOCH)
+            .map_or(0, |elapsed| elapsed.as_secs()),
+        config.cycles,
+        config.launches,
+        config.threads,
+    );
+    inject.write_json(&mut out);
+    out.push_str(",\n    ");
+    blob_inject.write_json(&mut out);
+    out.push_str(",\n    ");
+    launch.write_json(&mut out);
+    out.push_str("\n  },\n  \"resources\": {\n    \"baseline\": ");
+    baseline.write_json(&mut out);
+    out.push_str(",\n    \"after_inject_uninject\": ");
+    after_inject.write_json(&mut out);
+    out.push_str(",\n    \"after_blob_inject_uninject\": ");
+    after_blob.write_json(&mut out);
+    out.push_str(",\n    \"after_spawn_inject_resume\": ");
+    after_launch.write_json(&mut out);
+    out.push_str(",\n    \"growth\": ");
+    after_launch.write_growth_json(&baseline, &mut out);
+    out.push_str("\n  }\n}\n");
+
+    if let Some(parent) = config.report.parent() {
+        let _ = std::fs::create_dir_all(parent);
+    }
+    std::fs::write(&config.report, &out).expect("write soak report");
+    eprintln!("soak: report written to {}", config.report.display());
+}
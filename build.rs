@@ -1,7 +1,9 @@
 use std::env;
 use std::path::{Path, PathBuf};
 
-use hook_inject_build::{download_devkit, resolve_devkit_platform, resolve_devkit_versions};
+use hook_inject_build::{
+    fetch_devkit_cached, resolve_devkit_platform, resolve_devkit_versions, shared_devkit_cache_dir,
+};
 
 // === Configuration ===
 const DEFAULT_DEVKIT_VERSION: &str = "17.7.3";
@@ -18,6 +20,8 @@ fn main() {
     println!("cargo:rerun-if-env-changed=HOOK_INJECT_DEVKIT_VERSION");
     println!("cargo:rerun-if-env-changed=HOOK_INJECT_DEVKIT_PLATFORM");
     println!("cargo:rerun-if-env-changed=CARGO_TARGET_DIR");
+    println!("cargo:rerun-if-env-changed=HOOK_INJECT_DEVKIT_CACHE");
+    println!("cargo:rerun-if-env-changed=HOOK_INJECT_DEVKIT_SHA256");
 
     let manifest_dir = PathBuf::from(env::var("CARGO_MANIFEST_DIR").unwrap());
 
@@ -41,7 +45,8 @@ fn main() {
 //=== Devkit download ===
 
 fn try_download_devkit(manifest_dir: &Path) -> Option<PathBuf> {
-    // Download a devkit into target/ and return the resolved directory.
+    // Download a devkit into the shared user cache (or target/ without one)
+    // and return the resolved directory.
     let (versions, allow_fallback) =
         resolve_devkit_versions(DEFAULT_DEVKIT_VERSION, SUPPORTED_DEVKIT_VERSIONS);
     let platform = match resolve_devkit_platform() {
@@ -52,30 +57,25 @@ fn try_download_devkit(manifest_dir: &Path) -> Option<PathBuf> {
         }
     };
 
-    let target_dir = env::var_os("CARGO_TARGET_DIR")
-        .map(PathBuf::from)
-        .unwrap_or_else(|| manifest_dir.join("target"));
-
-    for (idx, version) in versions.iter().enumerate() {
-        let devkit_dir = target_dir
+    let cache_root = shared_devkit_cache_dir().unwrap_or_else(|| {
+        env::var_os("CARGO_TARGET_DIR")
+            .map(PathBuf::from)
+            .unwrap_or_else(|| manifest_dir.join("target"))
             .join("frida-devkit")
-            .join(version)
-            .join(&platform);
+    });
 
-        let mut resolved = find_devkit_dir(&devkit_dir);
-        if resolved.is_none() {
-            match download_devkit(version, &devkit_dir, Some(&platform)) {
-                Ok(_) => {}
-                Err(err) => {
-                    println!("cargo:warning=devkit download failed for {version}: {err}");
-                    if allow_fallback && idx + 1 < versions.len() {
-                        continue;
-                    }
-                    return None;
+    for (idx, version) in versions.iter().enumerate() {
+        let devkit_dir = match fetch_devkit_cached(version, &cache_root, Some(&platform)) {
+            Ok(dir) => dir,
+            Err(err) => {
+                println!("cargo:warning=devkit download failed for {version}: {err}");
+                if allow_fallback && idx + 1 < versions.len() {
+                    continue;
                 }
+                return None;
             }
-            resolved = find_devkit_dir(&devkit_dir);
-        }
+        };
+        let resolved = find_devkit_dir(&devkit_dir);
 
         if resolved.is_none() {
             println!(
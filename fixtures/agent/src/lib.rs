@@ -1,12 +1,20 @@
 use std::ffi::{CStr, c_char};
 use std::fs;
+use std::sync::atomic::{AtomicU32, Ordering};
+
+const SHARED_DATA_PREFIX: &str = "hook-inject-shm:";
+/// `resident:<stamp>` keeps the agent loaded and writes how many times its
+/// entrypoint has run in this process.
+const RESIDENT_PREFIX: &str = "resident:";
+
+static INVOCATIONS: AtomicU32 = AtomicU32::new(0);
 
 /// # Safety
 /// `data` must be a valid NUL-terminated C string pointer.
 #[unsafe(no_mangle)]
 pub unsafe extern "C" fn hook_inject_entry(
     data: *const c_char,
-    _stay_resident: *mut i32,
+    stay_resident: *mut i32,
     _state: *mut core::ffi::c_void,
 ) {
     if data.is_null() {
@@ -15,9 +23,38 @@ pub unsafe extern "C" fn hook_inject_entry(
 
     let data = unsafe { CStr::from_ptr(data) };
     let path = data.to_string_lossy();
+    if let Some(descriptor) = path.strip_prefix(SHARED_DATA_PREFIX) {
+        echo_shared_data(descriptor);
+        return;
+    }
+    if let Some(stamp) = path.strip_prefix(RESIDENT_PREFIX) {
+        if !stay_resident.is_null() {
+            unsafe { *stay_resident = 1 };
+        }
+        let count = INVOCATIONS.fetch_add(1, Ordering::SeqCst) + 1;
+        let _ = fs::write(stamp, count.to_string());
+        return;
+    }
     if path.is_empty() {
         return;
     }
 
     let _ = fs::write(path.as_ref(), b"ok");
 }
+
+/// Shared data holds a stamp path, a NUL, then bytes to write to the stamp.
+fn echo_shared_data(descriptor: &str) {
+    let Some((len, segment)) = descriptor.split_once(':') else {
+        return;
+    };
+    let (Ok(len), Ok(bytes)) = (len.parse::<usize>(), fs::read(segment)) else {
+        return;
+    };
+    let Some(payload) = bytes.get(..len) else {
+        return;
+    };
+    if let Some(split) = payload.iter().position(|&byte| byte == 0) {
+        let stamp = String::from_utf8_lossy(&payload[..split]);
+        let _ = fs::write(stamp.as_ref(), &payload[split + 1..]);
+    }
+}
@@ -0,0 +1,220 @@
+//! On-disk cache of resolved cdylib crates.
+//!
+//! Resolving an agent crate means parsing its Cargo.toml, searching target
+//! directories and possibly running `cargo build`. The resolved [`CdylibInfo`]
+//! is stored under the crate's target directory, keyed by a fingerprint of the
+//! manifest, the source tree and the chosen cdylib (paths, sizes and mtimes),
+//! so an unchanged crate resolves from a single small file.
+
+use std::path::{Path, PathBuf};
+use std::time::UNIX_EPOCH;
+
+use crate::{
+    BuildError, CdylibInfo, Result, build_cdylib, find_cdylib_in_targets, read_cdylib_file,
+    resolve_target_dir,
+};
+
+const CACHE_VERSION: &str = "hook-inject-cdylib-cache v2";
+
+/// Resolve a cdylib crate like [`read_cdylib_file`] + [`build_cdylib`], reusing
+/// the previous result while the crate is unchanged.
+///
+/// # Examples
+/// ```no_run
+/// use hook_inject_build::resolve_cdylib_cached;
+///
+/// let info = resolve_cdylib_cached("path/to/agent-crate").unwrap();
+/// ```
+pub fn resolve_cdylib_cached<P: AsRef<Path>>(crate_path: P) -> Result<CdylibInfo> {
+    let crate_path = crate_path.as_ref();
+    let manifest_path = if crate_path.is_dir() {
+        crate_path.join("Cargo.toml")
+    } else {
+        crate_path.to_path_buf()
+    };
+
+    // Without a manifest there is nothing to key on; let the uncached path
+    // report the error.
+    let Some(crate_dir) = manifest_path.parent().filter(|_| manifest_path.is_file()) else {
+        return resolve_uncached(crate_path);
+    };
+
+    let target_dir = resolve_target_dir(crate_dir);
+    let cache_path = target_dir.join("hook-inject").join(format!(
+        "cdylib-{:016x}.cache",
+        fnv1a(path_bytes(&manifest_path))
+    ));
+
+    if let Some((stored, info)) = load(&cache_path) {
+        // The search must still pick the cached artifact: a newer profile or
+        // target directory may now shadow it.
+        let chosen = info
+            .path
+            .file_name()
+            .and_then(|name| find_cdylib_in_targets(crate_dir, &target_dir, name.to_str()?));
+        if chosen.as_ref() == Some(&info.path)
+            && fingerprint(&manifest_path, crate_dir, &info.path) == Some(stored)
+        {
+            return Ok(info);
+        }
+    }
+
+    let info = resolve_uncached(crate_path)?;
+    // The cache is an optimization; failing to write it is not an error.
+    if let Some(fingerprint) = fingerprint(&manifest_path, crate_dir, &info.path) {
+        let _ = store(&cache_path, fingerprint, &info);
+    }
+    Ok(info)
+}
+
+fn resolve_uncached(crate_path: &Path) -> Result<CdylibInfo> {
+    match read_cdylib_file(crate_path) {
+        Some(result) => result,
+        None => build_cdylib(crate_path),
+    }
+}
+
+/// Hash the manifest, lockfile, build script, every file under `src/` and
+/// the cdylib at `artifact`, or `None` if the cdylib is missing.
+fn fingerprint(manifest_path: &Path, crate_dir: &Path, artifact: &Path) -> Option<u64> {
+    let mut files = vec![
+        manifest_path.to_path_buf(),
+        crate_dir.join("Cargo.lock"),
+        crate_dir.join("build.rs"),
+    ];
+    collect_files(&crate_dir.join("src"), &mut files);
+    files.sort();
+
+    let mut hash = Fnv::new();
+    hash.write(CACHE_VERSION.as_bytes());
+    if let Some(target_dir) = std::env::var_os("CARGO_TARGET_DIR") {
+        hash.write(path_bytes(Path::new(&target_dir)));
+    }
+    for file in files {
+        hash.write(path_bytes(&file));
+        hash.write(&file_stamp(&file).unwrap_or_default());
+    }
+    hash.write(path_bytes(artifact));
+    hash.write(&file_stamp(artifact)?);
+    Some(hash.finish())
+}
+
+fn collect_files(dir: &Path, out: &mut Vec<PathBuf>) {
+    let Ok(entries) = std::fs::read_dir(dir) else {
+        return;
+    };
+    for entry in entries.flatten() {
+        let path = entry.path();
+        match entry.file_type() {
+            Ok(kind) if kind.is_dir() => collect_files(&path, out),
+            Ok(_) => out.push(path),
+            Err(_) => {}
+        }
+    }
+}
+
+/// Size and mtime of a file, or `None` if it does not exist.
+fn file_stamp(path: &Path) -> Option<[u8; 24]> {
+    let meta = std::fs::metadata(path).ok()?;
+    let mtime = meta.modified().ok()?.duration_since(UNIX_EPOCH).ok()?;
+    let mut stamp = [0u8; 24];
+    stamp[..8].copy_from_slice(&meta.len().to_le_bytes());
+    stamp[8..16].copy_from_slice(&mtime.as_secs().to_le_bytes());
+    stamp[16..20].copy_from_slice(&mtime.subsec_nanos().to_le_bytes());
+    Some(stamp)
+}
+
+/// The stored fingerprint and resolution, if the cache file is well formed.
+fn load(cache_path: &Path) -> Option<(u64, CdylibInfo)> {
+    let contents = std::fs::read_to_string(cache_path).ok()?;
+    let mut lines = contents.lines();
+    if lines.next()? != CACHE_VERSION {
+        return None;
+    }
+
+    let mut fingerprint = None;
+    let mut path = None;
+    let mut entrypoint = None;
+    let mut data = None;
+    for line in lines {
+        let (key, value) = line.split_once('=')?;
+        match key {
+            "fingerprint" => fingerprint = u64::from_str_radix(value, 16).ok(),
+            "path" => path = Some(PathBuf::from(value)),
+            "entrypoint" => entrypoint = Some(value.to_string()),
+            "data" => data = Some(value.to_string()),
+            _ => return None,
+        }
+    }
+
+    Some((
+        fingerprint?,
+        CdylibInfo {
+            path: path?,
+            entrypoint,
+            data,
+        },
+    ))
+}
+
+fn store(cache_path: &Path, fingerprint: u64, info: &CdylibInfo) -> Result<()> {
+    let path = info
+        .path
+        .to_str()
+        .ok_or_else(|| BuildError::new("cdylib path is not UTF-8"))?;
+
+    let mut contents = format!("{CACHE_VERSION}\nfingerprint={fingerprint:016x}\npath={path}\n");
+    for (key, value) in [("entrypoint", &info.entrypoint), ("data", &info.data)] {
+        if let Some(value) = value {
+            if value.contains('\n') {
+                return Err(BuildError::new("metadata value contains a newline"));
+            }
+            contents.push_str(&format!("{key}={value}\n"));
+        }
+    }
+
+    let dir = cache_path
+        .parent()
+        .ok_or_else(|| BuildError::new("invalid cache path"))?;
+    std::fs::create_dir_all(dir).map_err(|e| BuildError::new(e.to_string()))?;
+    // Rename into place so concurrent readers never see a partial file.
+    let partial = cache_path.with_extension(format!("partial-{}", std::process::id()));
+    std::fs::write(&partial, contents).map_err(|e| BuildError::new(e.to_string()))?;
+    std::fs::rename(&partial, cache_path).map_err(|e| {
+        let _ = std::fs::remove_file(&partial);
+        BuildError::new(e.to_string())
+    })
+}
+
+fn path_bytes(path: &Path) -> &[u8] {
+    path.as_os_str().as_encoded_bytes()
+}
+
+fn fnv1a(bytes: &[u8]) -> u64 {
+    let mut hash = Fnv::new();
+    hash.write(bytes);
+    hash.finish()
+}
+
+/// FNV-1a; stable across Rust releases, unlike `DefaultHasher`.
+struct Fnv(u64);
+
+impl Fnv {
+    fn new() -> Self {
+        Fnv(0xcbf2_9ce4_8422_2325)
+    }
+
+    fn write(&mut self, bytes: &[u8]) {
+        for &byte in bytes {
+            self.0 ^= byte as u64;
+            self.0 = self.0.wrapping_mul(0x0000_0100_0000_01b3);
+        }
+        // Separate fields so ("ab", "c") and ("a", "bc") differ.
+        self.0 ^= 0xff;
+        self.0 = self.0.wrapping_mul(0x0000_0100_0000_01b3);
+    }
+
+    fn finish(&self) -> u64 {
+        self.0
+    }
+}
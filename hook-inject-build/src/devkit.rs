@@ -1,10 +1,15 @@
 use std::env;
 use std::fs;
+use std::io::{Read, Write};
 use std::path::{Path, PathBuf};
-use std::process::Command;
+use std::process::{Command, Stdio};
 
+use crate::sha256::Sha256;
 use crate::{BuildError, Result};
 
+/// Written last into a cached devkit; its presence means extraction finished.
+const COMPLETE_MARKER: &str = ".hook-inject-complete";
+
 //=== Platform resolution ===
 
 /// Detect the current platform string used by Frida devkit assets.
@@ -140,6 +145,214 @@ fn download_and_extract(url: &str, archive: &Path, out_dir: &Path, ext: &str) ->
     Ok(())
 }
 
+//=== Shared cache ===
+
+/// Resolve the user-level devkit cache shared by all workspaces.
+///
+/// Honors `HOOK_INJECT_DEVKIT_CACHE` (set it to `off` to disable the shared
+/// cache), then `$XDG_CACHE_HOME/hook-inject/devkit`, then the platform cache
+/// directory under the user's home.
+pub fn shared_devkit_cache_dir() -> Option<PathBuf> {
+    if let Some(dir) = env::var_os("HOOK_INJECT_DEVKIT_CACHE") {
+        if dir == "off" {
+            return None;
+        }
+        return Some(PathBuf::from(dir));
+    }
+
+    let base = if let Some(dir) = env::var_os("XDG_CACHE_HOME").filter(|dir| !dir.is_empty()) {
+        PathBuf::from(dir)
+    } else if cfg!(windows) {
+        PathBuf::from(env::var_os("LOCALAPPDATA")?)
+    } else if cfg!(target_os = "macos") {
+        PathBuf::from(env::var_os("HOME")?)
+            .join("Library")
+            .join("Caches")
+    } else {
+        PathBuf::from(env::var_os("HOME")?).join(".cache")
+    };
+    Some(base.join("hook-inject").join("devkit"))
+}
+
+/// Fetch a devkit into `cache_root/<version>/<platform>`, reusing a complete
+/// copy if one is already there.
+///
+/// Safe to call from concurrent builds: a lock file serializes downloads of
+/// the same version/platform, and the extracted tree only appears under its
+/// final name once complete. The archive is extracted while it streams in, and
+/// its SHA-256 is checked against `HOOK_INJECT_DEVKIT_SHA256` when set. The
+/// digest is recorded in the cache, so a later run with a different expected
+/// checksum downloads again.
+pub fn fetch_devkit_cached<P: AsRef<Path>>(
+    version: &str,
+    cache_root: P,
+    platform: Option<&str>,
+) -> Result<PathBuf> {
+    let platform = match platform {
+        Some(p) => p.to_string(),
+        None => detect_devkit_platform()?,
+    };
+    let expected = env::var("HOOK_INJECT_DEVKIT_SHA256")
+        .ok()
+        .map(|sum| sum.trim().to_ascii_lowercase());
+
+    let version_dir = cache_root.as_ref().join(version);
+    let devkit_dir = version_dir.join(&platform);
+    if cached_digest_matches(&devkit_dir, expected.as_deref()) {
+        return Ok(devkit_dir);
+    }
+
+    fs::create_dir_all(&version_dir)
+        .map_err(|e| BuildError::new(format!("failed to create devkit cache: {e}")))?;
+    let lock = fs::File::create(version_dir.join(format!("{platform}.lock")))
+        .map_err(|e| BuildError::new(format!("failed to create devkit lock: {e}")))?;
+    lock.lock()
+        .map_err(|e| BuildError::new(format!("failed to lock devkit cache: {e}")))?;
+
+    // Another build may have finished while we waited for the lock.
+    if cached_digest_matches(&devkit_dir, expected.as_deref()) {
+        return Ok(devkit_dir);
+    }
+
+    let staging = version_dir.join(format!("{platform}.partial-{}", std::process::id()));
+    let _ = fs::remove_dir_all(&staging);
+    fs::create_dir_all(&staging)
+        .map_err(|e| BuildError::new(format!("failed to create devkit staging dir: {e}")))?;
+
+    let result = fetch_into(version, &platform, &staging).and_then(|digest| {
+        if let Some(expected) = &expected
+            && *expected != digest
+        {
+            return Err(BuildError::new(format!(
+                "devkit checksum mismatch: expected {expected}, got {digest}"
+            )));
+        }
+        fs::write(staging.join(COMPLETE_MARKER), &digest)
+            .map_err(|e| BuildError::new(format!("failed to mark devkit complete: {e}")))?;
+
+        let _ = fs::remove_dir_all(&devkit_dir);
+        fs::rename(&staging, &devkit_dir)
+            .map_err(|e| BuildError::new(format!("failed to publish devkit: {e}")))
+    });
+    if result.is_err() {
+        let _ = fs::remove_dir_all(&staging);
+    }
+    result.map(|()| devkit_dir)
+}
+
+fn cached_digest_matches(devkit_dir: &Path, expected: Option<&str>) -> bool {
+    match fs::read_to_string(devkit_dir.join(COMPLETE_MARKER)) {
+        Ok(digest) => expected.is_none_or(|expected| digest.trim() == expected),
+        Err(_) => false,
+    }
+}
+
+/// Download and extract the devkit into `out_dir`; returns the archive digest.
+fn fetch_into(version: &str, platform: &str, out_dir: &Path) -> Result<String> {
+    let extensions: &[&str] = if platform.starts_with("windows-") {
+        &["tar.xz", "zip"]
+    } else {
+        &["tar.xz"]
+    };
+
+    let mut last_error = None;
+    for ext in extensions {
+        let filename = format!("frida-core-devkit-{version}-{platform}.{ext}");
+        let url = format!("https://github.com/frida/frida/releases/download/{version}/{filename}");
+        let result = if *ext == "zip" {
+            // Expand-Archive needs a seekable file, so zips land on disk first.
+            let archive = out_dir.join(&filename);
+            download_and_extract(&url, &archive, out_dir, ext).and_then(|()| {
+                let digest = hash_file(&archive);
+                let _ = fs::remove_file(&archive);
+                digest
+            })
+        } else {
+            stream_and_extract(&url, out_dir)
+        };
+        match result {
+            Ok(digest) => return Ok(digest),
+            Err(err) => last_error = Some(err),
+        }
+    }
+
+    Err(last_error
+        .unwrap_or_else(|| BuildError::new("failed to download devkit archive (no candidates)")))
+}
+
+/// Pipe `curl` into `tar`, hashing the archive on the way through.
+fn stream_and_extract(url: &str, out_dir: &Path) -> Result<String> {
+    let mut curl = Command::new("curl")
+        .args(["-fsSL", url])
+        .stdout(Stdio::piped())
+        .spawn()
+        .map_err(|e| BuildError::new(format!("failed to run curl: {e}")))?;
+    let mut tar = match Command::new("tar")
+        .args(["-xJf", "-", "-C"])
+        .arg(out_dir)
+        .stdin(Stdio::piped())
+        .spawn()
+    {
+        Ok(tar) => tar,
+        Err(e) => {
+            let _ = curl.kill();
+            let _ = curl.wait();
+            return Err(BuildError::new(format!("failed to run tar: {e}")));
+        }
+    };
+
+    let mut hasher = Sha256::new();
+    let copied = {
+        let mut source = curl.stdout.take().expect("curl stdout is piped");
+        let mut sink = tar.stdin.take().expect("tar stdin is piped");
+        let mut buf = vec![0u8; 64 * 1024];
+        loop {
+            match source.read(&mut buf) {
+                Ok(0) => break Ok(()),
+                Ok(n) => {
+                    hasher.update(&buf[..n]);
+                    if let Err(e) = sink.write_all(&buf[..n]) {
+                        break Err(e);
+                    }
+                }
+                Err(e) => break Err(e),
+            }
+        }
+        // Dropping `sink` closes tar's stdin so it can finish.
+    };
+
+    let curl_status = curl.wait();
+    let tar_status = tar.wait();
+    copied.map_err(|e| BuildError::new(format!("devkit stream failed: {e}")))?;
+    for (name, status) in [("curl", curl_status), ("tar", tar_status)] {
+        let status =
+            status.map_err(|e| BuildError::new(format!("failed to wait for {name}: {e}")))?;
+        if !status.success() {
+            return Err(BuildError::new(format!(
+                "{name} failed ({status}) for {url}"
+            )));
+        }
+    }
+
+    Ok(hasher.finish_hex())
+}
+
+fn hash_file(path: &Path) -> Result<String> {
+    let mut file = fs::File::open(path)
+        .map_err(|e| BuildError::new(format!("failed to open devkit archive: {e}")))?;
+    let mut hasher = Sha256::new();
+    let mut buf = vec![0u8; 64 * 1024];
+    loop {
+        let n = file
+            .read(&mut buf)
+            .map_err(|e| BuildError::new(format!("failed to read devkit archive: {e}")))?;
+        if n == 0 {
+            return Ok(hasher.finish_hex());
+        }
+        hasher.update(&buf[..n]);
+    }
+}
+
 fn run(cmd: &mut Command) -> Result<()> {
     let status = cmd
         .status()
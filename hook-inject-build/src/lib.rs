@@ -1,12 +1,18 @@
 use std::path::{Path, PathBuf};
 use std::process::Command;
 
+mod cache;
 #[cfg(feature = "download-devkit")]
 mod devkit;
+#[doc(hidden)]
+pub mod sha256;
+
+pub use cache::resolve_cdylib_cached;
 
 #[cfg(feature = "download-devkit")]
 pub use devkit::{
-    detect_devkit_platform, download_devkit, resolve_devkit_platform, resolve_devkit_versions,
+    detect_devkit_platform, download_devkit, fetch_devkit_cached, resolve_devkit_platform,
+    resolve_devkit_versions, shared_devkit_cache_dir,
 };
 
 #[cfg(feature = "build-utils")]
@@ -26,3 +26,45 @@ fn library_filename_formats() {
         assert_eq!(name, "libfoo_bar.so");
     }
 }
+
+#[test]
+fn cached_resolution_matches_and_tracks_changes() {
+    use hook_inject_build::resolve_cdylib_cached;
+
+    let dir = std::env::temp_dir().join(format!("hook-inject-cache-{}", std::process::id()));
+    let _ = std::fs::remove_dir_all(&dir);
+    std::fs::create_dir_all(dir.join("src")).expect("create crate dir");
+    std::fs::write(
+        dir.join("Cargo.toml"),
+        "[package]\nname = \"cache-probe\"\nversion = \"0.1.0\"\n\n\
+         [package.metadata.hook-inject]\ndata = \"one\"\n\n[lib]\ncrate-type = [\"cdylib\"]\n",
+    )
+    .expect("write manifest");
+    std::fs::write(dir.join("src/lib.rs"), "").expect("write source");
+    let built = dir
+        .join("target/debug")
+        .join(library_filename("cache-probe"));
+    std::fs::create_dir_all(built.parent().unwrap()).expect("create target dir");
+    std::fs::write(&built, b"stub").expect("write cdylib");
+
+    let first = resolve_cdylib_cached(&dir).expect("first resolution");
+    assert_eq!(first.path, built);
+    assert_eq!(first.data.as_deref(), Some("one"));
+
+    let second = resolve_cdylib_cached(&dir).expect("cached resolution");
+    assert_eq!(second.path, first.path);
+    assert_eq!(second.data, first.data);
+
+    // Changing the manifest invalidates the entry.
+    std::thread::sleep(std::time::Duration::from_millis(20));
+    std::fs::write(
+        dir.join("Cargo.toml"),
+        "[package]\nname = \"cache-probe\"\nversion = \"0.1.0\"\n\n\
+         [package.metadata.hook-inject]\ndata = \"two\"\n\n[lib]\ncrate-type = [\"cdylib\"]\n",
+    )
+    .expect("rewrite manifest");
+    let third = resolve_cdylib_cached(&dir).expect("re-resolution");
+    assert_eq!(third.data.as_deref(), Some("two"));
+
+    let _ = std::fs::remove_dir_all(&dir);
+}
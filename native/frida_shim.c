@@ -3,17 +3,65 @@
 #include <frida-core.h>
 #include <stdlib.h>
 #include <string.h>
+#if defined(__linux__)
+# include <fcntl.h>
+# include <sys/stat.h>
+# include <unistd.h>
+#elif defined(__APPLE__)
+# include <libproc.h>
+# include <sys/proc_info.h>
+#endif
 
 // Context owned by the Rust side; wraps Frida device + injector handles.
 struct HookFridaCtx {
+  // One reference for the Rust owner (dropped by hook_frida_free) plus one
+  // per in-flight async operation, whose callbacks still use the context.
+  gint ref_count;
+  // The manager and device are created on first use (see hook_device);
+  // device_lock guards their creation, the signal handlers and the
+  // forwarding callbacks below.
+  GMutex device_lock;
   FridaDeviceManager * manager;
   FridaDevice * device;
+  // Which device `device` is (see hook_frida_new_device).
+  HookFridaDeviceKind device_kind;
+  gchar * device_address;
+  gint device_timeout;
+  // Devices replaced after their connection was lost. Other threads may
+  // still hold their pointers, so they live as long as the context.
+  GPtrArray * lost_devices;
+  // NULL for non-local devices, whose injections all use the device path.
   FridaInjector * injector;
+  // Injection strategy cache: HookTargetKey -> HookStrategy.
+  GMutex strategy_lock;
+  GHashTable * strategies;
+  HookFridaStartupStats startup;
+  // HOOK_INJECT_INJECTOR=device: start every injection on the device path.
+  gboolean prefer_device;
+  // "uninjected" forwarding; signal ids are 0 while disconnected.
+  HookFridaUninjected uninjected;
+  void * uninjected_data;
+  gulong injector_uninjected_id;
+  gulong device_uninjected_id;
+  // "output" forwarding for children spawned with piped stdio.
+  HookFridaOutput output;
+  void * output_data;
+  gulong device_output_id;
+  // Child gating: pid -> FridaSession with gating enabled.
+  GMutex gating_lock;
+  GHashTable * gated;
+  HookFridaChildEvent child;
+  void * child_data;
+  gulong device_child_added_id;
 };
 
 static gboolean
 hook_debug_enabled(void) {
-  return getenv("HOOK_INJECT_DEBUG") != NULL;
+  // Read the environment once; 1 = disabled, 2 = enabled.
+  static gsize state = 0;
+  if (g_once_init_enter(&state))
+    g_once_init_leave(&state, getenv("HOOK_INJECT_DEBUG") != NULL ? 2 : 1);
+  return state == 2;
 }
 
 static void
@@ -27,6 +75,9 @@ static HookFridaErrorKind hook_error_kind_from_gerror(GError * err) {
   if (err == NULL)
     return HOOK_FRIDA_ERROR_RUNTIME;
 
+  if (g_error_matches(err, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+    return HOOK_FRIDA_ERROR_CANCELLED;
+
   if (g_error_matches(err, FRIDA_ERROR, FRIDA_ERROR_INVALID_ARGUMENT))
     return HOOK_FRIDA_ERROR_INVALID_ARGUMENT;
   if (g_error_matches(err, FRIDA_ERROR, FRIDA_ERROR_PERMISSION_DENIED))
@@ -41,6 +92,35 @@ static HookFridaErrorKind hook_error_kind_from_gerror(GError * err) {
   return HOOK_FRIDA_ERROR_RUNTIME;
 }
 
+// HookFridaCancellable is a GCancellable under an opaque name.
+static GCancellable *
+hook_cancellable(HookFridaCancellable * cancellable) {
+  return (GCancellable *) cancellable;
+}
+
+HookFridaCancellable *
+hook_frida_cancellable_new(void) {
+  return (HookFridaCancellable *) g_cancellable_new();
+}
+
+void
+hook_frida_cancellable_cancel(HookFridaCancellable * cancellable) {
+  // Thread-safe; pending calls fail once their main-context callback runs.
+  if (cancellable != NULL)
+    g_cancellable_cancel(hook_cancellable(cancellable));
+}
+
+int
+hook_frida_cancellable_is_cancelled(HookFridaCancellable * cancellable) {
+  return cancellable != NULL && g_cancellable_is_cancelled(hook_cancellable(cancellable));
+}
+
+void
+hook_frida_cancellable_free(HookFridaCancellable * cancellable) {
+  if (cancellable != NULL)
+    g_object_unref(cancellable);
+}
+
 // Store an error kind + a copied message for the Rust side.
 static void hook_set_error(GError * err, int32_t * error_kind_out, char ** error_out) {
   if (error_kind_out != NULL) {
@@ -70,15 +150,493 @@ hook_should_try_device_fallback(GError * err) {
       g_error_matches(err, FRIDA_ERROR, FRIDA_ERROR_PERMISSION_DENIED);
 }
 
+// === Injection strategy cache ===
+// Remembers which injection path last worked for a target uid/architecture so
+// later injections skip a doomed first attempt. The platform is fixed per
+// context (one device), so it is implied by the cache itself.
+
+// Every Nth injection served by a cached device path re-probes the injector.
+#define HOOK_STRATEGY_REPROBE_INTERVAL 64
+
+typedef struct {
+  guint uid;
+  guint arch;
+} HookTargetKey;
+
+typedef struct {
+  HookFridaPath path;
+  guint uses;
+} HookStrategy;
+
+static guint
+hook_target_key_hash(gconstpointer p) {
+  const HookTargetKey * key = p;
+  return key->uid * 31u + key->arch;
+}
+
+static gboolean
+hook_target_key_equal(gconstpointer a, gconstpointer b) {
+  const HookTargetKey * ka = a;
+  const HookTargetKey * kb = b;
+  return ka->uid == kb->uid && ka->arch == kb->arch;
+}
+
+static HookTargetKey
+hook_target_key(HookFridaCtx * ctx, guint pid) {
+  // Unknown fields stay at their defaults, so unprobeable targets share a slot.
+  HookTargetKey key = { G_MAXUINT, 0 };
+  // Pids of other devices say nothing about local processes.
+  if (ctx->device_kind != HOOK_FRIDA_DEVICE_LOCAL)
+    return key;
+#if defined(__linux__)
+  char path[64];
+  struct stat st;
+  g_snprintf(path, sizeof(path), "/proc/%u", pid);
+  if (stat(path, &st) == 0)
+    key.uid = (guint) st.st_uid;
+
+  // ELF class + machine identify the target architecture.
+  g_snprintf(path, sizeof(path), "/proc/%u/exe", pid);
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd >= 0) {
+    guint8 header[20];
+    if (read(fd, header, sizeof(header)) == (ssize_t) sizeof(header) &&
+        memcmp(header, "\177ELF", 4) == 0) {
+      guint machine = (header[5] == 2)
+          ? ((guint) header[18] << 8) | header[19]
+          : ((guint) header[19] << 8) | header[18];
+      key.arch = ((guint) header[4] << 16) | machine;
+    }
+    close(fd);
+  }
+#elif defined(__APPLE__)
+  struct proc_bsdinfo info;
+  if (proc_pidinfo((int) pid, PROC_PIDTBSDINFO, 0, &info, sizeof(info)) == (int) sizeof(info)) {
+    key.uid = info.pbi_uid;
+    key.arch = (info.pbi_flags & PROC_FLAG_LP64) ? 64 : 32;
+  }
+#endif
+  return key;
+}
+
+static uint64_t
+hook_elapsed_us(gint64 * since) {
+  // Return the time since `*since` and restart the clock.
+  gint64 now = g_get_monotonic_time();
+  uint64_t elapsed = (uint64_t) (now - *since);
+  *since = now;
+  return elapsed;
+}
+
+static void hook_device_connect_signals(HookFridaCtx * ctx);
+
+static FridaDeviceManager *
+hook_device_manager(HookFridaCtx * ctx) {
+  g_mutex_lock(&ctx->device_lock);
+  if (ctx->manager == NULL) {
+    ctx->manager = frida_device_manager_new();
+    hook_debug("hook-frida: device manager created");
+  }
+  FridaDeviceManager * manager = ctx->manager;
+  g_mutex_unlock(&ctx->device_lock);
+  return manager;
+}
+
+static FridaDevice *
+hook_device_current(HookFridaCtx * ctx) {
+  // The published device, unless there is none yet or its connection was lost.
+  FridaDevice * device = g_atomic_pointer_get(&ctx->device);
+  return (device != NULL && !frida_device_is_lost(device)) ? device : NULL;
+}
+
+static void
+hook_device_retire(HookFridaCtx * ctx) {
+  // Disconnect the handlers of a lost device so they can move to its
+  // replacement. Called with device_lock held.
+  gulong * ids[] = {
+    &ctx->device_uninjected_id, &ctx->device_output_id, &ctx->device_child_added_id
+  };
+  for (gsize i = 0; i != G_N_ELEMENTS(ids); i++) {
+    if (*ids[i] != 0) {
+      g_signal_handler_disconnect(ctx->device, *ids[i]);
+      *ids[i] = 0;
+    }
+  }
+  g_ptr_array_add(ctx->lost_devices, ctx->device);
+  hook_debug("hook-frida: device connection lost, replacing it");
+}
+
+static FridaDevice *
+hook_device_adopt(HookFridaCtx * ctx, FridaDevice * device, uint64_t lookup_us) {
+  // Publish a looked-up device (taking its reference) unless another lookup
+  // won the race, and connect the handlers registered before it existed.
+  // A lost device is swapped out, never cleared, so readers always see one.
+  g_mutex_lock(&ctx->device_lock);
+  if (ctx->device == NULL || frida_device_is_lost(ctx->device)) {
+    if (ctx->device != NULL)
+      hook_device_retire(ctx);
+    ctx->startup.device_lookup_us = lookup_us;
+    g_atomic_pointer_set(&ctx->device, device);
+    hook_device_connect_signals(ctx);
+  } else {
+    g_object_unref(device);
+  }
+  FridaDevice * current = ctx->device;
+  g_mutex_unlock(&ctx->device_lock);
+  return current;
+}
+
+static FridaDevice *
+hook_device_lookup_sync(HookFridaCtx * ctx, FridaDeviceManager * manager, GError ** error) {
+  switch (ctx->device_kind) {
+    case HOOK_FRIDA_DEVICE_REMOTE: {
+      FridaRemoteDeviceOptions * options = frida_remote_device_options_new();
+      FridaDevice * device = frida_device_manager_add_remote_device_sync(manager,
+          ctx->device_address, options, NULL, error);
+      g_object_unref(options);
+      return device;
+    }
+    case HOOK_FRIDA_DEVICE_USB:
+      return frida_device_manager_get_device_by_type_sync(manager, FRIDA_DEVICE_TYPE_USB,
+          ctx->device_timeout, NULL, error);
+    case HOOK_FRIDA_DEVICE_ID:
+      return frida_device_manager_get_device_by_id_sync(manager, ctx->device_address,
+          ctx->device_timeout, NULL, error);
+    case HOOK_FRIDA_DEVICE_LOCAL:
+      break;
+  }
+  return frida_device_manager_get_device_by_type_sync(manager, FRIDA_DEVICE_TYPE_LOCAL, 0, NULL,
+      error);
+}
+
+static void
+hook_device_lookup_async(HookFridaCtx * ctx, GAsyncReadyCallback callback, gpointer user_data) {
+  FridaDeviceManager * manager = hook_device_manager(ctx);
+  switch (ctx->device_kind) {
+    case HOOK_FRIDA_DEVICE_REMOTE: {
+      FridaRemoteDeviceOptions * options = frida_remote_device_options_new();
+      frida_device_manager_add_remote_device(manager, ctx->device_address, options, NULL,
+          callback, user_data);
+      g_object_unref(options);
+      return;
+    }
+    case HOOK_FRIDA_DEVICE_USB:
+      frida_device_manager_get_device_by_type(manager, FRIDA_DEVICE_TYPE_USB,
+          ctx->device_timeout, NULL, callback, user_data);
+      return;
+    case HOOK_FRIDA_DEVICE_ID:
+      frida_device_manager_get_device_by_id(manager, ctx->device_address, ctx->device_timeout,
+          NULL, callback, user_data);
+      return;
+    case HOOK_FRIDA_DEVICE_LOCAL:
+      break;
+  }
+  frida_device_manager_get_device_by_type(manager, FRIDA_DEVICE_TYPE_LOCAL, 0, NULL, callback,
+      user_data);
+}
+
+static FridaDevice *
+hook_device_lookup_finish(HookFridaCtx * ctx, GAsyncResult * res, GError ** error) {
+  switch (ctx->device_kind) {
+    case HOOK_FRIDA_DEVICE_REMOTE:
+      return frida_device_manager_add_remote_device_finish(ctx->manager, res, error);
+    case HOOK_FRIDA_DEVICE_ID:
+      return frida_device_manager_get_device_by_id_finish(ctx->manager, res, error);
+    case HOOK_FRIDA_DEVICE_LOCAL:
+    case HOOK_FRIDA_DEVICE_USB:
+      break;
+  }
+  return frida_device_manager_get_device_by_type_finish(ctx->manager, res, error);
+}
+
+static FridaDevice *
+hook_device_timed(HookFridaCtx * ctx, uint64_t * lookup_us, GError ** error) {
+  // Look up the device on first use, and again once its connection is lost;
+  // a failed lookup is retried by the next caller. Blocks, so never call
+  // this from Frida's main context. Time spent looking up is added to
+  // `*lookup_us` when given.
+  FridaDevice * device = hook_device_current(ctx);
+  if (device != NULL)
+    return device;
+
+  // The lookup needs the main loop, so it must not run under device_lock.
+  FridaDeviceManager * manager = hook_device_manager(ctx);
+  gint64 clock = g_get_monotonic_time();
+  device = hook_device_lookup_sync(ctx, manager, error);
+  uint64_t elapsed = hook_elapsed_us(&clock);
+  hook_debug("hook-frida: device lookup finished");
+  if (lookup_us != NULL)
+    *lookup_us += elapsed;
+  if (device == NULL)
+    return NULL;
+
+  return hook_device_adopt(ctx, device, elapsed);
+}
+
+static FridaDevice *
+hook_device(HookFridaCtx * ctx, GError ** error) {
+  return hook_device_timed(ctx, NULL, error);
+}
+
+static int
+hook_require_device_timed(HookFridaCtx * ctx,
+    uint64_t * lookup_us,
+    int32_t * error_kind_out,
+    char ** error_out) {
+  GError * error = NULL;
+  if (hook_device_timed(ctx, lookup_us, &error) != NULL)
+    return 1;
+
+  hook_set_error(error, error_kind_out, error_out);
+  g_clear_error(&error);
+  return 0;
+}
+
+static int
+hook_require_device(HookFridaCtx * ctx, int32_t * error_kind_out, char ** error_out) {
+  return hook_require_device_timed(ctx, NULL, error_kind_out, error_out);
+}
+
+static gboolean
+hook_path_available(HookFridaCtx * ctx, HookFridaPath path) {
+  // The device is looked up on first use, so its path is always worth a try;
+  // a failed lookup is reported as that attempt's error.
+  return (path == HOOK_FRIDA_PATH_DEVICE) ? TRUE : ctx->injector != NULL;
+}
+
+static HookFridaPath
+hook_path_other(HookFridaPath path) {
+  return (path == HOOK_FRIDA_PATH_DEVICE) ? HOOK_FRIDA_PATH_INJECTOR : HOOK_FRIDA_PATH_DEVICE;
+}
+
+static HookFridaPath
+hook_strategy_choose(HookFridaCtx * ctx, const HookTargetKey * key) {
+  HookFridaPath path = HOOK_FRIDA_PATH_INJECTOR;
+
+  if (ctx->prefer_device && hook_path_available(ctx, HOOK_FRIDA_PATH_DEVICE))
+    return HOOK_FRIDA_PATH_DEVICE;
+
+  g_mutex_lock(&ctx->strategy_lock);
+  HookStrategy * strategy = g_hash_table_lookup(ctx->strategies, key);
+  if (strategy != NULL && strategy->path == HOOK_FRIDA_PATH_DEVICE) {
+    strategy->uses++;
+    if (strategy->uses % HOOK_STRATEGY_REPROBE_INTERVAL != 0)
+      path = HOOK_FRIDA_PATH_DEVICE;
+  }
+  g_mutex_unlock(&ctx->strategy_lock);
+
+  if (!hook_path_available(ctx, path))
+    path = hook_path_other(path);
+  if (path == HOOK_FRIDA_PATH_DEVICE)
+    hook_debug("hook-frida: using cached device injection path");
+  return path;
+}
+
+static void
+hook_strategy_record(HookFridaCtx * ctx, const HookTargetKey * key, HookFridaPath path) {
+  // The injector is the default, so only a device preference needs an entry.
+  g_mutex_lock(&ctx->strategy_lock);
+  if (path == HOOK_FRIDA_PATH_INJECTOR) {
+    g_hash_table_remove(ctx->strategies, key);
+  } else if (g_hash_table_lookup(ctx->strategies, key) == NULL) {
+    HookStrategy * strategy = g_new0(HookStrategy, 1);
+    strategy->path = path;
+    g_hash_table_insert(ctx->strategies, g_memdup2(key, sizeof(*key)), strategy);
+  }
+  g_mutex_unlock(&ctx->strategy_lock);
+}
+
+static guint
+hook_inject_via(HookFridaCtx * ctx,
+    HookFridaPath path,
+    guint pid,
+    const char * library_path,
+    GBytes * blob,
+    const char * entrypoint,
+    const char * data,
+    uint64_t * lookup_us,
+    GCancellable * cancellable,
+    GError ** error) {
+  if (path == HOOK_FRIDA_PATH_DEVICE) {
+    if (hook_device_timed(ctx, lookup_us, error) == NULL)
+      return 0;
+    if (blob != NULL)
+      return frida_device_inject_library_blob_sync(ctx->device, pid, blob, entrypoint, data,
+          cancellable, error);
+    return frida_device_inject_library_file_sync(ctx->device, pid, library_path, entrypoint,
+        data, cancellable, error);
+  }
+
+  if (blob != NULL)
+    return frida_injector_inject_library_blob_sync(ctx->injector, pid, blob, entrypoint, data,
+        cancellable, error);
+  return frida_injector_inject_library_file_sync(ctx->injector, pid, library_path, entrypoint,
+      data, cancellable, error);
+}
+
+
+static guint
+hook_inject_sync(HookFridaCtx * ctx,
+    guint pid,
+    const char * library_path,
+    GBytes * blob,
+    const char * entrypoint,
+    const char * data,
+    HookFridaPath * path_out,
+    HookFridaOpStats * stats,
+    GCancellable * cancellable,
+    GError ** error) {
+  // Try the cached path first and fall back to the other one on
+  // NOT_SUPPORTED/PERMISSION_DENIED, remembering whichever succeeded.
+  gint64 clock = (stats != NULL) ? g_get_monotonic_time() : 0;
+  uint64_t * lookup_us = (stats != NULL) ? &stats->device_lookup_us : NULL;
+  HookTargetKey key = hook_target_key(ctx, pid);
+  HookFridaPath path = hook_strategy_choose(ctx, &key);
+  GError * attempt_error = NULL;
+  guint id = hook_inject_via(ctx, path, pid, library_path, blob, entrypoint, data, lookup_us,
+      cancellable, &attempt_error);
+  if (stats != NULL) {
+    stats->inject_us = hook_elapsed_us(&clock);
+    stats->payload_len = (blob != NULL) ? g_bytes_get_size(blob) : 0;
+    stats->path = path;
+  }
+
+  if (attempt_error != NULL && hook_should_try_device_fallback(attempt_error) &&
+      hook_path_available(ctx, hook_path_other(path))) {
+    hook_debug(path == HOOK_FRIDA_PATH_INJECTOR
+        ? "hook-frida: injector failed, trying device fallback"
+        : "hook-frida: cached device path failed, trying injector");
+    g_error_free(attempt_error);
+    attempt_error = NULL;
+    path = hook_path_other(path);
+    id = hook_inject_via(ctx, path, pid, library_path, blob, entrypoint, data, lookup_us,
+        cancellable, &attempt_error);
+    if (stats != NULL) {
+      stats->fallback_us = hook_elapsed_us(&clock);
+      stats->path = path;
+      stats->fell_back = 1;
+    }
+  }
+
+  if (attempt_error != NULL) {
+    g_propagate_error(error, attempt_error);
+    return 0;
+  }
+
+  hook_strategy_record(ctx, &key, path);
+  if (path_out != NULL)
+    *path_out = path;
+  return id;
+}
+
+// Wrap a caller-owned blob in GBytes without copying its contents.
+static GBytes *
+hook_blob_bytes_new(const HookFridaBlob * blob) {
+  if (blob == NULL)
+    return NULL;
+  if (blob->release == NULL)
+    return g_bytes_new(blob->data, blob->len);
+  return g_bytes_new_with_free_func(blob->data, blob->len, blob->release, blob->owner);
+}
+
+// Build spawn options from the NULL-terminated argv/envp arrays Rust hands us.
+static FridaSpawnOptions *
+hook_spawn_options_new(const char * const * argv,
+    const char * const * envp,
+    const char * cwd,
+    int32_t stdio) {
+  FridaSpawnOptions * options = frida_spawn_options_new();
+  if (argv != NULL)
+    g_object_set(options, "argv", argv, NULL);
+  if (envp != NULL)
+    g_object_set(options, "envp", envp, NULL);
+  if (cwd != NULL)
+    g_object_set(options, "cwd", cwd, NULL);
+  FridaStdio mode = (stdio == HOOK_FRIDA_STDIO_INHERIT) ? FRIDA_STDIO_INHERIT : FRIDA_STDIO_PIPE;
+  g_object_set(options, "stdio", mode, NULL);
+  // Only PIPE children are announced to the output handler; see hook_spawned.
+  g_object_set_data(G_OBJECT(options), "hook-piped",
+      GINT_TO_POINTER(stdio == HOOK_FRIDA_STDIO_PIPE));
+  return options;
+}
+
+// Announce a child spawned with HOOK_FRIDA_STDIO_PIPE before it can write.
+static void
+hook_spawned(HookFridaCtx * ctx, guint pid, FridaSpawnOptions * options) {
+  if (!GPOINTER_TO_INT(g_object_get_data(G_OBJECT(options), "hook-piped")))
+    return;
+
+  // The lock keeps the handler from being cleared while it runs.
+  g_mutex_lock(&ctx->device_lock);
+  if (ctx->output != NULL)
+    ctx->output(ctx->output_data, pid, 0, NULL, 0);
+  g_mutex_unlock(&ctx->device_lock);
+}
+
+// Live contexts, for hook_frida_live_counts only. Frida is never shut down:
+// frida_init runs once per process, so a shut-down runtime could not be
+// brought back for contexts created later.
+static gint hook_frida_live_contexts = 0;
+// Live HookAsyncOps (see hook_async_op_new).
+static gint hook_frida_live_async_ops = 0;
+
+void
+hook_frida_live_counts(HookFridaLiveCounts * out) {
+  if (out == NULL)
+    return;
+  out->contexts = (uint64_t) g_atomic_int_get(&hook_frida_live_contexts);
+  out->async_ops = (uint64_t) g_atomic_int_get(&hook_frida_live_async_ops);
+}
+
 HookFridaCtx *
 hook_frida_new(int32_t * error_kind_out, char ** error_out) {
-  // Initialize Frida and create a local-device injector.
+  return hook_frida_new_device(HOOK_FRIDA_DEVICE_LOCAL, NULL, 0, error_kind_out, error_out);
+}
+
+HookFridaCtx *
+hook_frida_new_device(int32_t kind,
+    const char * address,
+    int32_t timeout_ms,
+    int32_t * error_kind_out,
+    char ** error_out) {
+  // Initialize Frida and, for the local device, create an injector; the
+  // device is looked up on first use, so injection-only callers never wait
+  // for it.
+  gboolean wants_address = kind == HOOK_FRIDA_DEVICE_REMOTE || kind == HOOK_FRIDA_DEVICE_ID;
+  if (kind < HOOK_FRIDA_DEVICE_LOCAL || kind > HOOK_FRIDA_DEVICE_ID ||
+      wants_address != (address != NULL)) {
+    if (error_kind_out != NULL)
+      *error_kind_out = HOOK_FRIDA_ERROR_INVALID_ARGUMENT;
+    if (error_out != NULL)
+      *error_out = g_strdup("invalid device kind or address");
+    return NULL;
+  }
+
+  gint64 clock = g_get_monotonic_time();
   frida_init();
+  g_atomic_int_inc(&hook_frida_live_contexts);
   hook_debug("hook-frida: frida_init done");
+  uint64_t frida_init_us = hook_elapsed_us(&clock);
 
   HookFridaCtx * ctx = g_new0(HookFridaCtx, 1);
-  ctx->manager = frida_device_manager_new();
-  hook_debug("hook-frida: device manager created");
+  ctx->ref_count = 1;
+  ctx->startup.frida_init_us = frida_init_us;
+  g_mutex_init(&ctx->device_lock);
+  g_mutex_init(&ctx->strategy_lock);
+  ctx->strategies = g_hash_table_new_full(hook_target_key_hash, hook_target_key_equal, g_free,
+      g_free);
+  g_mutex_init(&ctx->gating_lock);
+  ctx->gated = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, g_object_unref);
+  ctx->device_kind = (HookFridaDeviceKind) kind;
+  ctx->device_address = g_strdup(address);
+  ctx->device_timeout = timeout_ms;
+  ctx->lost_devices = g_ptr_array_new_with_free_func(g_object_unref);
+  if (kind != HOOK_FRIDA_DEVICE_LOCAL) {
+    // A local injector cannot reach another device's processes.
+    ctx->prefer_device = TRUE;
+    return ctx;
+  }
+
   // Prefer the helper injector for broader macOS compatibility.
   const char * mode = getenv("HOOK_INJECT_INJECTOR");
   if (mode != NULL && g_strcmp0(mode, "inprocess") == 0) {
@@ -86,82 +644,834 @@ hook_frida_new(int32_t * error_kind_out, char ** error_out) {
   } else {
     ctx->injector = frida_injector_new();
   }
+  ctx->prefer_device = mode != NULL && g_strcmp0(mode, "device") == 0;
   hook_debug("hook-frida: injector created");
+  ctx->startup.injector_us = hook_elapsed_us(&clock);
+
+  if (error_kind_out != NULL)
+    *error_kind_out = HOOK_FRIDA_ERROR_NONE;
+  return ctx;
+}
+
+static void
+hook_ctx_destroy(HookFridaCtx * ctx) {
+  // Release the context's Frida objects; the runtime itself stays up.
+  // Blocks on Frida calls, so never runs on Frida's main context.
+  if (ctx->gated != NULL) {
+    GHashTableIter iter;
+    gpointer session;
+    g_hash_table_iter_init(&iter, ctx->gated);
+    while (g_hash_table_iter_next(&iter, NULL, &session)) {
+      g_signal_handlers_disconnect_by_data(session, ctx);
+      frida_session_detach_sync(session, NULL, NULL);
+    }
+    g_hash_table_unref(ctx->gated);
+  }
+  g_mutex_clear(&ctx->gating_lock);
+  if (ctx->device != NULL)
+    g_object_unref(ctx->device);
+  g_ptr_array_unref(ctx->lost_devices);
+  g_free(ctx->device_address);
+  if (ctx->manager != NULL)
+    g_object_unref(ctx->manager);
+  if (ctx->injector != NULL)
+    g_object_unref(ctx->injector);
+  g_mutex_clear(&ctx->device_lock);
+  if (ctx->strategies != NULL)
+    g_hash_table_unref(ctx->strategies);
+  g_mutex_clear(&ctx->strategy_lock);
+
+  g_free(ctx);
+  g_atomic_int_add(&hook_frida_live_contexts, -1);
+}
+
+static gpointer
+hook_ctx_destroy_thread(gpointer user_data) {
+  hook_ctx_destroy(user_data);
+  return NULL;
+}
+
+static HookFridaCtx *
+hook_ctx_ref(HookFridaCtx * ctx) {
+  g_atomic_int_inc(&ctx->ref_count);
+  return ctx;
+}
+
+static void
+hook_ctx_unref(HookFridaCtx * ctx) {
+  if (!g_atomic_int_dec_and_test(&ctx->ref_count))
+    return;
+
+  // The last async op completes on the main context, where the blocking
+  // teardown would deadlock; finish it on a thread of its own.
+  if (g_main_context_is_owner(frida_get_main_context()))
+    g_thread_unref(g_thread_new("hook-frida-free", hook_ctx_destroy_thread, ctx));
+  else
+    hook_ctx_destroy(ctx);
+}
+
+typedef struct {
+  GMutex lock;
+  GCond cond;
+  gboolean done;
+} HookDrain;
+
+static gboolean
+hook_drain_reached(gpointer user_data) {
+  HookDrain * drain = user_data;
+  g_mutex_lock(&drain->lock);
+  drain->done = TRUE;
+  g_cond_signal(&drain->cond);
+  g_mutex_unlock(&drain->lock);
+  return G_SOURCE_REMOVE;
+}
+
+static void
+hook_main_context_drain(void) {
+  // Signals are emitted on Frida's main context, so once a round trip
+  // through it returns, no emission that started earlier is still running.
+  // On the main context itself, none can be.
+  GMainContext * main_context = frida_get_main_context();
+  if (g_main_context_is_owner(main_context))
+    return;
+
+  HookDrain drain;
+  g_mutex_init(&drain.lock);
+  g_cond_init(&drain.cond);
+  drain.done = FALSE;
+  g_main_context_invoke(main_context, hook_drain_reached, &drain);
+  g_mutex_lock(&drain.lock);
+  while (!drain.done)
+    g_cond_wait(&drain.cond, &drain.lock);
+  g_mutex_unlock(&drain.lock);
+  g_cond_clear(&drain.cond);
+  g_mutex_clear(&drain.lock);
+}
+
+void
+hook_frida_free(HookFridaCtx * ctx) {
+  if (ctx == NULL)
+    return;
+
+  // The handlers' user data dies with the caller, so disconnect them now
+  // even if in-flight async ops keep the rest of the context alive, and
+  // let emissions that already read them finish first.
+  hook_frida_set_uninjected_handler(ctx, NULL, NULL);
+  hook_frida_set_output_handler(ctx, NULL, NULL);
+  hook_frida_set_child_handler(ctx, NULL, NULL);
+  hook_main_context_drain();
+  hook_ctx_unref(ctx);
+}
+
+static void
+hook_emit_uninjected(HookFridaCtx * ctx, guint id, HookFridaPath path) {
+  // Snapshot the handler under the lock, but call it outside: it may run
+  // user callbacks that inject again. hook_frida_free waits for the call.
+  g_mutex_lock(&ctx->device_lock);
+  HookFridaUninjected handler = ctx->uninjected;
+  void * handler_data = ctx->uninjected_data;
+  g_mutex_unlock(&ctx->device_lock);
+  if (handler != NULL)
+    handler(handler_data, id, (int32_t) path);
+}
+
+static void
+hook_on_injector_uninjected(FridaInjector * injector, guint id, gpointer user_data) {
+  HookFridaCtx * ctx = user_data;
+  (void) injector;
+  hook_debug("hook-frida: injector uninjected");
+  hook_emit_uninjected(ctx, id, HOOK_FRIDA_PATH_INJECTOR);
+}
+
+static void
+hook_on_device_uninjected(FridaDevice * device, guint id, gpointer user_data) {
+  HookFridaCtx * ctx = user_data;
+  (void) device;
+  hook_debug("hook-frida: device uninjected");
+  hook_emit_uninjected(ctx, id, HOOK_FRIDA_PATH_DEVICE);
+}
+
+void
+hook_frida_set_uninjected_handler(HookFridaCtx * ctx,
+    HookFridaUninjected handler,
+    void * user_data) {
+  if (ctx == NULL)
+    return;
+
+  g_mutex_lock(&ctx->device_lock);
+  if (ctx->injector_uninjected_id != 0) {
+    g_signal_handler_disconnect(ctx->injector, ctx->injector_uninjected_id);
+    ctx->injector_uninjected_id = 0;
+  }
+  if (ctx->device_uninjected_id != 0) {
+    g_signal_handler_disconnect(ctx->device, ctx->device_uninjected_id);
+    ctx->device_uninjected_id = 0;
+  }
+
+  ctx->uninjected = handler;
+  ctx->uninjected_data = user_data;
+  if (handler != NULL && ctx->injector != NULL) {
+    ctx->injector_uninjected_id = g_signal_connect(ctx->injector, "uninjected",
+        G_CALLBACK(hook_on_injector_uninjected), ctx);
+  }
+  hook_device_connect_signals(ctx);
+  g_mutex_unlock(&ctx->device_lock);
+}
+
+static void
+hook_on_device_output(FridaDevice * device,
+    guint pid,
+    gint fd,
+    GBytes * data,
+    gpointer user_data) {
+  HookFridaCtx * ctx = user_data;
+  (void) device;
+  // As in hook_emit_uninjected: snapshot under the lock, call outside it.
+  g_mutex_lock(&ctx->device_lock);
+  HookFridaOutput handler = ctx->output;
+  void * handler_data = ctx->output_data;
+  g_mutex_unlock(&ctx->device_lock);
+  if (handler == NULL)
+    return;
+
+  gsize len = 0;
+  const guint8 * bytes = g_bytes_get_data(data, &len);
+  handler(handler_data, pid, fd, bytes, len);
+}
+
+void
+hook_frida_set_output_handler(HookFridaCtx * ctx,
+    HookFridaOutput handler,
+    void * user_data) {
+  if (ctx == NULL)
+    return;
+
+  g_mutex_lock(&ctx->device_lock);
+  if (ctx->device_output_id != 0) {
+    g_signal_handler_disconnect(ctx->device, ctx->device_output_id);
+    ctx->device_output_id = 0;
+  }
+
+  ctx->output = handler;
+  ctx->output_data = user_data;
+  hook_device_connect_signals(ctx);
+  g_mutex_unlock(&ctx->device_lock);
+}
+
+static void
+hook_emit_child(HookFridaCtx * ctx, guint pid, guint parent_pid, int32_t kind) {
+  // As in hook_emit_uninjected: snapshot under the lock, call outside it.
+  g_mutex_lock(&ctx->device_lock);
+  HookFridaChildEvent handler = ctx->child;
+  void * handler_data = ctx->child_data;
+  g_mutex_unlock(&ctx->device_lock);
+  if (handler != NULL)
+    handler(handler_data, pid, parent_pid, kind);
+}
+
+static void
+hook_on_device_child_added(FridaDevice * device, FridaChild * child, gpointer user_data) {
+  HookFridaCtx * ctx = user_data;
+  (void) device;
+  hook_debug("hook-frida: child added");
+  hook_emit_child(ctx, frida_child_get_pid(child), frida_child_get_parent_pid(child),
+      (int32_t) frida_child_get_origin(child));
+}
+
+static void
+hook_on_gating_detached(FridaSession * session,
+    FridaSessionDetachReason reason,
+    FridaCrash * crash,
+    gpointer user_data) {
+  HookFridaCtx * ctx = user_data;
+  (void) reason;
+  (void) crash;
+  guint pid = frida_session_get_pid(session);
+
+  // Only forget the entry if it still belongs to this session.
+  g_mutex_lock(&ctx->gating_lock);
+  gboolean ours = g_hash_table_lookup(ctx->gated, GUINT_TO_POINTER(pid)) == session;
+  if (ours)
+    g_hash_table_steal(ctx->gated, GUINT_TO_POINTER(pid));
+  g_mutex_unlock(&ctx->gating_lock);
+  if (!ours)
+    return;
 
+  hook_debug("hook-frida: gating session detached");
+  g_signal_handlers_disconnect_by_data(session, ctx);
+  hook_emit_child(ctx, pid, pid, HOOK_FRIDA_CHILD_GATING_ENDED);
+  // The signal emission holds its own reference to the session.
+  g_object_unref(session);
+}
+
+void
+hook_frida_set_child_handler(HookFridaCtx * ctx,
+    HookFridaChildEvent handler,
+    void * user_data) {
+  if (ctx == NULL)
+    return;
+
+  g_mutex_lock(&ctx->device_lock);
+  if (ctx->device_child_added_id != 0) {
+    g_signal_handler_disconnect(ctx->device, ctx->device_child_added_id);
+    ctx->device_child_added_id = 0;
+  }
+
+  ctx->child = handler;
+  ctx->child_data = user_data;
+  hook_device_connect_signals(ctx);
+  g_mutex_unlock(&ctx->device_lock);
+}
+
+static void
+hook_device_connect_signals(HookFridaCtx * ctx) {
+  // Connect every registered device handler that is not connected yet.
+  // Called with device_lock held, once the device exists.
+  if (ctx->device == NULL)
+    return;
+
+  if (ctx->uninjected != NULL && ctx->device_uninjected_id == 0) {
+    ctx->device_uninjected_id = g_signal_connect(ctx->device, "uninjected",
+        G_CALLBACK(hook_on_device_uninjected), ctx);
+  }
+  if (ctx->output != NULL && ctx->device_output_id == 0) {
+    ctx->device_output_id = g_signal_connect(ctx->device, "output",
+        G_CALLBACK(hook_on_device_output), ctx);
+  }
+  if (ctx->child != NULL && ctx->device_child_added_id == 0) {
+    ctx->device_child_added_id = g_signal_connect(ctx->device, "child-added",
+        G_CALLBACK(hook_on_device_child_added), ctx);
+  }
+}
+
+int
+hook_frida_warm_up(HookFridaCtx * ctx,
+    HookFridaStartupStats * stats_out,
+    int32_t * error_kind_out,
+    char ** error_out) {
+  if (ctx == NULL)
+    return 0;
+
+  hook_debug("hook-frida: warm_up starting");
   GError * error = NULL;
-  ctx->device = frida_device_manager_get_device_by_type_sync(
-      ctx->manager,
-      FRIDA_DEVICE_TYPE_LOCAL,
-      0,
-      NULL,
-      &error);
-  hook_debug("hook-frida: device lookup finished");
+  if (!hook_require_device(ctx, error_kind_out, error_out))
+    return 0;
+  gint64 clock = g_get_monotonic_time();
+
+  // Demonitoring an id that was never handed out makes the injector launch
+  // its helper before any target is known. The helper answers "invalid id";
+  // anything else means it could not be brought up.
+  if (ctx->injector != NULL) {
+    frida_injector_demonitor_sync(ctx->injector, 0, NULL, &error);
+    ctx->startup.helper_us = hook_elapsed_us(&clock);
+    if (error != NULL && !g_error_matches(error, FRIDA_ERROR, FRIDA_ERROR_INVALID_ARGUMENT)) {
+      hook_set_error(error, error_kind_out, error_out);
+      g_error_free(error);
+      return 0;
+    }
+    g_clear_error(&error);
+    hook_debug("hook-frida: injector helper ready");
+  }
+
+  // Querying the device brings up the host session used by spawn, resume
+  // and device-path injections.
+  GHashTable * params = frida_device_query_system_parameters_sync(ctx->device, NULL, &error);
+  if (params != NULL)
+    g_hash_table_unref(params);
+  ctx->startup.host_session_us = hook_elapsed_us(&clock);
+  hook_debug("hook-frida: host session ready");
   if (error != NULL) {
     hook_set_error(error, error_kind_out, error_out);
     g_error_free(error);
-    hook_frida_free(ctx);
-    return NULL;
+    return 0;
   }
 
+  if (stats_out != NULL)
+    *stats_out = ctx->startup;
   if (error_kind_out != NULL)
     *error_kind_out = HOOK_FRIDA_ERROR_NONE;
-  return ctx;
+  return 1;
 }
 
-void
-hook_frida_free(HookFridaCtx * ctx) {
-  // Release Frida objects and shut down the library.
+int
+hook_frida_inject_process(HookFridaCtx * ctx,
+    int32_t pid,
+    const char * library_path,
+    const char * entrypoint,
+    const char * data,
+    uint32_t * out_id,
+    int32_t * path_out,
+    HookFridaOpStats * stats_out,
+    HookFridaCancellable * cancellable,
+    int32_t * error_kind_out,
+    char ** error_out) {
+  if (ctx == NULL)
+    return 0;
+
+  hook_debug("hook-frida: inject_process starting");
+  // Inject the library into an existing process.
+  GError * error = NULL;
+  HookFridaPath path = HOOK_FRIDA_PATH_NONE;
+  guint id = hook_inject_sync(ctx, (guint) pid, library_path, NULL, entrypoint, data, &path,
+      stats_out, hook_cancellable(cancellable), &error);
+  if (stats_out != NULL)
+    stats_out->total_us = stats_out->inject_us + stats_out->fallback_us;
+
+  if (error != NULL) {
+    hook_set_error(error, error_kind_out, error_out);
+    g_error_free(error);
+    return 0;
+  }
+
+  if (out_id != NULL)
+    *out_id = id;
+  if (path_out != NULL)
+    *path_out = (int32_t) path;
+
+  if (error_kind_out != NULL)
+    *error_kind_out = HOOK_FRIDA_ERROR_NONE;
+  return 1;
+}
+
+int
+hook_frida_inject_blob(HookFridaCtx * ctx,
+    int32_t pid,
+    const HookFridaBlob * blob,
+    const char * entrypoint,
+    const char * data,
+    uint32_t * out_id,
+    int32_t * path_out,
+    HookFridaOpStats * stats_out,
+    HookFridaCancellable * cancellable,
+    int32_t * error_kind_out,
+    char ** error_out) {
+  // Adopt the blob first so its owner is released on every path.
+  GBytes * bytes = hook_blob_bytes_new(blob);
+  if (ctx == NULL || bytes == NULL) {
+    if (bytes != NULL)
+      g_bytes_unref(bytes);
+    return 0;
+  }
+
+  // Inject from an in-memory library blob.
+  GError * error = NULL;
+  HookFridaPath path = HOOK_FRIDA_PATH_NONE;
+  guint id = hook_inject_sync(ctx, (guint) pid, NULL, bytes, entrypoint, data, &path,
+      stats_out, hook_cancellable(cancellable), &error);
+  if (stats_out != NULL)
+    stats_out->total_us = stats_out->inject_us + stats_out->fallback_us;
+
+  g_bytes_unref(bytes);
+
+  if (error != NULL) {
+    hook_set_error(error, error_kind_out, error_out);
+    g_error_free(error);
+    return 0;
+  }
+
+  if (out_id != NULL)
+    *out_id = id;
+  if (path_out != NULL)
+    *path_out = (int32_t) path;
+
+  if (error_kind_out != NULL)
+    *error_kind_out = HOOK_FRIDA_ERROR_NONE;
+  return 1;
+}
+
+static int
+hook_inject_launch_sync(HookFridaCtx * ctx,
+    const char * program,
+    FridaSpawnOptions * options,
+    GCancellable * cancellable,
+    const char * library_path,
+    GBytes * blob,
+    const char * entrypoint,
+    const char * data,
+    uint32_t * out_pid,
+    uint32_t * out_id,
+    int32_t * path_out,
+    HookFridaOpStats * stats_out,
+    int32_t * error_kind_out,
+    char ** error_out) {
+  // Spawn the process suspended, inject, and resume. A child that fails to
+  // inject or resume is killed rather than left suspended.
+  gint64 start = (stats_out != NULL) ? g_get_monotonic_time() : 0;
+  if (!hook_require_device_timed(ctx, (stats_out != NULL) ? &stats_out->device_lookup_us : NULL,
+          error_kind_out, error_out)) {
+    if (stats_out != NULL)
+      stats_out->total_us = hook_elapsed_us(&start);
+    return 0;
+  }
+  gint64 clock = (stats_out != NULL) ? g_get_monotonic_time() : 0;
+
+  GError * error = NULL;
+  guint pid = frida_device_spawn_sync(ctx->device, program, options, cancellable, &error);
+  if (stats_out != NULL)
+    stats_out->spawn_us = hook_elapsed_us(&clock);
+
+  if (error != NULL) {
+    hook_set_error(error, error_kind_out, error_out);
+    g_error_free(error);
+    if (stats_out != NULL)
+      stats_out->total_us = stats_out->spawn_us;
+    return 0;
+  }
+  hook_spawned(ctx, pid, options);
+
+  HookFridaPath path = HOOK_FRIDA_PATH_NONE;
+  guint id = hook_inject_sync(ctx, pid, library_path, blob, entrypoint, data, &path, stats_out,
+      cancellable, &error);
+
+  if (error == NULL) {
+    clock = (stats_out != NULL) ? g_get_monotonic_time() : 0;
+    frida_device_resume_sync(ctx->device, pid, cancellable, &error);
+    if (stats_out != NULL)
+      stats_out->resume_us = hook_elapsed_us(&clock);
+  }
+  if (stats_out != NULL)
+    stats_out->total_us = hook_elapsed_us(&start);
+
+  if (error != NULL) {
+    hook_set_error(error, error_kind_out, error_out);
+    g_error_free(error);
+    frida_device_kill_sync(ctx->device, pid, NULL, NULL);
+    return 0;
+  }
+
+  if (out_pid != NULL)
+    *out_pid = pid;
+  if (out_id != NULL)
+    *out_id = id;
+  if (path_out != NULL)
+    *path_out = (int32_t) path;
+
+  if (error_kind_out != NULL)
+    *error_kind_out = HOOK_FRIDA_ERROR_NONE;
+  return 1;
+}
+
+int
+hook_frida_inject_launch(HookFridaCtx * ctx,
+    const char * program,
+    const char * const * argv,
+    const char * const * envp,
+    const char * cwd,
+    int32_t stdio,
+    const char * library_path,
+    const char * entrypoint,
+    const char * data,
+    uint32_t * out_pid,
+    uint32_t * out_id,
+    int32_t * path_out,
+    HookFridaOpStats * stats_out,
+    HookFridaCancellable * cancellable,
+    int32_t * error_kind_out,
+    char ** error_out) {
   if (ctx == NULL)
+    return 0;
+
+  FridaSpawnOptions * options = hook_spawn_options_new(argv, envp, cwd, stdio);
+  int ok = hook_inject_launch_sync(ctx, program, options, hook_cancellable(cancellable),
+      library_path, NULL, entrypoint, data, out_pid, out_id, path_out, stats_out,
+      error_kind_out, error_out);
+  g_object_unref(options);
+  return ok;
+}
+
+int
+hook_frida_inject_launch_blob(HookFridaCtx * ctx,
+    const char * program,
+    const char * const * argv,
+    const char * const * envp,
+    const char * cwd,
+    int32_t stdio,
+    const HookFridaBlob * blob,
+    const char * entrypoint,
+    const char * data,
+    uint32_t * out_pid,
+    uint32_t * out_id,
+    int32_t * path_out,
+    HookFridaOpStats * stats_out,
+    HookFridaCancellable * cancellable,
+    int32_t * error_kind_out,
+    char ** error_out) {
+  // Adopt the blob first so its owner is released on every path.
+  GBytes * bytes = hook_blob_bytes_new(blob);
+  if (ctx == NULL || bytes == NULL) {
+    if (bytes != NULL)
+      g_bytes_unref(bytes);
+    return 0;
+  }
+
+  FridaSpawnOptions * options = hook_spawn_options_new(argv, envp, cwd, stdio);
+  int ok = hook_inject_launch_sync(ctx, program, options, hook_cancellable(cancellable), NULL,
+      bytes, entrypoint, data, out_pid, out_id, path_out, stats_out, error_kind_out, error_out);
+  g_object_unref(options);
+  g_bytes_unref(bytes);
+  return ok;
+}
+
+static int
+hook_spawn_sync(HookFridaCtx * ctx,
+    const char * program,
+    FridaSpawnOptions * options,
+    GCancellable * cancellable,
+    uint32_t * out_pid,
+    int32_t * error_kind_out,
+    char ** error_out) {
+  // Spawn the process suspended; caller is responsible for resuming.
+  GError * error = NULL;
+  guint pid = frida_device_spawn_sync(ctx->device, program, options, cancellable, &error);
+
+  if (error != NULL) {
+    hook_set_error(error, error_kind_out, error_out);
+    g_error_free(error);
+    return 0;
+  }
+  hook_spawned(ctx, pid, options);
+
+  if (out_pid != NULL)
+    *out_pid = pid;
+
+  if (error_kind_out != NULL)
+    *error_kind_out = HOOK_FRIDA_ERROR_NONE;
+  return 1;
+}
+
+int
+hook_frida_spawn(HookFridaCtx * ctx,
+    const char * program,
+    const char * const * argv,
+    const char * const * envp,
+    const char * cwd,
+    int32_t stdio,
+    uint32_t * out_pid,
+    HookFridaCancellable * cancellable,
+    int32_t * error_kind_out,
+    char ** error_out) {
+  if (ctx == NULL || !hook_require_device(ctx, error_kind_out, error_out))
+    return 0;
+
+  FridaSpawnOptions * options = hook_spawn_options_new(argv, envp, cwd, stdio);
+  int ok = hook_spawn_sync(ctx, program, options, hook_cancellable(cancellable), out_pid,
+      error_kind_out, error_out);
+  g_object_unref(options);
+  return ok;
+}
+
+// === Prepared launch specs ===
+
+struct HookFridaSpawnSpec {
+  gchar * program;
+  gchar ** argv;
+  gchar ** envp;
+  gchar * cwd;
+  int32_t stdio;
+  // Built once and shared read-only by every launch without overrides.
+  FridaSpawnOptions * options;
+};
+
+HookFridaSpawnSpec *
+hook_frida_spawn_spec_new(const char * program,
+    const char * const * argv,
+    const char * const * envp,
+    const char * cwd,
+    int32_t stdio) {
+  if (program == NULL || argv == NULL)
+    return NULL;
+
+  HookFridaSpawnSpec * spec = g_new0(HookFridaSpawnSpec, 1);
+  spec->program = g_strdup(program);
+  spec->argv = g_strdupv((gchar **) argv);
+  spec->envp = g_strdupv((gchar **) envp);
+  spec->cwd = g_strdup(cwd);
+  spec->stdio = stdio;
+  spec->options = hook_spawn_options_new(argv, envp, cwd, stdio);
+  return spec;
+}
+
+void
+hook_frida_spawn_spec_free(HookFridaSpawnSpec * spec) {
+  if (spec == NULL)
     return;
 
-  if (ctx->device != NULL)
-    g_object_unref(ctx->device);
-  if (ctx->manager != NULL)
-    g_object_unref(ctx->manager);
-  if (ctx->injector != NULL)
-    g_object_unref(ctx->injector);
+  g_object_unref(spec->options);
+  g_free(spec->program);
+  g_strfreev(spec->argv);
+  g_strfreev(spec->envp);
+  g_free(spec->cwd);
+  g_free(spec);
+}
+
+static gboolean
+hook_env_overridden(const char * entry, const char * const * overrides) {
+  // Whether `overrides` sets the variable of a KEY=VALUE `entry`.
+  const char * eq = strchr(entry, '=');
+  size_t key_len = (eq != NULL) ? (size_t) (eq - entry) : strlen(entry);
+  for (size_t i = 0; overrides[i] != NULL; i++) {
+    if (strncmp(overrides[i], entry, key_len) == 0 && overrides[i][key_len] == '=')
+      return TRUE;
+  }
+  return FALSE;
+}
+
+static FridaSpawnOptions *
+hook_spawn_spec_options(const HookFridaSpawnSpec * spec,
+    const char * const * extra_argv,
+    const char * const * extra_envp) {
+  // Launches without overrides reuse the prepared options. Otherwise only the
+  // overridden vectors are rebuilt, from strings that are already encoded.
+  gboolean more_args = extra_argv != NULL && extra_argv[0] != NULL;
+  gboolean more_env = extra_envp != NULL && extra_envp[0] != NULL;
+  if (!more_args && !more_env)
+    return g_object_ref(spec->options);
+
+  GPtrArray * argv = g_ptr_array_new();
+  for (gchar ** arg = spec->argv; *arg != NULL; arg++)
+    g_ptr_array_add(argv, *arg);
+  for (size_t i = 0; more_args && extra_argv[i] != NULL; i++)
+    g_ptr_array_add(argv, (gpointer) extra_argv[i]);
+  g_ptr_array_add(argv, NULL);
+
+  GPtrArray * envp = NULL;
+  if (more_env) {
+    envp = g_ptr_array_new();
+    for (gchar ** entry = spec->envp; entry != NULL && *entry != NULL; entry++) {
+      if (!hook_env_overridden(*entry, extra_envp))
+        g_ptr_array_add(envp, *entry);
+    }
+    for (size_t i = 0; extra_envp[i] != NULL; i++)
+      g_ptr_array_add(envp, (gpointer) extra_envp[i]);
+    g_ptr_array_add(envp, NULL);
+  }
+
+  FridaSpawnOptions * options = hook_spawn_options_new((const char * const *) argv->pdata,
+      (envp != NULL) ? (const char * const *) envp->pdata : (const char * const *) spec->envp,
+      spec->cwd, spec->stdio);
+  g_ptr_array_free(argv, TRUE);
+  if (envp != NULL)
+    g_ptr_array_free(envp, TRUE);
+  return options;
+}
+
+int
+hook_frida_spawn_prepared(HookFridaCtx * ctx,
+    const HookFridaSpawnSpec * spec,
+    const char * const * extra_argv,
+    const char * const * extra_envp,
+    uint32_t * out_pid,
+    HookFridaCancellable * cancellable,
+    int32_t * error_kind_out,
+    char ** error_out) {
+  if (ctx == NULL || spec == NULL || !hook_require_device(ctx, error_kind_out, error_out))
+    return 0;
+
+  FridaSpawnOptions * options = hook_spawn_spec_options(spec, extra_argv, extra_envp);
+  int ok = hook_spawn_sync(ctx, spec->program, options, hook_cancellable(cancellable), out_pid,
+      error_kind_out, error_out);
+  g_object_unref(options);
+  return ok;
+}
+
+int
+hook_frida_inject_launch_prepared(HookFridaCtx * ctx,
+    const HookFridaSpawnSpec * spec,
+    const char * const * extra_argv,
+    const char * const * extra_envp,
+    const char * library_path,
+    const HookFridaBlob * blob,
+    const char * entrypoint,
+    const char * data,
+    uint32_t * out_pid,
+    uint32_t * out_id,
+    int32_t * path_out,
+    HookFridaOpStats * stats_out,
+    HookFridaCancellable * cancellable,
+    int32_t * error_kind_out,
+    char ** error_out) {
+  // Adopt the blob first so its owner is released on every path.
+  GBytes * bytes = hook_blob_bytes_new(blob);
+  if (ctx == NULL || spec == NULL || (library_path == NULL) == (bytes == NULL)) {
+    if (bytes != NULL)
+      g_bytes_unref(bytes);
+    if (error_kind_out != NULL)
+      *error_kind_out = HOOK_FRIDA_ERROR_INVALID_ARGUMENT;
+    if (error_out != NULL)
+      *error_out = g_strdup("prepared launch needs a spec and exactly one library source");
+    return 0;
+  }
+
+  FridaSpawnOptions * options = hook_spawn_spec_options(spec, extra_argv, extra_envp);
+  int ok = hook_inject_launch_sync(ctx, spec->program, options, hook_cancellable(cancellable),
+      library_path, bytes, entrypoint, data, out_pid, out_id, path_out, stats_out,
+      error_kind_out, error_out);
+  g_object_unref(options);
+  if (bytes != NULL)
+    g_bytes_unref(bytes);
+  return ok;
+}
+
+int
+hook_frida_resume(HookFridaCtx * ctx,
+    uint32_t pid,
+    HookFridaCancellable * cancellable,
+    int32_t * error_kind_out,
+    char ** error_out) {
+  if (ctx == NULL || !hook_require_device(ctx, error_kind_out, error_out))
+    return 0;
+
+  // Resume a process spawned in suspended mode.
+  GError * error = NULL;
+  frida_device_resume_sync(ctx->device, pid, hook_cancellable(cancellable), &error);
+
+  if (error != NULL) {
+    hook_set_error(error, error_kind_out, error_out);
+    g_error_free(error);
+    return 0;
+  }
+
+  if (error_kind_out != NULL)
+    *error_kind_out = HOOK_FRIDA_ERROR_NONE;
+  return 1;
+}
+
+int
+hook_frida_kill(HookFridaCtx * ctx,
+    uint32_t pid,
+    int32_t * error_kind_out,
+    char ** error_out) {
+  if (ctx == NULL || !hook_require_device(ctx, error_kind_out, error_out))
+    return 0;
+
+  GError * error = NULL;
+  frida_device_kill_sync(ctx->device, pid, NULL, &error);
 
-  g_free(ctx);
-  frida_shutdown();
+  if (error != NULL) {
+    hook_set_error(error, error_kind_out, error_out);
+    g_error_free(error);
+    return 0;
+  }
+
+  if (error_kind_out != NULL)
+    *error_kind_out = HOOK_FRIDA_ERROR_NONE;
+  return 1;
 }
 
 int
-hook_frida_inject_process(HookFridaCtx * ctx,
-    int32_t pid,
-    const char * library_path,
-    const char * entrypoint,
-    const char * data,
-    uint32_t * out_id,
+hook_frida_input(HookFridaCtx * ctx,
+    uint32_t pid,
+    const uint8_t * data,
+    size_t len,
     int32_t * error_kind_out,
     char ** error_out) {
-  if (ctx == NULL || ctx->injector == NULL)
+  if (ctx == NULL || !hook_require_device(ctx, error_kind_out, error_out))
     return 0;
 
-  hook_debug("hook-frida: inject_process starting");
-  // Inject the library into an existing process.
+  GBytes * bytes = g_bytes_new(data, len);
   GError * error = NULL;
-  guint id = frida_injector_inject_library_file_sync(
-      ctx->injector,
-      (guint) pid,
-      library_path,
-      entrypoint,
-      data,
-      NULL,
-      &error);
-
-  if (error != NULL && hook_should_try_device_fallback(error) && ctx->device != NULL) {
-    hook_debug("hook-frida: inject_process helper failed, trying device fallback");
-    g_error_free(error);
-    error = NULL;
-    id = frida_device_inject_library_file_sync(
-        ctx->device,
-        (guint) pid,
-        library_path,
-        entrypoint,
-        data,
-        NULL,
-        &error);
-  }
+  frida_device_input_sync(ctx->device, pid, bytes, NULL, &error);
+  g_bytes_unref(bytes);
 
   if (error != NULL) {
     hook_set_error(error, error_kind_out, error_out);
@@ -169,63 +1479,62 @@ hook_frida_inject_process(HookFridaCtx * ctx,
     return 0;
   }
 
-  if (out_id != NULL)
-    *out_id = id;
-
   if (error_kind_out != NULL)
     *error_kind_out = HOOK_FRIDA_ERROR_NONE;
   return 1;
 }
 
 int
-hook_frida_inject_blob(HookFridaCtx * ctx,
-    int32_t pid,
-    const uint8_t * blob,
-    size_t blob_len,
-    const char * entrypoint,
-    const char * data,
-    uint32_t * out_id,
+hook_frida_enable_child_gating(HookFridaCtx * ctx,
+    uint32_t pid,
     int32_t * error_kind_out,
     char ** error_out) {
-  if (ctx == NULL || ctx->injector == NULL)
+  if (ctx == NULL || !hook_require_device(ctx, error_kind_out, error_out))
     return 0;
 
-  // Inject from an in-memory library blob.
-  GError * error = NULL;
-  GBytes * bytes = g_bytes_new(blob, blob_len);
-
-  guint id = frida_injector_inject_library_blob_sync(
-      ctx->injector,
-      (guint) pid,
-      bytes,
-      entrypoint,
-      data,
-      NULL,
-      &error);
-
-  if (error != NULL && hook_should_try_device_fallback(error) && ctx->device != NULL) {
-    g_error_free(error);
-    error = NULL;
-    id = frida_device_inject_library_blob_sync(
-        ctx->device,
-        (guint) pid,
-        bytes,
-        entrypoint,
-        data,
-        NULL,
-        &error);
+  // A session left over from before an exec may be detached already.
+  g_mutex_lock(&ctx->gating_lock);
+  FridaSession * existing = g_hash_table_lookup(ctx->gated, GUINT_TO_POINTER(pid));
+  gboolean gated = existing != NULL && !frida_session_is_detached(existing);
+  if (existing != NULL && !gated) {
+    g_signal_handlers_disconnect_by_data(existing, ctx);
+    g_hash_table_remove(ctx->gated, GUINT_TO_POINTER(pid));
+  }
+  g_mutex_unlock(&ctx->gating_lock);
+  if (gated) {
+    if (error_kind_out != NULL)
+      *error_kind_out = HOOK_FRIDA_ERROR_NONE;
+    return 1;
   }
 
-  g_bytes_unref(bytes);
+  // Gating lives in a session: Frida's agent in the target holds every new
+  // child until it is resumed.
+  GError * error = NULL;
+  FridaSession * session = frida_device_attach_sync(ctx->device, pid, NULL, NULL, &error);
+  if (error == NULL)
+    frida_session_enable_child_gating_sync(session, NULL, &error);
 
   if (error != NULL) {
+    if (session != NULL) {
+      frida_session_detach_sync(session, NULL, NULL);
+      g_object_unref(session);
+    }
     hook_set_error(error, error_kind_out, error_out);
     g_error_free(error);
     return 0;
   }
 
-  if (out_id != NULL)
-    *out_id = id;
+  g_mutex_lock(&ctx->gating_lock);
+  if (g_hash_table_contains(ctx->gated, GUINT_TO_POINTER(pid))) {
+    // Lost a race with another caller; keep the session already stored.
+    g_mutex_unlock(&ctx->gating_lock);
+    frida_session_detach_sync(session, NULL, NULL);
+    g_object_unref(session);
+  } else {
+    g_hash_table_insert(ctx->gated, GUINT_TO_POINTER(pid), session);
+    g_signal_connect(session, "detached", G_CALLBACK(hook_on_gating_detached), ctx);
+    g_mutex_unlock(&ctx->gating_lock);
+  }
 
   if (error_kind_out != NULL)
     *error_kind_out = HOOK_FRIDA_ERROR_NONE;
@@ -233,162 +1542,564 @@ hook_frida_inject_blob(HookFridaCtx * ctx,
 }
 
 int
-hook_frida_inject_launch(HookFridaCtx * ctx,
-    const char * program,
-    const char * const * argv,
-    const char * const * envp,
-    const char * cwd,
-    int32_t stdio,
-    const char * library_path,
-    const char * entrypoint,
-    const char * data,
-    uint32_t * out_pid,
-    uint32_t * out_id,
+hook_frida_disable_child_gating(HookFridaCtx * ctx,
+    uint32_t pid,
     int32_t * error_kind_out,
     char ** error_out) {
-  if (ctx == NULL || ctx->device == NULL || ctx->injector == NULL)
+  if (ctx == NULL)
     return 0;
 
-  // Spawn the process suspended, inject, and resume.
-  FridaSpawnOptions * options = frida_spawn_options_new();
-  if (argv != NULL)
-    g_object_set(options, "argv", argv, NULL);
-  if (envp != NULL)
-    g_object_set(options, "envp", envp, NULL);
-  if (cwd != NULL)
-    g_object_set(options, "cwd", cwd, NULL);
-  g_object_set(options, "stdio", stdio, NULL);
+  gpointer session = NULL;
+  g_mutex_lock(&ctx->gating_lock);
+  if (g_hash_table_lookup_extended(ctx->gated, GUINT_TO_POINTER(pid), NULL, &session))
+    g_hash_table_steal(ctx->gated, GUINT_TO_POINTER(pid));
+  g_mutex_unlock(&ctx->gating_lock);
+
+  if (error_kind_out != NULL)
+    *error_kind_out = HOOK_FRIDA_ERROR_NONE;
+  if (session == NULL)
+    return 1;
 
+  // Detaching releases any children still held; a target that already
+  // exited has nothing left to detach from.
+  g_signal_handlers_disconnect_by_data(session, ctx);
   GError * error = NULL;
-  guint pid = frida_device_spawn_sync(ctx->device, program, options, NULL, &error);
-  g_object_unref(options);
+  if (!frida_session_is_detached(session))
+    frida_session_detach_sync(session, NULL, &error);
+  g_object_unref(session);
 
   if (error != NULL) {
     hook_set_error(error, error_kind_out, error_out);
     g_error_free(error);
     return 0;
   }
+  return 1;
+}
 
-  guint id = frida_injector_inject_library_file_sync(
-      ctx->injector,
-      pid,
-      library_path,
-      entrypoint,
-      data,
-      NULL,
-      &error);
+int
+hook_frida_demonitor(HookFridaCtx * ctx,
+    uint32_t id,
+    int32_t path,
+    HookFridaCancellable * cancellable,
+    int32_t * error_kind_out,
+    char ** error_out) {
+  if (ctx == NULL)
+    return 0;
 
-  if (error != NULL && hook_should_try_device_fallback(error) && ctx->device != NULL) {
-    g_error_free(error);
-    error = NULL;
-    id = frida_device_inject_library_file_sync(
-        ctx->device,
-        pid,
-        library_path,
-        entrypoint,
-        data,
-        NULL,
-        &error);
+  // Device-path injections are not monitored, and their ids come from the
+  // device rather than the injector; without an injector every injection is one.
+  if (ctx->injector == NULL || path == HOOK_FRIDA_PATH_DEVICE) {
+    if (error_kind_out != NULL)
+      *error_kind_out = HOOK_FRIDA_ERROR_NONE;
+    return 1;
   }
 
+  // Stop monitoring the injection.
+  GError * error = NULL;
+  frida_injector_demonitor_sync(ctx->injector, id, hook_cancellable(cancellable), &error);
+
   if (error != NULL) {
     hook_set_error(error, error_kind_out, error_out);
     g_error_free(error);
     return 0;
   }
 
-  frida_device_resume_sync(ctx->device, pid, NULL, &error);
+  if (error_kind_out != NULL)
+    *error_kind_out = HOOK_FRIDA_ERROR_NONE;
+  return 1;
+}
+
+// === Async operations ===
+// Every async operation is started on Frida's main context (the GMainLoop
+// thread owned by frida_init) and completes through a HookFridaCompletion.
+
+typedef enum {
+  HOOK_ASYNC_INJECT_FILE,
+  HOOK_ASYNC_INJECT_BLOB,
+  HOOK_ASYNC_SPAWN,
+  HOOK_ASYNC_RESUME,
+  HOOK_ASYNC_DEMONITOR
+} HookAsyncKind;
+
+typedef struct {
+  HookFridaCtx * ctx;
+  HookAsyncKind kind;
+  // Target pid, or injection id for demonitor.
+  guint target;
+  gchar * library_path;
+  GBytes * blob;
+  gchar * entrypoint;
+  gchar * data;
+  gchar * program;
+  FridaSpawnOptions * options;
+  // Injection path of the current attempt; NONE for other operations.
+  HookFridaPath path;
+  HookTargetKey key;
+  gboolean retried;
+  // Start of the device lookup run on this operation's behalf.
+  gint64 lookup_start;
+  HookFridaCompletion callback;
+  void * user_data;
+} HookAsyncOp;
+
+static HookAsyncOp *
+hook_async_op_new(HookFridaCtx * ctx, HookAsyncKind kind, guint target,
+    HookFridaCompletion callback, void * user_data) {
+  HookAsyncOp * op = g_new0(HookAsyncOp, 1);
+  g_atomic_int_inc(&hook_frida_live_async_ops);
+  op->ctx = hook_ctx_ref(ctx);
+  op->kind = kind;
+  op->target = target;
+  op->callback = callback;
+  op->user_data = user_data;
+  return op;
+}
+
+static void
+hook_async_op_free(HookAsyncOp * op) {
+  g_free(op->library_path);
+  if (op->blob != NULL)
+    g_bytes_unref(op->blob);
+  g_free(op->entrypoint);
+  g_free(op->data);
+  g_free(op->program);
+  if (op->options != NULL)
+    g_object_unref(op->options);
+  hook_ctx_unref(op->ctx);
+  g_free(op);
+  g_atomic_int_add(&hook_frida_live_async_ops, -1);
+}
+
+static void
+hook_async_op_complete(HookAsyncOp * op, guint value, GError * error) {
+  // Report to the caller exactly once, then release the operation.
   if (error != NULL) {
-    hook_set_error(error, error_kind_out, error_out);
+    op->callback(op->user_data, 0, HOOK_FRIDA_PATH_NONE,
+        (int32_t) hook_error_kind_from_gerror(error),
+        error->message != NULL ? error->message : "unknown error");
+  } else {
+    op->callback(op->user_data, value, (int32_t) op->path, HOOK_FRIDA_ERROR_NONE, NULL);
+  }
+  hook_async_op_free(op);
+}
+
+static void hook_async_op_done(GObject * source, GAsyncResult * res, gpointer user_data);
+static void hook_async_op_start(HookAsyncOp * op);
+
+static void
+hook_async_device_found(GObject * source, GAsyncResult * res, gpointer user_data) {
+  HookAsyncOp * op = user_data;
+  GError * error = NULL;
+  (void) source;
+  FridaDevice * device = hook_device_lookup_finish(op->ctx, res, &error);
+  hook_debug("hook-frida: async device lookup finished");
+  if (device == NULL) {
+    hook_async_op_complete(op, 0, error);
     g_error_free(error);
-    return 0;
+    return;
   }
 
-  if (out_pid != NULL)
-    *out_pid = pid;
-  if (out_id != NULL)
-    *out_id = id;
+  hook_device_adopt(op->ctx, device, (uint64_t) (g_get_monotonic_time() - op->lookup_start));
+  hook_async_op_start(op);
+}
+
+static gboolean
+hook_async_op_needs_device(HookAsyncOp * op) {
+  switch (op->kind) {
+    case HOOK_ASYNC_INJECT_FILE:
+    case HOOK_ASYNC_INJECT_BLOB:
+      return op->path == HOOK_FRIDA_PATH_DEVICE;
+    case HOOK_ASYNC_SPAWN:
+    case HOOK_ASYNC_RESUME:
+      return TRUE;
+    case HOOK_ASYNC_DEMONITOR:
+      break;
+  }
+  return FALSE;
+}
+
+static void
+hook_async_op_start(HookAsyncOp * op) {
+  HookFridaCtx * ctx = op->ctx;
+
+  // The blocking lookup cannot run on the main context; look the device up
+  // asynchronously and start the operation once it is known.
+  if (hook_async_op_needs_device(op) && hook_device_current(ctx) == NULL) {
+    op->lookup_start = g_get_monotonic_time();
+    hook_device_lookup_async(ctx, hook_async_device_found, op);
+    return;
+  }
+
+  switch (op->kind) {
+    case HOOK_ASYNC_INJECT_FILE:
+      if (op->path == HOOK_FRIDA_PATH_DEVICE) {
+        frida_device_inject_library_file(ctx->device, op->target, op->library_path,
+            op->entrypoint, op->data, NULL, hook_async_op_done, op);
+      } else {
+        frida_injector_inject_library_file(ctx->injector, op->target, op->library_path,
+            op->entrypoint, op->data, NULL, hook_async_op_done, op);
+      }
+      break;
+    case HOOK_ASYNC_INJECT_BLOB:
+      if (op->path == HOOK_FRIDA_PATH_DEVICE) {
+        frida_device_inject_library_blob(ctx->device, op->target, op->blob,
+            op->entrypoint, op->data, NULL, hook_async_op_done, op);
+      } else {
+        frida_injector_inject_library_blob(ctx->injector, op->target, op->blob,
+            op->entrypoint, op->data, NULL, hook_async_op_done, op);
+      }
+      break;
+    case HOOK_ASYNC_SPAWN:
+      frida_device_spawn(ctx->device, op->program, op->options, NULL, hook_async_op_done, op);
+      break;
+    case HOOK_ASYNC_RESUME:
+      frida_device_resume(ctx->device, op->target, NULL, hook_async_op_done, op);
+      break;
+    case HOOK_ASYNC_DEMONITOR:
+      // As in hook_frida_demonitor, there is nothing to stop for a device-path id
+      // or without an injector.
+      if (ctx->injector == NULL || op->path == HOOK_FRIDA_PATH_DEVICE) {
+        hook_async_op_complete(op, op->target, NULL);
+        break;
+      }
+      frida_injector_demonitor(ctx->injector, op->target, NULL, hook_async_op_done, op);
+      break;
+  }
+}
+
+static void
+hook_async_op_done(GObject * source, GAsyncResult * res, gpointer user_data) {
+  (void) source;
+  HookAsyncOp * op = user_data;
+  HookFridaCtx * ctx = op->ctx;
+  GError * error = NULL;
+  guint value = 0;
+
+  switch (op->kind) {
+    case HOOK_ASYNC_INJECT_FILE:
+      value = (op->path == HOOK_FRIDA_PATH_DEVICE)
+          ? frida_device_inject_library_file_finish(ctx->device, res, &error)
+          : frida_injector_inject_library_file_finish(ctx->injector, res, &error);
+      break;
+    case HOOK_ASYNC_INJECT_BLOB:
+      value = (op->path == HOOK_FRIDA_PATH_DEVICE)
+          ? frida_device_inject_library_blob_finish(ctx->device, res, &error)
+          : frida_injector_inject_library_blob_finish(ctx->injector, res, &error);
+      break;
+    case HOOK_ASYNC_SPAWN:
+      value = frida_device_spawn_finish(ctx->device, res, &error);
+      if (error == NULL)
+        hook_spawned(ctx, value, op->options);
+      break;
+    case HOOK_ASYNC_RESUME:
+      frida_device_resume_finish(ctx->device, res, &error);
+      value = op->target;
+      break;
+    case HOOK_ASYNC_DEMONITOR:
+      frida_injector_demonitor_finish(ctx->injector, res, &error);
+      value = op->target;
+      break;
+  }
+
+  gboolean is_inject = op->kind == HOOK_ASYNC_INJECT_FILE || op->kind == HOOK_ASYNC_INJECT_BLOB;
+  if (error != NULL && is_inject && !op->retried && hook_should_try_device_fallback(error) &&
+      hook_path_available(ctx, hook_path_other(op->path))) {
+    hook_debug("hook-frida: async inject failed, trying the other injection path");
+    g_error_free(error);
+    op->path = hook_path_other(op->path);
+    op->retried = TRUE;
+    hook_async_op_start(op);
+    return;
+  }
+
+  if (error == NULL && is_inject)
+    hook_strategy_record(ctx, &op->key, op->path);
+
+  hook_async_op_complete(op, value, error);
+  if (error != NULL)
+    g_error_free(error);
+}
+
+static gboolean
+hook_async_op_dispatch(gpointer user_data) {
+  hook_async_op_start(user_data);
+  return G_SOURCE_REMOVE;
+}
+
+static void
+hook_async_op_submit(HookAsyncOp * op) {
+  // Frida's async API must be driven from its own main context.
+  g_main_context_invoke(frida_get_main_context(), hook_async_op_dispatch, op);
+}
+
+static HookAsyncOp *
+hook_async_inject_op_new(HookFridaCtx * ctx,
+    guint pid,
+    const char * library_path,
+    GBytes * blob,
+    const char * entrypoint,
+    const char * data,
+    HookFridaCompletion callback,
+    void * user_data) {
+  HookAsyncOp * op = hook_async_op_new(ctx,
+      blob != NULL ? HOOK_ASYNC_INJECT_BLOB : HOOK_ASYNC_INJECT_FILE, pid, callback, user_data);
+  op->library_path = g_strdup(library_path);
+  op->blob = (blob != NULL) ? g_bytes_ref(blob) : NULL;
+  op->key = hook_target_key(ctx, pid);
+  op->path = hook_strategy_choose(ctx, &op->key);
+  op->entrypoint = g_strdup(entrypoint);
+  op->data = g_strdup(data);
+  return op;
+}
+
+static int
+hook_async_reject(const char * message, int32_t * error_kind_out, char ** error_out) {
+  if (error_kind_out != NULL)
+    *error_kind_out = HOOK_FRIDA_ERROR_INVALID_ARGUMENT;
+  if (error_out != NULL)
+    *error_out = g_strdup(message);
+  return 0;
+}
 
+static int
+hook_async_accept(int32_t * error_kind_out) {
   if (error_kind_out != NULL)
     *error_kind_out = HOOK_FRIDA_ERROR_NONE;
   return 1;
 }
 
+// Shared state for a fan-out injection.
+typedef struct {
+  HookFridaInjectResult * results;
+  size_t pending;
+  GMutex mutex;
+  GCond cond;
+} HookInjectBatch;
+
+typedef struct {
+  HookInjectBatch * batch;
+  size_t index;
+} HookInjectSlot;
+
+static void
+hook_inject_slot_complete(void * user_data, uint32_t value, int32_t path, int32_t error_kind,
+    const char * error) {
+  HookInjectSlot * slot = user_data;
+  HookInjectBatch * batch = slot->batch;
+  HookFridaInjectResult * result = &batch->results[slot->index];
+
+  result->id = value;
+  result->path = path;
+  result->error_kind = error_kind;
+  result->error = (error != NULL) ? g_strdup(error) : NULL;
+
+  g_mutex_lock(&batch->mutex);
+  batch->pending--;
+  if (batch->pending == 0)
+    g_cond_signal(&batch->cond);
+  g_mutex_unlock(&batch->mutex);
+}
+
 int
-hook_frida_spawn(HookFridaCtx * ctx,
-    const char * program,
-    const char * const * argv,
-    const char * const * envp,
-    const char * cwd,
-    int32_t stdio,
-    uint32_t * out_pid,
+hook_frida_inject_many(HookFridaCtx * ctx,
+    const int32_t * pids,
+    size_t pid_count,
+    const char * library_path,
+    const HookFridaBlob * blob,
+    const char * entrypoint,
+    const char * data,
+    HookFridaInjectResult * results,
     int32_t * error_kind_out,
     char ** error_out) {
-  if (ctx == NULL || ctx->device == NULL)
+  // Adopt the blob first so its owner is released on every path. One GBytes
+  // is shared by all targets instead of one copy per injection.
+  GBytes * bytes = hook_blob_bytes_new(blob);
+  if (ctx == NULL) {
+    if (bytes != NULL)
+      g_bytes_unref(bytes);
     return 0;
+  }
 
-  // Spawn the process suspended; caller is responsible for resuming.
-  FridaSpawnOptions * options = frida_spawn_options_new();
-  if (argv != NULL)
-    g_object_set(options, "argv", argv, NULL);
-  if (envp != NULL)
-    g_object_set(options, "envp", envp, NULL);
-  if (cwd != NULL)
-    g_object_set(options, "cwd", cwd, NULL);
-  g_object_set(options, "stdio", stdio, NULL);
+  if ((library_path == NULL) == (bytes == NULL) ||
+      (pid_count != 0 && (pids == NULL || results == NULL))) {
+    if (bytes != NULL)
+      g_bytes_unref(bytes);
+    return hook_async_reject("expected exactly one of library_path or blob", error_kind_out,
+        error_out);
+  }
 
-  GError * error = NULL;
-  guint pid = frida_device_spawn_sync(ctx->device, program, options, NULL, &error);
-  g_object_unref(options);
+  if (pid_count == 0) {
+    if (bytes != NULL)
+      g_bytes_unref(bytes);
+    return hook_async_accept(error_kind_out);
+  }
 
-  if (error != NULL) {
-    hook_set_error(error, error_kind_out, error_out);
-    g_error_free(error);
-    return 0;
+  hook_debug("hook-frida: inject_many starting");
+  // Start every injection at once and wait for the last completion.
+  HookInjectBatch batch = { 0 };
+  batch.results = results;
+  batch.pending = pid_count;
+  g_mutex_init(&batch.mutex);
+  g_cond_init(&batch.cond);
+
+  HookInjectSlot * slots = g_new0(HookInjectSlot, pid_count);
+
+  for (size_t i = 0; i != pid_count; i++) {
+    results[i].pid = pids[i];
+    results[i].id = 0;
+    results[i].path = HOOK_FRIDA_PATH_NONE;
+    results[i].error_kind = HOOK_FRIDA_ERROR_NONE;
+    results[i].error = NULL;
+    slots[i].batch = &batch;
+    slots[i].index = i;
+    hook_async_op_submit(hook_async_inject_op_new(ctx, (guint) pids[i], library_path, bytes,
+        entrypoint, data, hook_inject_slot_complete, &slots[i]));
   }
 
-  if (out_pid != NULL)
-    *out_pid = pid;
+  g_mutex_lock(&batch.mutex);
+  while (batch.pending != 0)
+    g_cond_wait(&batch.cond, &batch.mutex);
+  g_mutex_unlock(&batch.mutex);
+  hook_debug("hook-frida: inject_many finished");
 
-  if (error_kind_out != NULL)
-    *error_kind_out = HOOK_FRIDA_ERROR_NONE;
-  return 1;
+  g_mutex_clear(&batch.mutex);
+  g_cond_clear(&batch.cond);
+  g_free(slots);
+  if (bytes != NULL)
+    g_bytes_unref(bytes);
+  return hook_async_accept(error_kind_out);
 }
 
 int
-hook_frida_resume(HookFridaCtx * ctx,
-    uint32_t pid,
+hook_frida_inject_process_async(HookFridaCtx * ctx,
+    int32_t pid,
+    const char * library_path,
+    const char * entrypoint,
+    const char * data,
+    HookFridaCompletion callback,
+    void * user_data,
     int32_t * error_kind_out,
     char ** error_out) {
-  if (ctx == NULL || ctx->device == NULL)
+  if (ctx == NULL)
     return 0;
+  if (library_path == NULL || callback == NULL)
+    return hook_async_reject("missing library path or callback", error_kind_out, error_out);
 
-  // Resume a process spawned in suspended mode.
-  GError * error = NULL;
-  frida_device_resume_sync(ctx->device, pid, NULL, &error);
+  hook_async_op_submit(hook_async_inject_op_new(ctx, (guint) pid, library_path, NULL,
+      entrypoint, data, callback, user_data));
+  return hook_async_accept(error_kind_out);
+}
 
-  if (error != NULL) {
-    hook_set_error(error, error_kind_out, error_out);
-    g_error_free(error);
+int
+hook_frida_inject_blob_async(HookFridaCtx * ctx,
+    int32_t pid,
+    const HookFridaBlob * blob,
+    const char * entrypoint,
+    const char * data,
+    HookFridaCompletion callback,
+    void * user_data,
+    int32_t * error_kind_out,
+    char ** error_out) {
+  // Adopt the blob first so its owner is released on every path.
+  GBytes * bytes = hook_blob_bytes_new(blob);
+  if (ctx == NULL) {
+    if (bytes != NULL)
+      g_bytes_unref(bytes);
     return 0;
   }
+  if (bytes == NULL || callback == NULL) {
+    if (bytes != NULL)
+      g_bytes_unref(bytes);
+    return hook_async_reject("missing blob or callback", error_kind_out, error_out);
+  }
 
-  if (error_kind_out != NULL)
-    *error_kind_out = HOOK_FRIDA_ERROR_NONE;
-  return 1;
+  hook_async_op_submit(hook_async_inject_op_new(ctx, (guint) pid, NULL, bytes,
+      entrypoint, data, callback, user_data));
+  g_bytes_unref(bytes);
+  return hook_async_accept(error_kind_out);
 }
 
 int
-hook_frida_demonitor(HookFridaCtx * ctx,
+hook_frida_spawn_async(HookFridaCtx * ctx,
+    const char * program,
+    const char * const * argv,
+    const char * const * envp,
+    const char * cwd,
+    int32_t stdio,
+    HookFridaCompletion callback,
+    void * user_data,
+    int32_t * error_kind_out,
+    char ** error_out) {
+  if (ctx == NULL)
+    return 0;
+  if (program == NULL || callback == NULL)
+    return hook_async_reject("missing program or callback", error_kind_out, error_out);
+
+  HookAsyncOp * op = hook_async_op_new(ctx, HOOK_ASYNC_SPAWN, 0, callback, user_data);
+  op->program = g_strdup(program);
+  op->options = hook_spawn_options_new(argv, envp, cwd, stdio);
+  hook_async_op_submit(op);
+  return hook_async_accept(error_kind_out);
+}
+
+int
+hook_frida_resume_async(HookFridaCtx * ctx,
+    uint32_t pid,
+    HookFridaCompletion callback,
+    void * user_data,
+    int32_t * error_kind_out,
+    char ** error_out) {
+  if (ctx == NULL)
+    return 0;
+  if (callback == NULL)
+    return hook_async_reject("missing callback", error_kind_out, error_out);
+
+  hook_async_op_submit(hook_async_op_new(ctx, HOOK_ASYNC_RESUME, pid, callback, user_data));
+  return hook_async_accept(error_kind_out);
+}
+
+int
+hook_frida_demonitor_async(HookFridaCtx * ctx,
     uint32_t id,
+    int32_t path,
+    HookFridaCompletion callback,
+    void * user_data,
     int32_t * error_kind_out,
     char ** error_out) {
-  if (ctx == NULL || ctx->injector == NULL)
+  if (ctx == NULL)
     return 0;
+  if (callback == NULL)
+    return hook_async_reject("missing callback", error_kind_out, error_out);
+
+  HookAsyncOp * op = hook_async_op_new(ctx, HOOK_ASYNC_DEMONITOR, id, callback, user_data);
+  op->path = (HookFridaPath) path;
+  hook_async_op_submit(op);
+  return hook_async_accept(error_kind_out);
+}
+
+int
+hook_frida_enumerate_processes(HookFridaCtx * ctx,
+    const uint32_t * pids,
+    size_t pid_count,
+    int32_t details,
+    HookFridaProcessInfo ** out,
+    size_t * out_count,
+    int32_t * error_kind_out,
+    char ** error_out) {
+  if (ctx == NULL || out == NULL || out_count == NULL ||
+      !hook_require_device(ctx, error_kind_out, error_out))
+    return 0;
+
+  FridaProcessQueryOptions * options = frida_process_query_options_new();
+  for (size_t i = 0; i < pid_count; i++)
+    frida_process_query_options_select_pid(options, pids[i]);
+  frida_process_query_options_set_scope(options,
+      details ? FRIDA_SCOPE_METADATA : FRIDA_SCOPE_MINIMAL);
 
-  // Stop monitoring the injection.
   GError * error = NULL;
-  frida_injector_demonitor_sync(ctx->injector, id, NULL, &error);
+  FridaProcessList * processes =
+      frida_device_enumerate_processes_sync(ctx->device, options, NULL, &error);
+  g_object_unref(options);
 
   if (error != NULL) {
     hook_set_error(error, error_kind_out, error_out);
@@ -396,11 +2107,43 @@ hook_frida_demonitor(HookFridaCtx * ctx,
     return 0;
   }
 
+  gint count = frida_process_list_size(processes);
+  HookFridaProcessInfo * list = g_new0(HookFridaProcessInfo, count > 0 ? count : 1);
+  for (gint i = 0; i < count; i++) {
+    FridaProcess * process = frida_process_list_get(processes, i);
+    HookFridaProcessInfo * info = &list[i];
+    info->pid = frida_process_get_pid(process);
+    info->uid = G_MAXUINT32;
+    info->name = g_strdup(frida_process_get_name(process));
+    if (details) {
+      GVariant * path = g_hash_table_lookup(frida_process_get_parameters(process), "path");
+      if (path != NULL && g_variant_is_of_type(path, G_VARIANT_TYPE_STRING))
+        info->path = g_strdup(g_variant_get_string(path, NULL));
+      info->uid = hook_target_key(ctx, info->pid).uid;
+    }
+    g_object_unref(process);
+  }
+  g_object_unref(processes);
+
+  *out = list;
+  *out_count = (size_t) count;
   if (error_kind_out != NULL)
     *error_kind_out = HOOK_FRIDA_ERROR_NONE;
   return 1;
 }
 
+void
+hook_frida_process_list_free(HookFridaProcessInfo * list, size_t count) {
+  if (list == NULL)
+    return;
+
+  for (size_t i = 0; i < count; i++) {
+    g_free(list[i].name);
+    g_free(list[i].path);
+  }
+  g_free(list);
+}
+
 void
 hook_frida_string_free(char * s) {
   // Free strings returned to Rust.
@@ -17,14 +17,173 @@ typedef enum {
   HOOK_FRIDA_ERROR_NOT_SUPPORTED = 2,
   HOOK_FRIDA_ERROR_PERMISSION_DENIED = 3,
   HOOK_FRIDA_ERROR_PROCESS_NOT_FOUND = 4,
-  HOOK_FRIDA_ERROR_RUNTIME = 5
+  HOOK_FRIDA_ERROR_RUNTIME = 5,
+  // The operation's cancellable was cancelled (explicitly or by a deadline).
+  HOOK_FRIDA_ERROR_CANCELLED = 6
 } HookFridaErrorKind;
 
+// A GCancellable handed to blocking entry points; NULL means "never". One
+// cancellable may be shared by many operations on any thread, and cancelling
+// it makes every pending call it was passed to fail with
+// HOOK_FRIDA_ERROR_CANCELLED.
+typedef struct HookFridaCancellable HookFridaCancellable;
+
+HookFridaCancellable * hook_frida_cancellable_new(void);
+void hook_frida_cancellable_cancel(HookFridaCancellable * cancellable);
+int hook_frida_cancellable_is_cancelled(HookFridaCancellable * cancellable);
+void hook_frida_cancellable_free(HookFridaCancellable * cancellable);
+
+// Which Frida mechanism performed an injection.
+typedef enum {
+  HOOK_FRIDA_PATH_NONE = 0,
+  // FridaInjector (helper or in-process).
+  HOOK_FRIDA_PATH_INJECTOR = 1,
+  // frida_device_inject_library_* on the context's device.
+  HOOK_FRIDA_PATH_DEVICE = 2
+} HookFridaPath;
+
+// Releases the owner of a borrowed blob once GLib drops its last reference.
+typedef void (* HookFridaRelease) (void * owner);
+
+// In-memory library payload lent by the caller without copying. Passing a blob
+// to the shim transfers `owner`: `release(owner)` runs exactly once, possibly
+// on another thread, after the shim is done with `data`. A NULL `release`
+// makes the shim copy `data` instead.
+typedef struct {
+  const uint8_t * data;
+  size_t len;
+  HookFridaRelease release;
+  void * owner;
+} HookFridaBlob;
+
+// Wall-clock microseconds spent in each backend start-up phase.
+typedef struct {
+  uint64_t frida_init_us;
+  uint64_t injector_us;
+  // Device manager creation + local device lookup, on first use.
+  uint64_t device_lookup_us;
+  // Filled in by hook_frida_warm_up only.
+  uint64_t helper_us;
+  uint64_t host_session_us;
+} HookFridaStartupStats;
+
+// Per-operation phase timings in microseconds. Callers pass NULL to skip
+// collection entirely; phases an operation does not have stay 0.
+typedef struct {
+  uint64_t spawn_us;
+  // First injection attempt, on the path chosen by the strategy cache.
+  uint64_t inject_us;
+  // Second attempt on the other path, if the first was refused.
+  uint64_t fallback_us;
+  uint64_t resume_us;
+  uint64_t total_us;
+  // Device lookups this operation had to wait for, on first use or after
+  // the connection was lost. Included in the phase that needed the device.
+  uint64_t device_lookup_us;
+  // Blob size in bytes; 0 for path libraries.
+  uint64_t payload_len;
+  // HookFridaPath of the last attempt.
+  int32_t path;
+  int32_t fell_back;
+} HookFridaOpStats;
+
+// Called on Frida's event thread when an injected library unloads or its
+// target exits. `path` is the HookFridaPath that produced `id`.
+typedef void (*HookFridaUninjected)(void * user_data, uint32_t id, int32_t path);
+
+// Stdio modes for spawn options, as passed by Rust. Frida itself only pipes
+// or inherits: NULL children are piped and their output is never reported.
+typedef enum {
+  HOOK_FRIDA_STDIO_INHERIT = 0,
+  HOOK_FRIDA_STDIO_NULL = 1,
+  HOOK_FRIDA_STDIO_PIPE = 2,
+} HookFridaStdio;
+
+// Called with output from a child spawned with HOOK_FRIDA_STDIO_PIPE. `fd` is
+// 1 or 2 and an empty chunk marks the end of that stream. Before any output,
+// usually on the spawning thread and before the child is resumed, the handler
+// gets fd 0 with no data: the pid now belongs to a new piped child.
+typedef void (*HookFridaOutput)(void * user_data,
+    uint32_t pid,
+    int32_t fd,
+    const uint8_t * data,
+    size_t len);
+
+// Child gating events, delivered on Frida's event thread.
+typedef enum {
+  HOOK_FRIDA_CHILD_FORK = 0,
+  HOOK_FRIDA_CHILD_EXEC = 1,
+  HOOK_FRIDA_CHILD_SPAWN = 2,
+  // The gating session of `pid` ended (target exited, exec'd or detached).
+  HOOK_FRIDA_CHILD_GATING_ENDED = -1
+} HookFridaChildEventKind;
+
+// For fork/exec/spawn the child `pid` stays suspended until resumed.
+typedef void (*HookFridaChildEvent)(void * user_data,
+    uint32_t pid,
+    uint32_t parent_pid,
+    int32_t kind);
+
+// Device a context is bound to.
+typedef enum {
+  HOOK_FRIDA_DEVICE_LOCAL = 0,
+  // frida-server reached over TCP; `address` is "host[:port]".
+  HOOK_FRIDA_DEVICE_REMOTE = 1,
+  // The first USB device.
+  HOOK_FRIDA_DEVICE_USB = 2,
+  // Any device by Frida id (e.g. a USB serial); `address` is the id.
+  HOOK_FRIDA_DEVICE_ID = 3
+} HookFridaDeviceKind;
+
 // Create a Frida injector context for the local device.
 HookFridaCtx * hook_frida_new(int32_t * error_kind_out, char ** error_out);
-// Release all Frida resources held by the context.
+// Create a context bound to one device. Non-local contexts have no injector:
+// every injection uses the device path, and demonitor is a no-op. The device
+// is connected on first use and reconnected after its connection is lost;
+// USB and id lookups wait up to `timeout_ms` for the device to appear.
+HookFridaCtx * hook_frida_new_device(int32_t kind,
+    const char * address,
+    int32_t timeout_ms,
+    int32_t * error_kind_out,
+    char ** error_out);
+// Disconnect the context's handlers and release it. Async operations still
+// in flight keep the rest alive until their callbacks have run.
 void hook_frida_free(HookFridaCtx * ctx);
 
+// Install the handler for "uninjected" signals from the injector and device.
+// A NULL handler disconnects; the previous handler is replaced.
+void hook_frida_set_uninjected_handler(HookFridaCtx * ctx,
+    HookFridaUninjected handler,
+    void * user_data);
+
+// Install the handler for the device "output" signal. A NULL handler
+// disconnects; the previous handler is replaced.
+void hook_frida_set_output_handler(HookFridaCtx * ctx,
+    HookFridaOutput handler,
+    void * user_data);
+
+// Install the handler for child gating events. A NULL handler disconnects;
+// the previous handler is replaced.
+void hook_frida_set_child_handler(HookFridaCtx * ctx,
+    HookFridaChildEvent handler,
+    void * user_data);
+
+// Shim allocations currently alive across every context, for leak checks.
+typedef struct {
+  uint64_t contexts;
+  // Async operations submitted but not yet completed and freed.
+  uint64_t async_ops;
+} HookFridaLiveCounts;
+
+void hook_frida_live_counts(HookFridaLiveCounts * out);
+
+// Eagerly start the injector helper and the local host session so the first
+// injection does not pay for them; reports every start-up phase.
+int hook_frida_warm_up(HookFridaCtx * ctx,
+    HookFridaStartupStats * stats_out,
+    int32_t * error_kind_out,
+    char ** error_out);
+
 // Inject a library file into an existing process.
 int hook_frida_inject_process(HookFridaCtx * ctx,
     int32_t pid,
@@ -32,17 +191,45 @@ int hook_frida_inject_process(HookFridaCtx * ctx,
     const char * entrypoint,
     const char * data,
     uint32_t * out_id,
+    int32_t * path_out,
+    HookFridaOpStats * stats_out,
+    HookFridaCancellable * cancellable,
     int32_t * error_kind_out,
     char ** error_out);
 
 // Inject an in-memory library blob into an existing process.
 int hook_frida_inject_blob(HookFridaCtx * ctx,
     int32_t pid,
-    const uint8_t * blob,
-    size_t blob_len,
+    const HookFridaBlob * blob,
     const char * entrypoint,
     const char * data,
     uint32_t * out_id,
+    int32_t * path_out,
+    HookFridaOpStats * stats_out,
+    HookFridaCancellable * cancellable,
+    int32_t * error_kind_out,
+    char ** error_out);
+
+// Per-target outcome of hook_frida_inject_many.
+typedef struct {
+  int32_t pid;
+  uint32_t id;
+  int32_t path;
+  int32_t error_kind;
+  char * error;
+} HookFridaInjectResult;
+
+// Inject one library (file path or blob) into many processes concurrently.
+// `results` must hold `pid_count` entries; each error string must be released
+// with hook_frida_string_free.
+int hook_frida_inject_many(HookFridaCtx * ctx,
+    const int32_t * pids,
+    size_t pid_count,
+    const char * library_path,
+    const HookFridaBlob * blob,
+    const char * entrypoint,
+    const char * data,
+    HookFridaInjectResult * results,
     int32_t * error_kind_out,
     char ** error_out);
 
@@ -58,6 +245,27 @@ int hook_frida_inject_launch(HookFridaCtx * ctx,
     const char * data,
     uint32_t * out_pid,
     uint32_t * out_id,
+    int32_t * path_out,
+    HookFridaOpStats * stats_out,
+    HookFridaCancellable * cancellable,
+    int32_t * error_kind_out,
+    char ** error_out);
+
+// Spawn a process suspended, inject an in-memory library blob, then resume it.
+int hook_frida_inject_launch_blob(HookFridaCtx * ctx,
+    const char * program,
+    const char * const * argv,
+    const char * const * envp,
+    const char * cwd,
+    int32_t stdio,
+    const HookFridaBlob * blob,
+    const char * entrypoint,
+    const char * data,
+    uint32_t * out_pid,
+    uint32_t * out_id,
+    int32_t * path_out,
+    HookFridaOpStats * stats_out,
+    HookFridaCancellable * cancellable,
     int32_t * error_kind_out,
     char ** error_out);
 
@@ -69,21 +277,182 @@ int hook_frida_spawn(HookFridaCtx * ctx,
     const char * cwd,
     int32_t stdio,
     uint32_t * out_pid,
+    HookFridaCancellable * cancellable,
+    int32_t * error_kind_out,
+    char ** error_out);
+
+// Launch spec whose argv/envp/cwd and Frida spawn options are marshalled once
+// and reused by every launch. Immutable, so it can be shared across threads.
+typedef struct HookFridaSpawnSpec HookFridaSpawnSpec;
+
+// Copy a launch spec; argv includes argv[0]. Returns NULL without program/argv.
+HookFridaSpawnSpec * hook_frida_spawn_spec_new(const char * program,
+    const char * const * argv,
+    const char * const * envp,
+    const char * cwd,
+    int32_t stdio);
+
+void hook_frida_spawn_spec_free(HookFridaSpawnSpec * spec);
+
+// Spawn a prepared spec suspended. `extra_argv` is appended to its argv and
+// KEY=VALUE entries in `extra_envp` replace or add variables; either may be
+// NULL, in which case the prepared spawn options are reused as they are.
+int hook_frida_spawn_prepared(HookFridaCtx * ctx,
+    const HookFridaSpawnSpec * spec,
+    const char * const * extra_argv,
+    const char * const * extra_envp,
+    uint32_t * out_pid,
+    HookFridaCancellable * cancellable,
+    int32_t * error_kind_out,
+    char ** error_out);
+
+// Spawn a prepared spec suspended, inject, then resume it. Exactly one of
+// `library_path` and `blob` must be set; the blob is adopted as usual.
+int hook_frida_inject_launch_prepared(HookFridaCtx * ctx,
+    const HookFridaSpawnSpec * spec,
+    const char * const * extra_argv,
+    const char * const * extra_envp,
+    const char * library_path,
+    const HookFridaBlob * blob,
+    const char * entrypoint,
+    const char * data,
+    uint32_t * out_pid,
+    uint32_t * out_id,
+    int32_t * path_out,
+    HookFridaOpStats * stats_out,
+    HookFridaCancellable * cancellable,
     int32_t * error_kind_out,
     char ** error_out);
 
 // Resume a suspended process previously spawned by Frida.
 int hook_frida_resume(HookFridaCtx * ctx,
+    uint32_t pid,
+    HookFridaCancellable * cancellable,
+    int32_t * error_kind_out,
+    char ** error_out);
+
+// Kill a process, typically a suspended child whose injection failed.
+int hook_frida_kill(HookFridaCtx * ctx,
+    uint32_t pid,
+    int32_t * error_kind_out,
+    char ** error_out);
+
+// Attach to `pid` and hold every child it creates until it is resumed.
+// Enabling twice is a no-op.
+int hook_frida_enable_child_gating(HookFridaCtx * ctx,
     uint32_t pid,
     int32_t * error_kind_out,
     char ** error_out);
 
-// Stop monitoring a previously injected library.
+// Detach the gating session of `pid`, if any; held children are released.
+int hook_frida_disable_child_gating(HookFridaCtx * ctx,
+    uint32_t pid,
+    int32_t * error_kind_out,
+    char ** error_out);
+
+// Write to the stdin of a child spawned with piped stdio.
+int hook_frida_input(HookFridaCtx * ctx,
+    uint32_t pid,
+    const uint8_t * data,
+    size_t len,
+    int32_t * error_kind_out,
+    char ** error_out);
+
+// Stop monitoring a previously injected library. `path` is the HookFridaPath that
+// produced `id`; device-path ids are not monitored, so demonitoring one is a no-op.
 int hook_frida_demonitor(HookFridaCtx * ctx,
     uint32_t id,
+    int32_t path,
+    HookFridaCancellable * cancellable,
+    int32_t * error_kind_out,
+    char ** error_out);
+
+// Completion callback for the *_async entry points. It runs exactly once on
+// Frida's main-context thread; `value` carries the injection id or pid, `path`
+// the HookFridaPath used by injections, and `error` is only valid for the
+// duration of the call.
+typedef void (* HookFridaCompletion) (void * user_data,
+    uint32_t value,
+    int32_t path,
+    int32_t error_kind,
+    const char * error);
+
+// Start injecting a library file; returns 0 without calling `callback` if the
+// request could not be submitted.
+int hook_frida_inject_process_async(HookFridaCtx * ctx,
+    int32_t pid,
+    const char * library_path,
+    const char * entrypoint,
+    const char * data,
+    HookFridaCompletion callback,
+    void * user_data,
+    int32_t * error_kind_out,
+    char ** error_out);
+
+// Start injecting an in-memory library blob.
+int hook_frida_inject_blob_async(HookFridaCtx * ctx,
+    int32_t pid,
+    const HookFridaBlob * blob,
+    const char * entrypoint,
+    const char * data,
+    HookFridaCompletion callback,
+    void * user_data,
+    int32_t * error_kind_out,
+    char ** error_out);
+
+// Start spawning a process suspended; completes with its pid.
+int hook_frida_spawn_async(HookFridaCtx * ctx,
+    const char * program,
+    const char * const * argv,
+    const char * const * envp,
+    const char * cwd,
+    int32_t stdio,
+    HookFridaCompletion callback,
+    void * user_data,
+    int32_t * error_kind_out,
+    char ** error_out);
+
+// Start resuming a suspended process.
+int hook_frida_resume_async(HookFridaCtx * ctx,
+    uint32_t pid,
+    HookFridaCompletion callback,
+    void * user_data,
+    int32_t * error_kind_out,
+    char ** error_out);
+
+// Start demonitoring a previously injected library; `path` as in hook_frida_demonitor.
+int hook_frida_demonitor_async(HookFridaCtx * ctx,
+    uint32_t id,
+    int32_t path,
+    HookFridaCompletion callback,
+    void * user_data,
     int32_t * error_kind_out,
     char ** error_out);
 
+// One entry of hook_frida_enumerate_processes.
+typedef struct {
+  uint32_t pid;
+  // Owner uid, or UINT32_MAX when unknown or not requested.
+  uint32_t uid;
+  char * name;
+  // Executable path; NULL unless details were requested and Frida knows it.
+  char * path;
+} HookFridaProcessInfo;
+
+// List processes on the local device. With `pid_count` > 0 only those pids
+// are queried. `details` adds path and uid at extra cost. Release the list
+// with hook_frida_process_list_free.
+int hook_frida_enumerate_processes(HookFridaCtx * ctx,
+    const uint32_t * pids,
+    size_t pid_count,
+    int32_t details,
+    HookFridaProcessInfo ** out,
+    size_t * out_count,
+    int32_t * error_kind_out,
+    char ** error_out);
+
+void hook_frida_process_list_free(HookFridaProcessInfo * list, size_t count);
+
 // Free error strings returned by this shim.
 void hook_frida_string_free(char * s);
 
@@ -1,19 +1,163 @@
-use std::ffi::{CStr, CString, OsStr};
+use std::collections::{HashMap, VecDeque};
+use std::ffi::{CStr, CString, OsStr, OsString, c_void};
+use std::future::Future;
 use std::os::raw::{c_char, c_int};
+use std::path::PathBuf;
+use std::pin::Pin;
 use std::ptr;
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::sync::{Arc, Mutex};
+use std::task::{Context, Poll, Wake, Waker};
+use std::thread::Thread;
+use std::time::Duration;
 
-use crate::library::LibrarySource;
-use crate::{Error, Library, Process, Program, Result, Stdio};
+use crate::gating::{ChildEvent, GatingRegistry};
+use crate::library::{LibrarySource, Payload};
+use crate::metrics::{self, InjectionMetrics, InjectionOp};
+use crate::stdio::{OutputClaim, OutputRegistry};
+use crate::{
+    Cancellation, ChildOrigin, DeviceTarget, Error, InjectionPath, Library, LiveObjects, Process,
+    Program, Result, Stdio, WarmUpReport,
+};
 
 #[repr(C)]
 struct HookFridaCtx {
     _private: [u8; 0],
 }
 
+#[repr(C)]
+struct HookFridaSpawnSpec {
+    _private: [u8; 0],
+}
+
+#[repr(C)]
+struct HookFridaCancellable {
+    _private: [u8; 0],
+}
+
+#[repr(C)]
+#[derive(Default)]
+struct HookFridaOpStats {
+    spawn_us: u64,
+    inject_us: u64,
+    fallback_us: u64,
+    resume_us: u64,
+    total_us: u64,
+    device_lookup_us: u64,
+    payload_len: u64,
+    path: c_int,
+    fell_back: c_int,
+}
+
+type HookFridaUninjected = unsafe extern "C" fn(user_data: *mut c_void, id: u32, path: c_int);
+
+type HookFridaChildEvent =
+    unsafe extern "C" fn(user_data: *mut c_void, pid: u32, parent_pid: u32, kind: c_int);
+
+type HookFridaOutput =
+    unsafe extern "C" fn(user_data: *mut c_void, pid: u32, fd: c_int, data: *const u8, len: usize);
+
+#[repr(C)]
+#[derive(Default)]
+struct HookFridaLiveCounts {
+    contexts: u64,
+    async_ops: u64,
+}
+
+#[repr(C)]
+#[derive(Default)]
+struct HookFridaStartupStats {
+    frida_init_us: u64,
+    injector_us: u64,
+    device_lookup_us: u64,
+    helper_us: u64,
+    host_session_us: u64,
+}
+
+#[repr(C)]
+struct HookFridaProcessInfo {
+    pid: u32,
+    uid: u32,
+    name: *mut c_char,
+    path: *mut c_char,
+}
+
+type HookFridaRelease = unsafe extern "C" fn(owner: *mut c_void);
+
+#[repr(C)]
+struct HookFridaBlob {
+    data: *const u8,
+    len: usize,
+    release: Option<HookFridaRelease>,
+    owner: *mut c_void,
+}
+
+#[repr(C)]
+struct HookFridaInjectResult {
+    pid: i32,
+    id: u32,
+    path: c_int,
+    error_kind: c_int,
+    error: *mut c_char,
+}
+
+type HookFridaCompletion = unsafe extern "C" fn(
+    user_data: *mut c_void,
+    value: u32,
+    path: c_int,
+    error_kind: c_int,
+    error: *const c_char,
+);
+
 unsafe extern "C" {
     fn hook_frida_new(error_kind_out: *mut c_int, error_out: *mut *mut c_char)
     -> *mut HookFridaCtx;
+    fn hook_frida_new_device(
+        kind: c_int,
+        address: *const c_char,
+        timeout_ms: i32,
+        error_kind_out: *mut c_int,
+        error_out: *mut *mut c_char,
+    ) -> *mut HookFridaCtx;
     fn hook_frida_free(ctx: *mut HookFridaCtx);
+    fn hook_frida_live_counts(out: *mut HookFridaLiveCounts);
+
+    fn hook_frida_set_uninjected_handler(
+        ctx: *mut HookFridaCtx,
+        handler: Option<HookFridaUninjected>,
+        user_data: *mut c_void,
+    );
+
+    fn hook_frida_set_output_handler(
+        ctx: *mut HookFridaCtx,
+        handler: Option<HookFridaOutput>,
+        user_data: *mut c_void,
+    );
+
+    fn hook_frida_set_child_handler(
+        ctx: *mut HookFridaCtx,
+        handler: Option<HookFridaChildEvent>,
+        user_data: *mut c_void,
+    );
+
+    fn hook_frida_warm_up(
+        ctx: *mut HookFridaCtx,
+        stats_out: *mut HookFridaStartupStats,
+        error_kind_out: *mut c_int,
+        error_out: *mut *mut c_char,
+    ) -> c_int;
+
+    fn hook_frida_enumerate_processes(
+        ctx: *mut HookFridaCtx,
+        pids: *const u32,
+        pid_count: usize,
+        details: c_int,
+        out: *mut *mut HookFridaProcessInfo,
+        out_count: *mut usize,
+        error_kind_out: *mut c_int,
+        error_out: *mut *mut c_char,
+    ) -> c_int;
+    fn hook_frida_process_list_free(list: *mut HookFridaProcessInfo, count: usize);
 
     fn hook_frida_inject_process(
         ctx: *mut HookFridaCtx,
@@ -22,6 +166,9 @@ unsafe extern "C" {
         entrypoint: *const c_char,
         data: *const c_char,
         out_id: *mut u32,
+        path_out: *mut c_int,
+        stats_out: *mut HookFridaOpStats,
+        cancellable: *mut HookFridaCancellable,
         error_kind_out: *mut c_int,
         error_out: *mut *mut c_char,
     ) -> c_int;
@@ -29,11 +176,26 @@ unsafe extern "C" {
     fn hook_frida_inject_blob(
         ctx: *mut HookFridaCtx,
         pid: i32,
-        blob: *const u8,
-        blob_len: usize,
+        blob: *const HookFridaBlob,
         entrypoint: *const c_char,
         data: *const c_char,
         out_id: *mut u32,
+        path_out: *mut c_int,
+        stats_out: *mut HookFridaOpStats,
+        cancellable: *mut HookFridaCancellable,
+        error_kind_out: *mut c_int,
+        error_out: *mut *mut c_char,
+    ) -> c_int;
+
+    fn hook_frida_inject_many(
+        ctx: *mut HookFridaCtx,
+        pids: *const i32,
+        pid_count: usize,
+        library_path: *const c_char,
+        blob: *const HookFridaBlob,
+        entrypoint: *const c_char,
+        data: *const c_char,
+        results: *mut HookFridaInjectResult,
         error_kind_out: *mut c_int,
         error_out: *mut *mut c_char,
     ) -> c_int;
@@ -50,6 +212,28 @@ unsafe extern "C" {
         data: *const c_char,
         out_pid: *mut u32,
         out_id: *mut u32,
+        path_out: *mut c_int,
+        stats_out: *mut HookFridaOpStats,
+        cancellable: *mut HookFridaCancellable,
+        error_kind_out: *mut c_int,
+        error_out: *mut *mut c_char,
+    ) -> c_int;
+
+    fn hook_frida_inject_launch_blob(
+        ctx: *mut HookFridaCtx,
+        program: *const c_char,
+        argv: *const *const c_char,
+        envp: *const *const c_char,
+        cwd: *const c_char,
+        stdio: i32,
+        blob: *const HookFridaBlob,
+        entrypoint: *const c_char,
+        data: *const c_char,
+        out_pid: *mut u32,
+        out_id: *mut u32,
+        path_out: *mut c_int,
+        stats_out: *mut HookFridaOpStats,
+        cancellable: *mut HookFridaCancellable,
         error_kind_out: *mut c_int,
         error_out: *mut *mut c_char,
     ) -> c_int;
@@ -62,6 +246,46 @@ unsafe extern "C" {
         cwd: *const c_char,
         stdio: i32,
         out_pid: *mut u32,
+        cancellable: *mut HookFridaCancellable,
+        error_kind_out: *mut c_int,
+        error_out: *mut *mut c_char,
+    ) -> c_int;
+
+    fn hook_frida_spawn_spec_new(
+        program: *const c_char,
+        argv: *const *const c_char,
+        envp: *const *const c_char,
+        cwd: *const c_char,
+        stdio: i32,
+    ) -> *mut HookFridaSpawnSpec;
+
+    fn hook_frida_spawn_spec_free(spec: *mut HookFridaSpawnSpec);
+
+    fn hook_frida_spawn_prepared(
+        ctx: *mut HookFridaCtx,
+        spec: *const HookFridaSpawnSpec,
+        extra_argv: *const *const c_char,
+        extra_envp: *const *const c_char,
+        out_pid: *mut u32,
+        cancellable: *mut HookFridaCancellable,
+        error_kind_out: *mut c_int,
+        error_out: *mut *mut c_char,
+    ) -> c_int;
+
+    fn hook_frida_inject_launch_prepared(
+        ctx: *mut HookFridaCtx,
+        spec: *const HookFridaSpawnSpec,
+        extra_argv: *const *const c_char,
+        extra_envp: *const *const c_char,
+        library_path: *const c_char,
+        blob: *const HookFridaBlob,
+        entrypoint: *const c_char,
+        data: *const c_char,
+        out_pid: *mut u32,
+        out_id: *mut u32,
+        path_out: *mut c_int,
+        stats_out: *mut HookFridaOpStats,
+        cancellable: *mut HookFridaCancellable,
         error_kind_out: *mut c_int,
         error_out: *mut *mut c_char,
     ) -> c_int;
@@ -69,6 +293,37 @@ unsafe extern "C" {
     fn hook_frida_resume(
         ctx: *mut HookFridaCtx,
         pid: u32,
+        cancellable: *mut HookFridaCancellable,
+        error_kind_out: *mut c_int,
+        error_out: *mut *mut c_char,
+    ) -> c_int;
+
+    fn hook_frida_kill(
+        ctx: *mut HookFridaCtx,
+        pid: u32,
+        error_kind_out: *mut c_int,
+        error_out: *mut *mut c_char,
+    ) -> c_int;
+
+    fn hook_frida_enable_child_gating(
+        ctx: *mut HookFridaCtx,
+        pid: u32,
+        error_kind_out: *mut c_int,
+        error_out: *mut *mut c_char,
+    ) -> c_int;
+
+    fn hook_frida_disable_child_gating(
+        ctx: *mut HookFridaCtx,
+        pid: u32,
+        error_kind_out: *mut c_int,
+        error_out: *mut *mut c_char,
+    ) -> c_int;
+
+    fn hook_frida_input(
+        ctx: *mut HookFridaCtx,
+        pid: u32,
+        data: *const u8,
+        len: usize,
         error_kind_out: *mut c_int,
         error_out: *mut *mut c_char,
     ) -> c_int;
@@ -76,9 +331,73 @@ unsafe extern "C" {
     fn hook_frida_demonitor(
         ctx: *mut HookFridaCtx,
         id: u32,
+        path: c_int,
+        cancellable: *mut HookFridaCancellable,
+        error_kind_out: *mut c_int,
+        error_out: *mut *mut c_char,
+    ) -> c_int;
+
+    fn hook_frida_inject_process_async(
+        ctx: *mut HookFridaCtx,
+        pid: i32,
+        library_path: *const c_char,
+        entrypoint: *const c_char,
+        data: *const c_char,
+        callback: HookFridaCompletion,
+        user_data: *mut c_void,
+        error_kind_out: *mut c_int,
+        error_out: *mut *mut c_char,
+    ) -> c_int;
+
+    fn hook_frida_inject_blob_async(
+        ctx: *mut HookFridaCtx,
+        pid: i32,
+        blob: *const HookFridaBlob,
+        entrypoint: *const c_char,
+        data: *const c_char,
+        callback: HookFridaCompletion,
+        user_data: *mut c_void,
+        error_kind_out: *mut c_int,
+        error_out: *mut *mut c_char,
+    ) -> c_int;
+
+    fn hook_frida_spawn_async(
+        ctx: *mut HookFridaCtx,
+        program: *const c_char,
+        argv: *const *const c_char,
+        envp: *const *const c_char,
+        cwd: *const c_char,
+        stdio: i32,
+        callback: HookFridaCompletion,
+        user_data: *mut c_void,
+        error_kind_out: *mut c_int,
+        error_out: *mut *mut c_char,
+    ) -> c_int;
+
+    fn hook_frida_resume_async(
+        ctx: *mut HookFridaCtx,
+        pid: u32,
+        callback: HookFridaCompletion,
+        user_data: *mut c_void,
+        error_kind_out: *mut c_int,
+        error_out: *mut *mut c_char,
+    ) -> c_int;
+
+    fn hook_frida_demonitor_async(
+        ctx: *mut HookFridaCtx,
+        id: u32,
+        path: c_int,
+        callback: HookFridaCompletion,
+        user_data: *mut c_void,
         error_kind_out: *mut c_int,
         error_out: *mut *mut c_char,
     ) -> c_int;
+
+    fn hook_frida_cancellable_new() -> *mut HookFridaCancellable;
+    fn hook_frida_cancellable_cancel(cancellable: *mut HookFridaCancellable);
+    fn hook_frida_cancellable_is_cancelled(cancellable: *mut HookFridaCancellable) -> c_int;
+    fn hook_frida_cancellable_free(cancellable: *mut HookFridaCancellable);
+
     fn hook_frida_string_free(s: *mut c_char);
 }
 
@@ -94,13 +413,204 @@ pub(crate) fn init() -> Result<FridaBackend> {
             let msg = read_error(err_ptr);
             return Err(Error::runtime_unavailable(msg));
         }
+        Ok(adopt_ctx(ctx))
+    }
+}
 
-        Ok(FridaBackend { ctx })
+/// Create a backend bound to `target`; the device is connected on first use.
+pub(crate) fn init_device(target: &DeviceTarget, timeout: Duration) -> Result<FridaBackend> {
+    let (kind, address) = match target {
+        DeviceTarget::Local => (HOOK_FRIDA_DEVICE_LOCAL, None),
+        DeviceTarget::Usb => (HOOK_FRIDA_DEVICE_USB, None),
+        DeviceTarget::Remote(address) => (
+            HOOK_FRIDA_DEVICE_REMOTE,
+            Some(os_str_to_cstring(address, "device address")?),
+        ),
+        DeviceTarget::Id(id) => (
+            HOOK_FRIDA_DEVICE_ID,
+            Some(os_str_to_cstring(id, "device id")?),
+        ),
+    };
+    let timeout_ms = i32::try_from(timeout.as_millis()).unwrap_or(i32::MAX);
+    unsafe {
+        let mut err_ptr: *mut c_char = ptr::null_mut();
+        let mut err_kind: c_int = HOOK_FRIDA_ERROR_NONE;
+        let ctx = hook_frida_new_device(
+            kind,
+            address
+                .as_ref()
+                .map_or(ptr::null(), |address| address.as_ptr()),
+            timeout_ms,
+            &mut err_kind as *mut c_int,
+            &mut err_ptr as *mut *mut c_char,
+        );
+        if ctx.is_null() {
+            if err_kind == HOOK_FRIDA_ERROR_INVALID_ARGUMENT {
+                return Err(new_frida_error(err_kind, err_ptr, None));
+            }
+            let msg = read_error(err_ptr);
+            return Err(Error::runtime_unavailable(msg));
+        }
+        Ok(adopt_ctx(ctx))
+    }
+}
+
+/// Register the event handlers of a fresh context and take ownership of it.
+unsafe fn adopt_ctx(ctx: *mut HookFridaCtx) -> FridaBackend {
+    unsafe {
+        // The handler is disconnected by hook_frida_free, before `watches` drops.
+        let watches = Arc::new(Watches::default());
+        hook_frida_set_uninjected_handler(
+            ctx,
+            Some(uninjected_callback),
+            Arc::as_ptr(&watches) as *mut c_void,
+        );
+
+        let outputs = Arc::new(OutputRegistry::default());
+        hook_frida_set_output_handler(
+            ctx,
+            Some(output_callback),
+            Arc::as_ptr(&outputs) as *mut c_void,
+        );
+
+        let gating = Arc::new(GatingRegistry::default());
+        hook_frida_set_child_handler(
+            ctx,
+            Some(child_callback),
+            Arc::as_ptr(&gating) as *mut c_void,
+        );
+
+        FridaBackend {
+            ctx,
+            watches,
+            outputs,
+            gating,
+        }
     }
 }
 
 pub(super) struct FridaBackend {
     ctx: *mut HookFridaCtx,
+    watches: Arc<Watches>,
+    outputs: Arc<OutputRegistry>,
+    gating: Arc<GatingRegistry>,
+}
+
+type UninjectedCallback = Box<dyn FnOnce() + Send>;
+
+/// Unloads nobody was watching yet, kept for a late watcher; the oldest are
+/// forgotten beyond this.
+const FIRED_LIMIT: usize = 256;
+
+type WatchKey = (InjectionPath, u32);
+
+/// Callbacks waiting for an injection to unload, keyed by path and id.
+#[derive(Default)]
+struct Watches {
+    state: Mutex<WatchState>,
+}
+
+#[derive(Default)]
+struct WatchState {
+    watches: HashMap<WatchKey, Watch>,
+    /// Keys recorded as `Fired`, oldest first. May name keys already taken.
+    fired: VecDeque<WatchKey>,
+}
+
+enum Watch {
+    Pending(Vec<UninjectedCallback>),
+    /// Unloaded before anyone asked; the next watcher runs immediately.
+    Fired,
+}
+
+impl Watches {
+    fn watch(&self, key: WatchKey, callback: UninjectedCallback) {
+        let mut state = self.state.lock().unwrap_or_else(|err| err.into_inner());
+        match state.watches.get_mut(&key) {
+            Some(Watch::Pending(callbacks)) => callbacks.push(callback),
+            Some(Watch::Fired) => {
+                state.watches.remove(&key);
+                drop(state);
+                run_uninjected(callback);
+            }
+            None => {
+                state.watches.insert(key, Watch::Pending(vec![callback]));
+            }
+        }
+    }
+
+    fn fire(&self, key: WatchKey) {
+        let mut state = self.state.lock().unwrap_or_else(|err| err.into_inner());
+        match state.watches.remove(&key) {
+            Some(Watch::Pending(callbacks)) => {
+                drop(state);
+                callbacks.into_iter().for_each(run_uninjected);
+            }
+            _ => {
+                state.watches.insert(key, Watch::Fired);
+                state.fired.push_back(key);
+                while state.fired.len() > FIRED_LIMIT {
+                    let oldest = state.fired.pop_front().expect("fired is not empty");
+                    if matches!(state.watches.get(&oldest), Some(Watch::Fired)) {
+                        state.watches.remove(&oldest);
+                    }
+                }
+            }
+        }
+    }
+
+    /// Forget an injection that was demonitored. Frida reports nothing for
+    /// it from now on, so waiting callbacks run here instead.
+    fn release(&self, key: WatchKey) {
+        let mut state = self.state.lock().unwrap_or_else(|err| err.into_inner());
+        if let Some(Watch::Pending(callbacks)) = state.watches.remove(&key) {
+            drop(state);
+            callbacks.into_iter().for_each(run_uninjected);
+        }
+    }
+}
+
+fn run_uninjected(callback: UninjectedCallback) {
+    // Callbacks run on Frida's event thread; a panic must not unwind into C.
+    let _ = std::panic::catch_unwind(std::panic::AssertUnwindSafe(callback));
+}
+
+unsafe extern "C" fn uninjected_callback(user_data: *mut c_void, id: u32, path: c_int) {
+    let watches = unsafe { &*(user_data as *const Watches) };
+    watches.fire((map_path(path), id));
+}
+
+unsafe extern "C" fn output_callback(
+    user_data: *mut c_void,
+    pid: u32,
+    fd: c_int,
+    data: *const u8,
+    len: usize,
+) {
+    let outputs = unsafe { &*(user_data as *const OutputRegistry) };
+    let data = if data.is_null() || len == 0 {
+        &[][..]
+    } else {
+        unsafe { std::slice::from_raw_parts(data, len) }
+    };
+    // Runs on Frida's event thread; a panic must not unwind into C.
+    let _ = std::panic::catch_unwind(|| outputs.push(pid, fd, data));
+}
+
+unsafe extern "C" fn child_callback(
+    user_data: *mut c_void,
+    pid: u32,
+    parent_pid: u32,
+    kind: c_int,
+) {
+    let gating = unsafe { &*(user_data as *const GatingRegistry) };
+    let event = match kind {
+        HOOK_FRIDA_CHILD_FORK => ChildEvent::Added(pid, parent_pid, ChildOrigin::Fork),
+        HOOK_FRIDA_CHILD_EXEC => ChildEvent::Added(pid, parent_pid, ChildOrigin::Exec),
+        HOOK_FRIDA_CHILD_SPAWN => ChildEvent::Added(pid, parent_pid, ChildOrigin::Spawn),
+        _ => ChildEvent::Ended(pid),
+    };
+    gating.post(event);
 }
 
 // Frida's injector context is used only through its C API, which is designed
@@ -120,199 +630,585 @@ impl Drop for FridaBackend {
 }
 
 impl FridaBackend {
+    pub(super) fn warm_up(&self) -> Result<WarmUpReport> {
+        let mut stats = HookFridaStartupStats::default();
+        let mut err_ptr: *mut c_char = ptr::null_mut();
+        let mut err_kind: c_int = HOOK_FRIDA_ERROR_NONE;
+
+        let ok = unsafe {
+            hook_frida_warm_up(
+                self.ctx,
+                &mut stats as *mut HookFridaStartupStats,
+                &mut err_kind as *mut c_int,
+                &mut err_ptr as *mut *mut c_char,
+            )
+        };
+        if ok <= 0 {
+            return Err(new_frida_error(err_kind, err_ptr, None));
+        }
+
+        Ok(WarmUpReport::new(
+            Duration::from_micros(stats.frida_init_us),
+            Duration::from_micros(stats.injector_us),
+            Duration::from_micros(stats.device_lookup_us),
+            Duration::from_micros(stats.helper_us),
+            Duration::from_micros(stats.host_session_us),
+        ))
+    }
+
+    /// List local processes, restricted to `pids` unless it is empty.
+    pub(super) fn enumerate_processes(
+        &self,
+        pids: &[u32],
+        details: bool,
+    ) -> Result<Vec<EnumeratedProcess>> {
+        let mut list: *mut HookFridaProcessInfo = ptr::null_mut();
+        let mut count: usize = 0;
+        let mut err_ptr: *mut c_char = ptr::null_mut();
+        let mut err_kind: c_int = HOOK_FRIDA_ERROR_NONE;
+
+        let ok = unsafe {
+            hook_frida_enumerate_processes(
+                self.ctx,
+                pids.as_ptr(),
+                pids.len(),
+                details as c_int,
+                &mut list as *mut *mut HookFridaProcessInfo,
+                &mut count as *mut usize,
+                &mut err_kind as *mut c_int,
+                &mut err_ptr as *mut *mut c_char,
+            )
+        };
+        if ok <= 0 {
+            return Err(new_frida_error(err_kind, err_ptr, None));
+        }
+
+        let entries = unsafe { std::slice::from_raw_parts(list, count) };
+        let processes = entries
+            .iter()
+            .map(|entry| EnumeratedProcess {
+                pid: entry.pid,
+                uid: (entry.uid != u32::MAX).then_some(entry.uid),
+                name: owned_string(entry.name).unwrap_or_default(),
+                path: owned_string(entry.path).map(PathBuf::from),
+            })
+            .collect();
+        unsafe { hook_frida_process_list_free(list, count) };
+        Ok(processes)
+    }
+
     pub(super) fn inject_launch(
         &self,
         spec: &mut Program,
         library: &Library,
-    ) -> Result<(Process, u64)> {
-        match library.source() {
-            LibrarySource::Path(_) => self.inject_launch_path(spec, library),
-            LibrarySource::Blob(_) => {
-                let process = self.spawn(spec)?;
-                let id = self.inject_blob(process, library)?;
-                self.resume(process)?;
-                Ok((process, id))
+        cancel: Option<&Cancellation>,
+    ) -> Result<(Process, Injection)> {
+        let program_path = spec.command().get_program();
+        let program = os_str_to_cstring(program_path, "program")?;
+        let entrypoint = library.entrypoint();
+        let data = library.data();
+
+        let argv_storage = build_argv(spec, &program)?;
+        let envp_storage = build_envp(spec)?;
+        let cwd = spec
+            .command()
+            .get_current_dir()
+            .map(|dir| os_str_to_cstring(dir, "cwd"))
+            .transpose()?;
+
+        let mut err_ptr: *mut c_char = ptr::null_mut();
+        let mut err_kind: c_int = HOOK_FRIDA_ERROR_NONE;
+        let mut pid_out: u32 = 0;
+        let mut id_out: u32 = 0;
+        let mut path_out: c_int = 0;
+        let mut stats = OpStats::new();
+
+        let ok = match library.source() {
+            LibrarySource::Path(path) => {
+                let library_path = os_str_to_cstring(path, "library_path")?;
+                unsafe {
+                    hook_frida_inject_launch(
+                        self.ctx,
+                        program.as_ptr(),
+                        argv_storage.ptrs.as_ptr(),
+                        envp_storage.ptrs.as_ptr(),
+                        cwd.as_ref().map(|s| s.as_ptr()).unwrap_or(ptr::null()),
+                        map_stdio(spec.stdio_value()),
+                        library_path.as_ptr(),
+                        entrypoint.as_ptr(),
+                        data.as_ptr(),
+                        &mut pid_out as *mut u32,
+                        &mut id_out as *mut u32,
+                        &mut path_out as *mut c_int,
+                        stats.as_ptr(),
+                        cancel_ptr(cancel),
+                        &mut err_kind as *mut c_int,
+                        &mut err_ptr as *mut *mut c_char,
+                    )
+                }
             }
+            LibrarySource::Blob(bytes) => unsafe {
+                hook_frida_inject_launch_blob(
+                    self.ctx,
+                    program.as_ptr(),
+                    argv_storage.ptrs.as_ptr(),
+                    envp_storage.ptrs.as_ptr(),
+                    cwd.as_ref().map(|s| s.as_ptr()).unwrap_or(ptr::null()),
+                    map_stdio(spec.stdio_value()),
+                    &share_blob(bytes),
+                    entrypoint.as_ptr(),
+                    data.as_ptr(),
+                    &mut pid_out as *mut u32,
+                    &mut id_out as *mut u32,
+                    &mut path_out as *mut c_int,
+                    stats.as_ptr(),
+                    cancel_ptr(cancel),
+                    &mut err_kind as *mut c_int,
+                    &mut err_ptr as *mut *mut c_char,
+                )
+            },
+        };
+        let launched = (ok > 0).then(|| unsafe { Process::from_pid_unchecked(pid_out as i32) });
+        stats.report(InjectionOp::Launch, launched, ok > 0);
+
+        if ok <= 0 {
+            return Err(new_frida_error(err_kind, err_ptr, None));
         }
+
+        let process = unsafe { Process::from_pid_unchecked(pid_out as i32) };
+        Ok((process, Injection::new(id_out, path_out)))
     }
 
-    pub(super) fn inject_process(&self, process: Process, library: &Library) -> Result<u64> {
+    pub(super) fn inject_process(
+        &self,
+        process: Process,
+        library: &Library,
+        cancel: Option<&Cancellation>,
+    ) -> Result<Injection> {
         match library.source() {
-            LibrarySource::Path(_) => self.inject_process_path(process, library),
-            LibrarySource::Blob(_) => self.inject_blob(process, library),
+            LibrarySource::Path(_) => self.inject_process_path(process, library, cancel),
+            LibrarySource::Blob(_) => self.inject_blob(process, library, cancel),
         }
     }
 
-    fn inject_launch_path(&self, spec: &mut Program, library: &Library) -> Result<(Process, u64)> {
-        let program_path = spec.command().get_program();
-        let program = os_str_to_cstring(program_path, "program")?;
+    /// Inject into every process concurrently; one result per process, in order.
+    pub(super) fn inject_many(
+        &self,
+        processes: &[Process],
+        library: &Library,
+    ) -> Result<Vec<Result<Injection>>> {
+        if processes.is_empty() {
+            return Ok(Vec::new());
+        }
+
+        let library_path = match library.source() {
+            LibrarySource::Path(path) => Some(os_str_to_cstring(path, "library_path")?),
+            LibrarySource::Blob(_) => None,
+        };
+        let blob = match library.source() {
+            LibrarySource::Blob(bytes) => Some(share_blob(bytes)),
+            LibrarySource::Path(_) => None,
+        };
+        let entrypoint = library.entrypoint();
+        let data = library.data();
+
+        let pids: Vec<i32> = processes.iter().map(|process| process.pid()).collect();
+        let mut results: Vec<HookFridaInjectResult> = pids
+            .iter()
+            .map(|&pid| HookFridaInjectResult {
+                pid,
+                id: 0,
+                path: 0,
+                error_kind: HOOK_FRIDA_ERROR_NONE,
+                error: ptr::null_mut(),
+            })
+            .collect();
+
+        let mut err_ptr: *mut c_char = ptr::null_mut();
+        let mut err_kind: c_int = HOOK_FRIDA_ERROR_NONE;
+
+        let ok = unsafe {
+            hook_frida_inject_many(
+                self.ctx,
+                pids.as_ptr(),
+                pids.len(),
+                library_path
+                    .as_ref()
+                    .map(|s| s.as_ptr())
+                    .unwrap_or(ptr::null()),
+                blob.as_ref()
+                    .map(|b| b as *const HookFridaBlob)
+                    .unwrap_or(ptr::null()),
+                entrypoint.as_ptr(),
+                data.as_ptr(),
+                results.as_mut_ptr(),
+                &mut err_kind as *mut c_int,
+                &mut err_ptr as *mut *mut c_char,
+            )
+        };
+
+        if ok <= 0 {
+            return Err(new_frida_error(err_kind, err_ptr, None));
+        }
+
+        Ok(results
+            .into_iter()
+            .map(|result| {
+                if result.error_kind == HOOK_FRIDA_ERROR_NONE {
+                    Ok(Injection::new(result.id, result.path))
+                } else {
+                    Err(new_frida_error(
+                        result.error_kind,
+                        result.error,
+                        Some(result.pid),
+                    ))
+                }
+            })
+            .collect())
+    }
+
+    fn inject_process_path(
+        &self,
+        process: Process,
+        library: &Library,
+        cancel: Option<&Cancellation>,
+    ) -> Result<Injection> {
         let library_path = match library.source() {
             LibrarySource::Path(path) => os_str_to_cstring(path, "library_path")?,
             LibrarySource::Blob(_) => {
-                return Err(Error::invalid_input(
-                    "library must be a file path for launch",
-                ));
+                return Err(Error::invalid_input("library must be a file path"));
+            }
+        };
+        let entrypoint = library.entrypoint();
+        let data = library.data();
+
+        let mut err_ptr: *mut c_char = ptr::null_mut();
+        let mut err_kind: c_int = HOOK_FRIDA_ERROR_NONE;
+        let mut id_out: u32 = 0;
+        let mut path_out: c_int = 0;
+        let mut stats = OpStats::new();
+
+        let ok = unsafe {
+            hook_frida_inject_process(
+                self.ctx,
+                process.pid(),
+                library_path.as_ptr(),
+                entrypoint.as_ptr(),
+                data.as_ptr(),
+                &mut id_out as *mut u32,
+                &mut path_out as *mut c_int,
+                stats.as_ptr(),
+                cancel_ptr(cancel),
+                &mut err_kind as *mut c_int,
+                &mut err_ptr as *mut *mut c_char,
+            )
+        };
+        stats.report(InjectionOp::Process, Some(process), ok > 0);
+
+        if ok <= 0 {
+            return Err(new_frida_error(err_kind, err_ptr, None));
+        }
+
+        Ok(Injection::new(id_out, path_out))
+    }
+
+    fn inject_blob(
+        &self,
+        process: Process,
+        library: &Library,
+        cancel: Option<&Cancellation>,
+    ) -> Result<Injection> {
+        let bytes = match library.source() {
+            LibrarySource::Blob(bytes) => bytes,
+            LibrarySource::Path(_) => {
+                return Err(Error::invalid_input("library is not a blob"));
             }
         };
         let entrypoint = library.entrypoint();
         let data = library.data();
 
+        let mut err_ptr: *mut c_char = ptr::null_mut();
+        let mut err_kind: c_int = HOOK_FRIDA_ERROR_NONE;
+        let mut id_out: u32 = 0;
+        let mut path_out: c_int = 0;
+        let mut stats = OpStats::new();
+
+        let ok = unsafe {
+            hook_frida_inject_blob(
+                self.ctx,
+                process.pid(),
+                &share_blob(bytes),
+                entrypoint.as_ptr(),
+                data.as_ptr(),
+                &mut id_out as *mut u32,
+                &mut path_out as *mut c_int,
+                stats.as_ptr(),
+                cancel_ptr(cancel),
+                &mut err_kind as *mut c_int,
+                &mut err_ptr as *mut *mut c_char,
+            )
+        };
+        stats.report(InjectionOp::Process, Some(process), ok > 0);
+
+        if ok <= 0 {
+            return Err(new_frida_error(err_kind, err_ptr, None));
+        }
+
+        Ok(Injection::new(id_out, path_out))
+    }
+
+    pub(super) fn spawn(
+        &self,
+        spec: &mut Program,
+        cancel: Option<&Cancellation>,
+    ) -> Result<Process> {
+        let program_path = spec.command().get_program();
+        let program = os_str_to_cstring(program_path, "program path")?;
+
         let argv_storage = build_argv(spec, &program)?;
         let envp_storage = build_envp(spec)?;
         let cwd = spec
             .command()
             .get_current_dir()
-            .map(|dir| os_str_to_cstring(dir, "cwd"))
+            .map(|dir| {
+                CString::new(dir.to_string_lossy().as_bytes())
+                    .map_err(|_| Error::invalid_input("cwd contains NUL"))
+            })
             .transpose()?;
 
         let mut err_ptr: *mut c_char = ptr::null_mut();
         let mut err_kind: c_int = HOOK_FRIDA_ERROR_NONE;
         let mut pid_out: u32 = 0;
-        let mut id_out: u32 = 0;
 
         let ok = unsafe {
-            hook_frida_inject_launch(
+            hook_frida_spawn(
                 self.ctx,
                 program.as_ptr(),
                 argv_storage.ptrs.as_ptr(),
                 envp_storage.ptrs.as_ptr(),
                 cwd.as_ref().map(|s| s.as_ptr()).unwrap_or(ptr::null()),
                 map_stdio(spec.stdio_value()),
-                library_path.as_ptr(),
-                entrypoint.as_ptr(),
-                data.as_ptr(),
+                &mut pid_out as *mut u32,
+                cancel_ptr(cancel),
+                &mut err_kind as *mut c_int,
+                &mut err_ptr as *mut *mut c_char,
+            )
+        };
+
+        if ok <= 0 {
+            return Err(new_frida_error(err_kind, err_ptr, None));
+        }
+
+        let process = unsafe { Process::from_pid_unchecked(pid_out as i32) };
+        Ok(process)
+    }
+
+    /// Marshal a launch spec into the shim once, for repeated launches.
+    pub(super) fn prepare(&self, spec: &Program) -> Result<SpawnSpec> {
+        let program = os_str_to_cstring(spec.command().get_program(), "program path")?;
+        let argv_storage = build_argv(spec, &program)?;
+        let envp_storage = build_envp(spec)?;
+        let cwd = spec
+            .command()
+            .get_current_dir()
+            .map(|dir| os_str_to_cstring(dir, "cwd"))
+            .transpose()?;
+
+        // The shim copies every string, so the storage can drop afterwards.
+        let ptr = unsafe {
+            hook_frida_spawn_spec_new(
+                program.as_ptr(),
+                argv_storage.ptrs.as_ptr(),
+                envp_storage.ptrs.as_ptr(),
+                cwd.as_ref().map(|s| s.as_ptr()).unwrap_or(ptr::null()),
+                map_stdio(spec.stdio_value()),
+            )
+        };
+        if ptr.is_null() {
+            return Err(Error::invalid_input("launch spec could not be prepared"));
+        }
+        Ok(SpawnSpec {
+            ptr,
+            stdio: spec.stdio_value(),
+        })
+    }
+
+    pub(super) fn spawn_prepared(
+        &self,
+        spec: &SpawnSpec,
+        overrides: &SpawnOverrides<'_>,
+        cancel: Option<&Cancellation>,
+    ) -> Result<Process> {
+        let (argv, envp) = overrides.encode()?;
+        let mut err_ptr: *mut c_char = ptr::null_mut();
+        let mut err_kind: c_int = HOOK_FRIDA_ERROR_NONE;
+        let mut pid_out: u32 = 0;
+
+        let ok = unsafe {
+            hook_frida_spawn_prepared(
+                self.ctx,
+                spec.ptr,
+                argv.as_ptr(),
+                envp.as_ptr(),
+                &mut pid_out as *mut u32,
+                cancel_ptr(cancel),
+                &mut err_kind as *mut c_int,
+                &mut err_ptr as *mut *mut c_char,
+            )
+        };
+
+        if ok <= 0 {
+            return Err(new_frida_error(err_kind, err_ptr, None));
+        }
+        Ok(unsafe { Process::from_pid_unchecked(pid_out as i32) })
+    }
+
+    pub(super) fn inject_launch_prepared(
+        &self,
+        spec: &SpawnSpec,
+        overrides: &SpawnOverrides<'_>,
+        library: &Library,
+        cancel: Option<&Cancellation>,
+    ) -> Result<(Process, Injection)> {
+        let (argv, envp) = overrides.encode()?;
+        let library_path = match library.source() {
+            LibrarySource::Path(path) => Some(os_str_to_cstring(path, "library_path")?),
+            LibrarySource::Blob(_) => None,
+        };
+        let blob = match library.source() {
+            LibrarySource::Path(_) => None,
+            LibrarySource::Blob(bytes) => Some(share_blob(bytes)),
+        };
+
+        let mut err_ptr: *mut c_char = ptr::null_mut();
+        let mut err_kind: c_int = HOOK_FRIDA_ERROR_NONE;
+        let mut pid_out: u32 = 0;
+        let mut id_out: u32 = 0;
+        let mut path_out: c_int = 0;
+        let mut stats = OpStats::new();
+
+        let ok = unsafe {
+            hook_frida_inject_launch_prepared(
+                self.ctx,
+                spec.ptr,
+                argv.as_ptr(),
+                envp.as_ptr(),
+                library_path
+                    .as_ref()
+                    .map(|s| s.as_ptr())
+                    .unwrap_or(ptr::null()),
+                blob.as_ref()
+                    .map(|blob| blob as *const HookFridaBlob)
+                    .unwrap_or(ptr::null()),
+                library.entrypoint().as_ptr(),
+                library.data().as_ptr(),
                 &mut pid_out as *mut u32,
                 &mut id_out as *mut u32,
+                &mut path_out as *mut c_int,
+                stats.as_ptr(),
+                cancel_ptr(cancel),
+                &mut err_kind as *mut c_int,
+                &mut err_ptr as *mut *mut c_char,
+            )
+        };
+        let launched = (ok > 0).then(|| unsafe { Process::from_pid_unchecked(pid_out as i32) });
+        stats.report(InjectionOp::Launch, launched, ok > 0);
+
+        if ok <= 0 {
+            return Err(new_frida_error(err_kind, err_ptr, None));
+        }
+
+        let process = unsafe { Process::from_pid_unchecked(pid_out as i32) };
+        Ok((process, Injection::new(id_out, path_out)))
+    }
+
+    pub(super) fn resume(&self, process: Process, cancel: Option<&Cancellation>) -> Result<()> {
+        let mut err_ptr: *mut c_char = ptr::null_mut();
+        let mut err_kind: c_int = HOOK_FRIDA_ERROR_NONE;
+        let ok = unsafe {
+            hook_frida_resume(
+                self.ctx,
+                process.pid() as u32,
+                cancel_ptr(cancel),
                 &mut err_kind as *mut c_int,
                 &mut err_ptr as *mut *mut c_char,
             )
         };
-
         if ok <= 0 {
-            return Err(new_frida_error(err_kind, err_ptr, None));
+            return Err(new_frida_error(err_kind, err_ptr, Some(process.pid())));
         }
-
-        let process = unsafe { Process::from_pid_unchecked(pid_out as i32) };
-        Ok((process, id_out as u64))
+        Ok(())
     }
 
-    fn inject_process_path(&self, process: Process, library: &Library) -> Result<u64> {
-        let library_path = match library.source() {
-            LibrarySource::Path(path) => os_str_to_cstring(path, "library_path")?,
-            LibrarySource::Blob(_) => {
-                return Err(Error::invalid_input("library must be a file path"));
-            }
-        };
-        let entrypoint = library.entrypoint();
-        let data = library.data();
-
+    pub(super) fn kill(&self, process: Process) -> Result<()> {
         let mut err_ptr: *mut c_char = ptr::null_mut();
         let mut err_kind: c_int = HOOK_FRIDA_ERROR_NONE;
-        let mut id_out: u32 = 0;
-
         let ok = unsafe {
-            hook_frida_inject_process(
+            hook_frida_kill(
                 self.ctx,
-                process.pid(),
-                library_path.as_ptr(),
-                entrypoint.as_ptr(),
-                data.as_ptr(),
-                &mut id_out as *mut u32,
+                process.pid() as u32,
                 &mut err_kind as *mut c_int,
                 &mut err_ptr as *mut *mut c_char,
             )
         };
-
         if ok <= 0 {
-            return Err(new_frida_error(err_kind, err_ptr, None));
+            return Err(new_frida_error(err_kind, err_ptr, Some(process.pid())));
         }
-
-        Ok(id_out as u64)
+        Ok(())
     }
 
-    fn inject_blob(&self, process: Process, library: &Library) -> Result<u64> {
-        let bytes = match library.source() {
-            LibrarySource::Blob(bytes) => bytes,
-            LibrarySource::Path(_) => {
-                return Err(Error::invalid_input("library is not a blob"));
-            }
-        };
-        let entrypoint = library.entrypoint();
-        let data = library.data();
+    pub(super) fn gating(&self) -> &Arc<GatingRegistry> {
+        &self.gating
+    }
 
+    pub(super) fn enable_child_gating(&self, process: Process) -> Result<()> {
         let mut err_ptr: *mut c_char = ptr::null_mut();
         let mut err_kind: c_int = HOOK_FRIDA_ERROR_NONE;
-        let mut id_out: u32 = 0;
-
         let ok = unsafe {
-            hook_frida_inject_blob(
+            hook_frida_enable_child_gating(
                 self.ctx,
-                process.pid(),
-                bytes.as_ptr(),
-                bytes.len(),
-                entrypoint.as_ptr(),
-                data.as_ptr(),
-                &mut id_out as *mut u32,
+                process.pid() as u32,
                 &mut err_kind as *mut c_int,
                 &mut err_ptr as *mut *mut c_char,
             )
         };
-
         if ok <= 0 {
-            return Err(new_frida_error(err_kind, err_ptr, None));
+            return Err(new_frida_error(err_kind, err_ptr, Some(process.pid())));
         }
-
-        Ok(id_out as u64)
+        Ok(())
     }
 
-    pub(super) fn spawn(&self, spec: &mut Program) -> Result<Process> {
-        let program_path = spec.command().get_program();
-        let program = os_str_to_cstring(program_path, "program path")?;
-
-        let argv_storage = build_argv(spec, &program)?;
-        let envp_storage = build_envp(spec)?;
-        let cwd = spec
-            .command()
-            .get_current_dir()
-            .map(|dir| {
-                CString::new(dir.to_string_lossy().as_bytes())
-                    .map_err(|_| Error::invalid_input("cwd contains NUL"))
-            })
-            .transpose()?;
-
+    pub(super) fn disable_child_gating(&self, process: Process) -> Result<()> {
         let mut err_ptr: *mut c_char = ptr::null_mut();
         let mut err_kind: c_int = HOOK_FRIDA_ERROR_NONE;
-        let mut pid_out: u32 = 0;
-
         let ok = unsafe {
-            hook_frida_spawn(
+            hook_frida_disable_child_gating(
                 self.ctx,
-                program.as_ptr(),
-                argv_storage.ptrs.as_ptr(),
-                envp_storage.ptrs.as_ptr(),
-                cwd.as_ref().map(|s| s.as_ptr()).unwrap_or(ptr::null()),
-                map_stdio(spec.stdio_value()),
-                &mut pid_out as *mut u32,
+                process.pid() as u32,
                 &mut err_kind as *mut c_int,
                 &mut err_ptr as *mut *mut c_char,
             )
         };
-
         if ok <= 0 {
-            return Err(new_frida_error(err_kind, err_ptr, None));
+            return Err(new_frida_error(err_kind, err_ptr, Some(process.pid())));
         }
+        Ok(())
+    }
 
-        let process = unsafe { Process::from_pid_unchecked(pid_out as i32) };
-        Ok(process)
+    /// Claim the buffered output of a child spawned with piped stdio.
+    pub(super) fn claim_output(&self, process: Process) -> OutputClaim {
+        self.outputs.claim(process.pid() as u32)
     }
 
-    pub(super) fn resume(&self, process: Process) -> Result<()> {
+    pub(super) fn input(&self, process: Process, data: &[u8]) -> Result<()> {
         let mut err_ptr: *mut c_char = ptr::null_mut();
         let mut err_kind: c_int = HOOK_FRIDA_ERROR_NONE;
         let ok = unsafe {
-            hook_frida_resume(
+            hook_frida_input(
                 self.ctx,
                 process.pid() as u32,
+                data.as_ptr(),
+                data.len(),
                 &mut err_kind as *mut c_int,
                 &mut err_ptr as *mut *mut c_char,
             )
@@ -323,7 +1219,28 @@ impl FridaBackend {
         Ok(())
     }
 
-    pub(super) fn uninject(&self, id: u64) -> Result<()> {
+    /// Run `callback` once the injection unloads, its target exits or it is
+    /// uninjected.
+    pub(super) fn watch_uninjected(
+        &self,
+        id: u64,
+        path: InjectionPath,
+        callback: UninjectedCallback,
+    ) {
+        self.watches.watch((path, id as u32), callback);
+    }
+
+    /// Release the watches of an injection whose demonitor succeeded.
+    pub(super) fn uninjected(&self, id: u64, path: InjectionPath) {
+        self.watches.release((path, id as u32));
+    }
+
+    pub(super) fn uninject(
+        &self,
+        id: u64,
+        path: InjectionPath,
+        cancel: Option<&Cancellation>,
+    ) -> Result<()> {
         if id == 0 {
             return Ok(());
         }
@@ -334,6 +1251,8 @@ impl FridaBackend {
             hook_frida_demonitor(
                 self.ctx,
                 id as u32,
+                path_code(path),
+                cancel_ptr(cancel),
                 &mut err_kind as *mut c_int,
                 &mut err_ptr as *mut *mut c_char,
             )
@@ -341,10 +1260,457 @@ impl FridaBackend {
         if ok <= 0 {
             return Err(new_frida_error(err_kind, err_ptr, None));
         }
+        self.uninjected(id, path);
         Ok(())
     }
 }
 
+impl FridaBackend {
+    pub(super) fn inject_process_async(
+        &self,
+        process: Process,
+        library: &Library,
+    ) -> Result<Completion> {
+        let entrypoint = library.entrypoint();
+        let data = library.data();
+
+        match library.source() {
+            LibrarySource::Path(path) => {
+                let library_path = os_str_to_cstring(path, "library_path")?;
+                submit(
+                    Some(process.pid()),
+                    |callback, user_data, err_kind, err_ptr| unsafe {
+                        hook_frida_inject_process_async(
+                            self.ctx,
+                            process.pid(),
+                            library_path.as_ptr(),
+                            entrypoint.as_ptr(),
+                            data.as_ptr(),
+                            callback,
+                            user_data,
+                            err_kind,
+                            err_ptr,
+                        )
+                    },
+                )
+            }
+            LibrarySource::Blob(bytes) => submit(
+                Some(process.pid()),
+                |callback, user_data, err_kind, err_ptr| unsafe {
+                    hook_frida_inject_blob_async(
+                        self.ctx,
+                        process.pid(),
+                        &share_blob(bytes),
+                        entrypoint.as_ptr(),
+                        data.as_ptr(),
+                        callback,
+                        user_data,
+                        err_kind,
+                        err_ptr,
+                    )
+                },
+            ),
+        }
+    }
+
+    pub(super) fn spawn_async(&self, spec: &mut Program) -> Result<Completion> {
+        let program_path = spec.command().get_program();
+        let program = os_str_to_cstring(program_path, "program path")?;
+
+        let argv_storage = build_argv(spec, &program)?;
+        let envp_storage = build_envp(spec)?;
+        let cwd = spec
+            .command()
+            .get_current_dir()
+            .map(|dir| os_str_to_cstring(dir, "cwd"))
+            .transpose()?;
+
+        // The shim copies argv/envp into its spawn options before returning.
+        submit(None, |callback, user_data, err_kind, err_ptr| unsafe {
+            hook_frida_spawn_async(
+                self.ctx,
+                program.as_ptr(),
+                argv_storage.ptrs.as_ptr(),
+                envp_storage.ptrs.as_ptr(),
+                cwd.as_ref().map(|s| s.as_ptr()).unwrap_or(ptr::null()),
+                map_stdio(spec.stdio_value()),
+                callback,
+                user_data,
+                err_kind,
+                err_ptr,
+            )
+        })
+    }
+
+    pub(super) fn resume_async(&self, process: Process) -> Result<Completion> {
+        submit(
+            Some(process.pid()),
+            |callback, user_data, err_kind, err_ptr| unsafe {
+                hook_frida_resume_async(
+                    self.ctx,
+                    process.pid() as u32,
+                    callback,
+                    user_data,
+                    err_kind,
+                    err_ptr,
+                )
+            },
+        )
+    }
+
+    pub(super) fn uninject_async(&self, id: u64, path: InjectionPath) -> Result<Completion> {
+        if id == 0 {
+            return Ok(Completion::ready(Injection::new(0, 0)));
+        }
+
+        submit(None, |callback, user_data, err_kind, err_ptr| unsafe {
+            hook_frida_demonitor_async(
+                self.ctx,
+                id as u32,
+                path_code(path),
+                callback,
+                user_data,
+                err_kind,
+                err_ptr,
+            )
+        })
+    }
+}
+
+/// Phase timings, requested from the shim only while a metrics hook is installed.
+struct OpStats {
+    raw: Option<HookFridaOpStats>,
+}
+
+impl OpStats {
+    fn new() -> Self {
+        Self {
+            raw: metrics::enabled().then(HookFridaOpStats::default),
+        }
+    }
+
+    fn as_ptr(&mut self) -> *mut HookFridaOpStats {
+        self.raw
+            .as_mut()
+            .map_or(ptr::null_mut(), |raw| raw as *mut HookFridaOpStats)
+    }
+
+    fn report(self, op: InjectionOp, process: Option<Process>, succeeded: bool) {
+        let Some(raw) = self.raw else {
+            return;
+        };
+        metrics::emit(InjectionMetrics {
+            op,
+            process,
+            spawn: Duration::from_micros(raw.spawn_us),
+            inject: Duration::from_micros(raw.inject_us),
+            fallback: Duration::from_micros(raw.fallback_us),
+            resume: Duration::from_micros(raw.resume_us),
+            total: Duration::from_micros(raw.total_us),
+            device_lookup: Duration::from_micros(raw.device_lookup_us),
+            payload_len: raw.payload_len as usize,
+            path: map_path(raw.path),
+            fell_back: raw.fell_back != 0,
+            succeeded,
+        });
+    }
+}
+
+/// Outcome of an injection: the Frida injection id and the path that served it.
+///
+/// Async spawns and resumes reuse it to carry the pid in `id`.
+#[derive(Debug, Clone, Copy)]
+pub(super) struct Injection {
+    pub(super) id: u32,
+    pub(super) path: InjectionPath,
+}
+
+impl Injection {
+    fn new(id: u32, path: c_int) -> Self {
+        Self {
+            id,
+            path: map_path(path),
+        }
+    }
+}
+
+/// One row of [`FridaBackend::enumerate_processes`].
+#[derive(Debug, Clone)]
+pub(crate) struct EnumeratedProcess {
+    pub(crate) pid: u32,
+    pub(crate) uid: Option<u32>,
+    pub(crate) name: String,
+    pub(crate) path: Option<PathBuf>,
+}
+
+/// Future resolved by the shim's completion callback on Frida's main thread.
+///
+/// Dropping it does not cancel the underlying operation. The shim holds a
+/// reference on its context until the operation completes, so dropping the
+/// future and the last backend handle meanwhile is safe.
+pub(super) struct Completion {
+    state: Arc<Mutex<CompletionState>>,
+    pid: Option<i32>,
+}
+
+#[derive(Default)]
+struct CompletionState {
+    outcome: Option<std::result::Result<Injection, (c_int, String)>>,
+    waker: Option<Waker>,
+}
+
+impl Completion {
+    fn ready(value: Injection) -> Self {
+        let state = CompletionState {
+            outcome: Some(Ok(value)),
+            waker: None,
+        };
+        Self {
+            state: Arc::new(Mutex::new(state)),
+            pid: None,
+        }
+    }
+}
+
+impl Completion {
+    /// Block the calling thread until the operation completes.
+    pub(super) fn wait(mut self) -> Result<Injection> {
+        let waker = Waker::from(Arc::new(ThreadWaker(std::thread::current())));
+        let mut cx = Context::from_waker(&waker);
+        loop {
+            match Pin::new(&mut self).poll(&mut cx) {
+                Poll::Ready(outcome) => return outcome,
+                Poll::Pending => std::thread::park(),
+            }
+        }
+    }
+}
+
+struct ThreadWaker(Thread);
+
+impl Wake for ThreadWaker {
+    fn wake(self: Arc<Self>) {
+        self.0.unpark();
+    }
+}
+
+impl Future for Completion {
+    type Output = Result<Injection>;
+
+    fn poll(self: Pin<&mut Self>, cx: &mut Context<'_>) -> Poll<Self::Output> {
+        let mut state = self.state.lock().unwrap_or_else(|err| err.into_inner());
+        match state.outcome.take() {
+            Some(Ok(value)) => Poll::Ready(Ok(value)),
+            Some(Err((kind, msg))) => Poll::Ready(Err(map_frida_error(kind, msg, self.pid))),
+            None => {
+                state.waker = Some(cx.waker().clone());
+                Poll::Pending
+            }
+        }
+    }
+}
+
+fn submit(
+    pid: Option<i32>,
+    start: impl FnOnce(HookFridaCompletion, *mut c_void, *mut c_int, *mut *mut c_char) -> c_int,
+) -> Result<Completion> {
+    // The shim owns one strong reference until it invokes the callback.
+    let state = Arc::new(Mutex::new(CompletionState::default()));
+    let user_data = Arc::into_raw(state.clone()) as *mut c_void;
+
+    let mut err_ptr: *mut c_char = ptr::null_mut();
+    let mut err_kind: c_int = HOOK_FRIDA_ERROR_NONE;
+    let ok = start(
+        complete_callback,
+        user_data,
+        &mut err_kind as *mut c_int,
+        &mut err_ptr as *mut *mut c_char,
+    );
+
+    if ok <= 0 {
+        // Rejected submissions never reach the callback; reclaim its reference.
+        drop(unsafe { Arc::from_raw(user_data as *const Mutex<CompletionState>) });
+        return Err(new_frida_error(err_kind, err_ptr, pid));
+    }
+
+    Ok(Completion { state, pid })
+}
+
+unsafe extern "C" fn complete_callback(
+    user_data: *mut c_void,
+    value: u32,
+    path: c_int,
+    error_kind: c_int,
+    error: *const c_char,
+) {
+    let state = unsafe { Arc::from_raw(user_data as *const Mutex<CompletionState>) };
+    let outcome = if error_kind == HOOK_FRIDA_ERROR_NONE {
+        Ok(Injection::new(value, path))
+    } else if error.is_null() {
+        Err((error_kind, "unknown error".to_string()))
+    } else {
+        let msg = unsafe { CStr::from_ptr(error) }
+            .to_string_lossy()
+            .into_owned();
+        Err((error_kind, msg))
+    };
+
+    let waker = {
+        let mut state = state.lock().unwrap_or_else(|err| err.into_inner());
+        state.outcome = Some(outcome);
+        state.waker.take()
+    };
+    if let Some(waker) = waker {
+        waker.wake();
+    }
+}
+
+/// Payloads lent by `share_blob` that GLib has not released yet.
+static LENT_PAYLOADS: AtomicU64 = AtomicU64::new(0);
+
+pub(crate) fn live_objects() -> LiveObjects {
+    let mut counts = HookFridaLiveCounts::default();
+    unsafe { hook_frida_live_counts(&mut counts) };
+    LiveObjects::new(
+        counts.contexts,
+        counts.async_ops,
+        LENT_PAYLOADS.load(Ordering::Relaxed),
+    )
+}
+
+fn share_blob(payload: &Payload) -> HookFridaBlob {
+    // Lend the shared payload to GLib; the shim drops this reference through
+    // `release_blob`, so no layer ever copies the bytes.
+    let bytes = payload.as_slice();
+    let owner = Box::into_raw(Box::new(payload.clone()));
+    LENT_PAYLOADS.fetch_add(1, Ordering::Relaxed);
+    HookFridaBlob {
+        data: bytes.as_ptr(),
+        len: bytes.len(),
+        release: Some(release_blob),
+        owner: owner as *mut c_void,
+    }
+}
+
+unsafe extern "C" fn release_blob(owner: *mut c_void) {
+    drop(unsafe { Box::from_raw(owner as *mut Payload) });
+    LENT_PAYLOADS.fetch_sub(1, Ordering::Relaxed);
+}
+
+/// A GCancellable owned by a [`Cancellation`].
+pub(crate) struct NativeCancellable {
+    ptr: *mut HookFridaCancellable,
+}
+
+// GCancellable is thread-safe.
+unsafe impl Send for NativeCancellable {}
+unsafe impl Sync for NativeCancellable {}
+
+impl NativeCancellable {
+    pub(crate) fn new() -> Self {
+        Self {
+            ptr: unsafe { hook_frida_cancellable_new() },
+        }
+    }
+
+    pub(crate) fn cancel(&self) {
+        unsafe { hook_frida_cancellable_cancel(self.ptr) };
+    }
+
+    pub(crate) fn is_cancelled(&self) -> bool {
+        unsafe { hook_frida_cancellable_is_cancelled(self.ptr) != 0 }
+    }
+}
+
+impl Drop for NativeCancellable {
+    fn drop(&mut self) {
+        unsafe { hook_frida_cancellable_free(self.ptr) };
+    }
+}
+
+fn cancel_ptr(cancel: Option<&Cancellation>) -> *mut HookFridaCancellable {
+    cancel.map_or(ptr::null_mut(), |cancel| cancel.native().ptr)
+}
+
+/// A launch spec owned by the shim; see [`FridaBackend::prepare`].
+pub(crate) struct SpawnSpec {
+    ptr: *mut HookFridaSpawnSpec,
+    stdio: Stdio,
+}
+
+// The shim never mutates a spec after creating it.
+unsafe impl Send for SpawnSpec {}
+unsafe impl Sync for SpawnSpec {}
+
+impl SpawnSpec {
+    pub(crate) fn stdio(&self) -> Stdio {
+        self.stdio
+    }
+}
+
+impl std::fmt::Debug for SpawnSpec {
+    fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
+        f.debug_struct("SpawnSpec")
+            .field("stdio", &self.stdio)
+            .finish_non_exhaustive()
+    }
+}
+
+impl Drop for SpawnSpec {
+    fn drop(&mut self) {
+        unsafe { hook_frida_spawn_spec_free(self.ptr) };
+    }
+}
+
+/// Per-launch changes to a [`SpawnSpec`]; only these are encoded per launch.
+pub(crate) struct SpawnOverrides<'a> {
+    pub(crate) args: &'a [OsString],
+    pub(crate) envs: &'a [(OsString, OsString)],
+}
+
+impl SpawnOverrides<'_> {
+    fn encode(&self) -> Result<(CArray, CArray)> {
+        let args = self
+            .args
+            .iter()
+            .map(|arg| os_str_to_cstring(arg, "arg"))
+            .collect::<Result<_>>()?;
+        let envs = self
+            .envs
+            .iter()
+            .map(|(key, value)| env_entry(key, value))
+            .collect::<Result<_>>()?;
+        Ok((CArray::new(args), CArray::new(envs)))
+    }
+}
+
+/// NULL-terminated array of C strings; a NULL pointer when empty.
+struct CArray {
+    _cstrings: Vec<CString>,
+    ptrs: Vec<*const c_char>,
+}
+
+impl CArray {
+    fn new(cstrings: Vec<CString>) -> Self {
+        let mut ptrs: Vec<*const c_char> = cstrings.iter().map(|s| s.as_ptr()).collect();
+        if !ptrs.is_empty() {
+            ptrs.push(ptr::null());
+        }
+        Self {
+            _cstrings: cstrings,
+            ptrs,
+        }
+    }
+
+    fn as_ptr(&self) -> *const *const c_char {
+        if self.ptrs.is_empty() {
+            ptr::null()
+        } else {
+            self.ptrs.as_ptr()
+        }
+    }
+}
+
 struct CArgv {
     _cstrings: Vec<CString>,
     ptrs: Vec<*const c_char>,
@@ -360,9 +1726,7 @@ fn build_argv(spec: &Program, program: &CString) -> Result<CArgv> {
     let mut cstrings = Vec::new();
     cstrings.push(program.clone());
     for arg in spec.command().get_args() {
-        let s = CString::new(arg.to_string_lossy().as_bytes())
-            .map_err(|_| Error::invalid_input("arg contains NUL"))?;
-        cstrings.push(s);
+        cstrings.push(os_str_to_cstring(arg, "arg")?);
     }
 
     let mut ptrs: Vec<*const c_char> = cstrings.iter().map(|s| s.as_ptr()).collect();
@@ -379,12 +1743,7 @@ fn build_envp(spec: &Program) -> Result<CEnvp> {
     let mut cstrings = Vec::new();
     for (k, v) in spec.command().get_envs() {
         if let Some(v) = v {
-            let mut kv = k.to_string_lossy().into_owned();
-            kv.push('=');
-            kv.push_str(&v.to_string_lossy());
-            let s = CString::new(kv.as_bytes())
-                .map_err(|_| Error::invalid_input("env contains NUL"))?;
-            cstrings.push(s);
+            cstrings.push(env_entry(k, v)?);
         }
     }
 
@@ -404,6 +1763,13 @@ fn build_envp(spec: &Program) -> Result<CEnvp> {
     })
 }
 
+fn env_entry(key: &OsStr, value: &OsStr) -> Result<CString> {
+    let mut entry = key.to_os_string();
+    entry.push("=");
+    entry.push(value);
+    os_str_to_cstring(entry, "env")
+}
+
 fn map_stdio(stdio: Stdio) -> i32 {
     match stdio {
         Stdio::Inherit => 0,
@@ -424,6 +1790,36 @@ const HOOK_FRIDA_ERROR_PERMISSION_DENIED: c_int = 3;
 const HOOK_FRIDA_ERROR_PROCESS_NOT_FOUND: c_int = 4;
 #[allow(dead_code)]
 const HOOK_FRIDA_ERROR_RUNTIME: c_int = 5;
+const HOOK_FRIDA_ERROR_CANCELLED: c_int = 6;
+
+// Mirror the shim's HookFridaDeviceKind codes.
+const HOOK_FRIDA_DEVICE_LOCAL: c_int = 0;
+const HOOK_FRIDA_DEVICE_REMOTE: c_int = 1;
+const HOOK_FRIDA_DEVICE_USB: c_int = 2;
+const HOOK_FRIDA_DEVICE_ID: c_int = 3;
+
+// Mirror the shim's HookFridaPath codes.
+const HOOK_FRIDA_PATH_INJECTOR: c_int = 1;
+const HOOK_FRIDA_PATH_DEVICE: c_int = 2;
+
+// Mirror the shim's HookFridaChildEventKind codes.
+const HOOK_FRIDA_CHILD_FORK: c_int = 0;
+const HOOK_FRIDA_CHILD_EXEC: c_int = 1;
+const HOOK_FRIDA_CHILD_SPAWN: c_int = 2;
+
+fn map_path(path: c_int) -> InjectionPath {
+    match path {
+        HOOK_FRIDA_PATH_DEVICE => InjectionPath::Device,
+        _ => InjectionPath::Injector,
+    }
+}
+
+fn path_code(path: InjectionPath) -> c_int {
+    match path {
+        InjectionPath::Injector => HOOK_FRIDA_PATH_INJECTOR,
+        InjectionPath::Device => HOOK_FRIDA_PATH_DEVICE,
+    }
+}
 
 fn map_frida_error(kind: c_int, msg: String, pid: Option<i32>) -> Error {
     // Map Frida error kinds into the public Rust error surface.
@@ -438,6 +1834,7 @@ fn map_frida_error(kind: c_int, msg: String, pid: Option<i32>) -> Error {
                 Error::runtime(msg)
             }
         }
+        HOOK_FRIDA_ERROR_CANCELLED => Error::cancelled(msg),
         _ => Error::runtime(msg),
     }
 }
@@ -454,6 +1851,18 @@ fn read_error(ptr: *mut c_char) -> String {
     }
 }
 
+/// Copy a string borrowed from a shim-owned list, if any.
+fn owned_string(ptr: *const c_char) -> Option<String> {
+    if ptr.is_null() {
+        return None;
+    }
+    Some(
+        unsafe { CStr::from_ptr(ptr) }
+            .to_string_lossy()
+            .into_owned(),
+    )
+}
+
 fn os_str_to_cstring(os_str: impl AsRef<OsStr>, var_name: &'static str) -> Result<CString> {
     #[cfg(unix)]
     {
@@ -1,7 +1,15 @@
-use std::sync::{Arc, OnceLock};
+use std::sync::{Arc, OnceLock, Weak};
 
 use crate::{
-    InjectedProcess, InjectedProgram, Library, Process, Program, Result, SuspendedProgram,
+    Cancellation, InjectedProcess, InjectedProgram, Library, Process, Program, Result,
+    SuspendedProgram, WarmUpReport,
+};
+
+use crate::gating::GatingRegistry;
+use crate::stdio::ChildPipes;
+use frida::Injection;
+pub(crate) use frida::{
+    EnumeratedProcess, NativeCancellable, SpawnOverrides, SpawnSpec, live_objects,
 };
 
 mod frida;
@@ -11,6 +19,18 @@ pub(crate) struct BackendHandle {
     inner: Arc<frida::FridaBackend>,
 }
 
+/// Non-owning [`BackendHandle`] for threads that must not keep a backend alive.
+#[derive(Clone)]
+pub(crate) struct WeakBackend {
+    inner: Weak<frida::FridaBackend>,
+}
+
+impl WeakBackend {
+    pub(crate) fn upgrade(&self) -> Option<BackendHandle> {
+        self.inner.upgrade().map(|inner| BackendHandle { inner })
+    }
+}
+
 impl std::fmt::Debug for BackendHandle {
     fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
         f.write_str("BackendHandle(..)")
@@ -24,51 +44,332 @@ impl BackendHandle {
         }
     }
 
-    pub(crate) fn uninject(&self, id: u64) -> Result<()> {
-        self.inner.uninject(id)
+    /// Whether both handles refer to the same backend.
+    pub(crate) fn same_backend(&self, other: &BackendHandle) -> bool {
+        Arc::ptr_eq(&self.inner, &other.inner)
+    }
+
+    pub(crate) fn downgrade(&self) -> WeakBackend {
+        WeakBackend {
+            inner: Arc::downgrade(&self.inner),
+        }
+    }
+
+    pub(crate) fn gating(&self) -> &Arc<GatingRegistry> {
+        self.inner.gating()
+    }
+
+    pub(crate) fn enable_child_gating(&self, process: Process) -> Result<()> {
+        self.inner.enable_child_gating(process)
+    }
+
+    pub(crate) fn disable_child_gating(&self, process: Process) -> Result<()> {
+        self.inner.disable_child_gating(process)
+    }
+
+    pub(crate) fn warm_up(&self) -> Result<WarmUpReport> {
+        self.inner.warm_up()
+    }
+
+    pub(crate) fn enumerate_processes(
+        &self,
+        pids: &[u32],
+        details: bool,
+    ) -> Result<Vec<EnumeratedProcess>> {
+        self.inner.enumerate_processes(pids, details)
+    }
+
+    pub(crate) fn on_uninjected(
+        &self,
+        id: u64,
+        path: crate::InjectionPath,
+        callback: Box<dyn FnOnce() + Send>,
+    ) {
+        self.inner.watch_uninjected(id, path, callback);
+    }
+
+    pub(crate) fn uninject(
+        &self,
+        id: u64,
+        path: crate::InjectionPath,
+        cancel: Option<&Cancellation>,
+    ) -> Result<()> {
+        self.inner.uninject(id, path, cancel)
+    }
+
+    /// Submit a demonitor to Frida's event loop without waiting for it.
+    ///
+    /// Submitting several before waiting on any lets Frida run them
+    /// concurrently instead of paying one round trip each.
+    pub(crate) fn begin_uninject(&self, id: u64, path: crate::InjectionPath) -> PendingUninject {
+        PendingUninject {
+            completion: self.inner.uninject_async(id, path),
+            backend: self.clone(),
+            id,
+            path,
+        }
     }
 
     pub(crate) fn inject_program(
         &self,
         mut spec: Program,
         library: Library,
+        cancel: Option<&Cancellation>,
     ) -> Result<InjectedProgram> {
         let stdio = spec.stdio_value();
-        let (process, id) = self.inner.inject_launch(&mut spec, &library)?;
-        let child = crate::Child::new(process, stdio);
-        Ok(InjectedProgram::new(self.clone(), id, process, child))
+        let (process, injection) = self.inner.inject_launch(&mut spec, &library, cancel)?;
+        let child = self.child(process, stdio);
+        Ok(InjectedProgram::new(
+            self.injected(process, injection, &library),
+            child,
+        ))
     }
 
     pub(crate) fn inject_process(
         &self,
         process: Process,
         library: Library,
+        cancel: Option<&Cancellation>,
     ) -> Result<InjectedProcess> {
-        let id = self.inner.inject_process(process, &library)?;
-        Ok(InjectedProcess::new(self.clone(), id, process))
+        let injection = self.inner.inject_process(process, &library, cancel)?;
+        Ok(self.injected(process, injection, &library))
+    }
+
+    pub(crate) fn inject_processes(
+        &self,
+        processes: &[Process],
+        library: Library,
+    ) -> Result<Vec<Result<InjectedProcess>>> {
+        let results = self.inner.inject_many(processes, &library)?;
+        Ok(processes
+            .iter()
+            .zip(results)
+            .map(|(&process, result)| {
+                result.map(|injection| self.injected(process, injection, &library))
+            })
+            .collect())
+    }
+
+    pub(crate) fn prepare(&self, spec: &Program) -> Result<SpawnSpec> {
+        self.inner.prepare(spec)
     }
 
-    pub(crate) fn spawn(&self, mut spec: Program) -> Result<crate::SuspendedProgram> {
+    pub(crate) fn inject_prepared(
+        &self,
+        spec: &SpawnSpec,
+        overrides: &SpawnOverrides<'_>,
+        library: Library,
+        cancel: Option<&Cancellation>,
+    ) -> Result<InjectedProgram> {
+        let (process, injection) = self
+            .inner
+            .inject_launch_prepared(spec, overrides, &library, cancel)?;
+        let child = self.child(process, spec.stdio());
+        Ok(InjectedProgram::new(
+            self.injected(process, injection, &library),
+            child,
+        ))
+    }
+
+    pub(crate) fn spawn_prepared(
+        &self,
+        spec: &SpawnSpec,
+        overrides: &SpawnOverrides<'_>,
+        cancel: Option<&Cancellation>,
+    ) -> Result<SuspendedProgram> {
+        self.inner
+            .spawn_prepared(spec, overrides, cancel)
+            .map(|process| SuspendedProgram::new(self.clone(), process, spec.stdio()))
+    }
+
+    pub(crate) fn spawn(
+        &self,
+        mut spec: Program,
+        cancel: Option<&Cancellation>,
+    ) -> Result<crate::SuspendedProgram> {
         let stdio = spec.stdio_value();
         self.inner
-            .spawn(&mut spec)
+            .spawn(&mut spec, cancel)
             .map(|process| SuspendedProgram::new(self.clone(), process, stdio))
     }
 
-    pub(crate) fn resume(&self, process: Process) -> Result<()> {
-        self.inner.resume(process)
+    pub(crate) fn resume(&self, process: Process, cancel: Option<&Cancellation>) -> Result<()> {
+        self.inner.resume(process, cancel)
+    }
+
+    pub(crate) fn kill(&self, process: Process) -> Result<()> {
+        self.inner.kill(process)
+    }
+
+    pub(crate) fn input(&self, process: Process, data: &[u8]) -> Result<()> {
+        self.inner.input(process, data)
+    }
+
+    /// Wrap a launched process, claiming its output when stdio is piped.
+    pub(crate) fn child(&self, process: Process, stdio: crate::Stdio) -> crate::Child {
+        let pipes = matches!(stdio, crate::Stdio::Pipe)
+            .then(|| ChildPipes::new(self.clone(), process, self.inner.claim_output(process)));
+        crate::Child::new(process, stdio, pipes)
+    }
+
+    /// Spawn every program suspended, inject them all, then resume them together.
+    pub(crate) fn spawn_batch(
+        &self,
+        programs: Vec<Program>,
+        library: Library,
+    ) -> Result<Vec<Result<InjectedProgram>>> {
+        // Submit every spawn before waiting so Frida runs them concurrently.
+        let pending: Vec<_> = programs
+            .into_iter()
+            .map(|mut spec| {
+                let stdio = spec.stdio_value();
+                (self.inner.spawn_async(&mut spec), stdio)
+            })
+            .collect();
+        let spawned: Vec<Result<(Process, crate::Stdio)>> = pending
+            .into_iter()
+            .map(|(completion, stdio)| {
+                let spawned = completion.and_then(|completion| completion.wait())?;
+                let process = unsafe { Process::from_pid_unchecked(spawned.id as i32) };
+                Ok((process, stdio))
+            })
+            .collect();
+
+        let processes: Vec<Process> = spawned
+            .iter()
+            .filter_map(|spawned| spawned.as_ref().ok().map(|&(process, _)| process))
+            .collect();
+        let mut injections = match self.inner.inject_many(&processes, &library) {
+            Ok(injections) => injections.into_iter(),
+            Err(err) => {
+                for &process in &processes {
+                    let _ = self.inner.kill(process);
+                }
+                return Err(err);
+            }
+        };
+
+        // Resume all injected children back to back, then collect the outcomes.
+        let staged: Vec<_> = spawned
+            .into_iter()
+            .map(|spawned| {
+                let (process, stdio) = spawned?;
+                let injection = injections
+                    .next()
+                    .expect("one injection per spawned process");
+                match injection {
+                    Ok(injection) => {
+                        Ok((process, stdio, injection, self.inner.resume_async(process)))
+                    }
+                    Err(err) => {
+                        let _ = self.inner.kill(process);
+                        Err(err)
+                    }
+                }
+            })
+            .collect();
+        Ok(staged
+            .into_iter()
+            .map(|staged| {
+                let (process, stdio, injection, resumed) = staged?;
+                if let Err(err) = resumed.and_then(|completion| completion.wait()) {
+                    let _ = self
+                        .inner
+                        .uninject(injection.id as u64, injection.path, None);
+                    let _ = self.inner.kill(process);
+                    return Err(err);
+                }
+                let child = self.child(process, stdio);
+                Ok(InjectedProgram::new(
+                    self.injected(process, injection, &library),
+                    child,
+                ))
+            })
+            .collect())
+    }
+
+    pub(crate) async fn inject_process_async(
+        &self,
+        process: Process,
+        library: Library,
+    ) -> Result<InjectedProcess> {
+        let injection = self.inner.inject_process_async(process, &library)?.await?;
+        Ok(self.injected(process, injection, &library))
+    }
+
+    pub(crate) async fn spawn_async(&self, mut spec: Program) -> Result<SuspendedProgram> {
+        let stdio = spec.stdio_value();
+        let spawned = self.inner.spawn_async(&mut spec)?.await?;
+        let process = unsafe { Process::from_pid_unchecked(spawned.id as i32) };
+        Ok(SuspendedProgram::new(self.clone(), process, stdio))
+    }
+
+    pub(crate) async fn resume_async(&self, process: Process) -> Result<()> {
+        self.inner.resume_async(process)?.await.map(|_| ())
+    }
+
+    pub(crate) async fn uninject_async(&self, id: u64, path: crate::InjectionPath) -> Result<()> {
+        self.inner.uninject_async(id, path)?.await?;
+        self.inner.uninjected(id, path);
+        Ok(())
+    }
+
+    fn injected(
+        &self,
+        process: Process,
+        injection: Injection,
+        library: &Library,
+    ) -> InjectedProcess {
+        InjectedProcess::new(
+            self.clone(),
+            injection.id as u64,
+            process,
+            injection.path,
+            library.clone(),
+        )
     }
 }
 
-static BACKEND: OnceLock<Result<BackendHandle>> = OnceLock::new();
+/// A demonitor started by [`BackendHandle::begin_uninject`].
+pub(crate) struct PendingUninject {
+    completion: Result<frida::Completion>,
+    // Also keeps the context alive when the caller's handle was consumed.
+    backend: BackendHandle,
+    id: u64,
+    path: crate::InjectionPath,
+}
 
-pub(crate) fn default_backend() -> Result<BackendHandle> {
-    if let Some(existing) = BACKEND.get() {
-        return existing.clone();
+impl PendingUninject {
+    /// Block until the demonitor completes; never call on Frida's main thread.
+    pub(crate) fn wait(self) -> Result<()> {
+        self.completion.and_then(|completion| completion.wait())?;
+        self.backend.inner.uninjected(self.id, self.path);
+        Ok(())
     }
+}
+
+/// Create a backend with its own Frida context, injector and helper.
+pub(crate) fn new_backend() -> Result<BackendHandle> {
+    frida::init().map(BackendHandle::new)
+}
 
-    let handle = frida::init().map(BackendHandle::new);
+/// Create a backend bound to one device, waiting up to `timeout` for USB
+/// and id lookups.
+pub(crate) fn new_device_backend(
+    target: &crate::DeviceTarget,
+    timeout: std::time::Duration,
+) -> Result<BackendHandle> {
+    frida::init_device(target, timeout).map(BackendHandle::new)
+}
 
-    let _ = BACKEND.set(handle.clone());
-    handle
+static BACKEND: OnceLock<Result<BackendHandle>> = OnceLock::new();
+
+/// The shared backend, created on first use.
+///
+/// Creating a local context only sets up the runtime and an injector, which
+/// cannot fail transiently: the device and helper are brought up by the
+/// first operation that needs them, and a failure there is retried by the
+/// next one. So the outcome is created once and cached, error included.
+pub(crate) fn default_backend() -> Result<BackendHandle> {
+    BACKEND.get_or_init(new_backend).clone()
 }
@@ -0,0 +1,161 @@
+use std::sync::Arc;
+
+use crate::preflight::{self, Image};
+use crate::{Error, InjectedProcess, Library, Process, Result};
+
+/// One build of an agent per architecture, injected by target.
+///
+/// Each variant is an ordinary [`Library`], file-backed or in-memory, whose
+/// headers are parsed once when it is added. Injecting a bundle reads the
+/// target's executable header (cached per file, as for
+/// [`Library::preflight`]) and uses the variant built for it, so a fleet of
+/// mixed x86_64, arm64 and 32-bit processes is served on the first attempt
+/// instead of retrying failed injections with another build.
+///
+/// When a target's architecture cannot be read, the variant matching this
+/// process is used. A universal (fat) target executable matches the first
+/// variant added for any of its architectures.
+///
+/// # Examples
+/// ```no_run
+/// use hook_inject::{Library, LibraryBundle, Process};
+///
+/// let bundle = LibraryBundle::new()
+///     .with_variant(Library::from_path("/opt/agent/x86_64/libagent.so")?)?
+///     .with_variant(Library::from_path("/opt/agent/aarch64/libagent.so")?)?
+///     .with_variant(Library::from_path("/opt/agent/i686/libagent.so")?)?;
+///
+/// let targets = [Process::from_pid(1234)?, Process::from_pid(5678)?];
+/// for result in bundle.inject_processes(&targets)? {
+///     let _injected = result?;
+/// }
+/// # Ok::<(), hook_inject::Error>(())
+/// ```
+#[derive(Debug, Clone, Default)]
+pub struct LibraryBundle {
+    variants: Vec<Variant>,
+}
+
+#[derive(Debug, Clone)]
+struct Variant {
+    library: Library,
+    image: Arc<Image>,
+}
+
+impl LibraryBundle {
+    /// An empty bundle.
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    /// Add the build of the agent for the architecture(s) in its headers.
+    ///
+    /// Fails if the library is not an ELF, Mach-O or PE image, or if the
+    /// bundle already has a variant for one of its architectures.
+    pub fn with_variant(mut self, library: impl Into<Library>) -> Result<Self> {
+        let library = library.into();
+        let image = preflight::inspect(&library)?;
+        if let Some(existing) = self
+            .variants
+            .iter()
+            .find(|variant| variant.image.shares_arch(&image))
+        {
+            return Err(Error::invalid_input(format_args!(
+                "library bundle already has a variant for {}",
+                existing.image.arches()
+            )));
+        }
+        self.variants.push(Variant { library, image });
+        Ok(self)
+    }
+
+    /// Libraries in the bundle, in the order they were added.
+    pub fn variants(&self) -> impl Iterator<Item = &Library> {
+        self.variants.iter().map(|variant| &variant.library)
+    }
+
+    /// The variant that would be injected into `process`.
+    pub fn select(&self, process: Process) -> Result<&Library> {
+        self.select_index(process)
+            .map(|index| &self.variants[index].library)
+    }
+
+    /// Inject the matching variant into an already-running process.
+    ///
+    /// See [`inject_process`](crate::inject_process).
+    pub fn inject_process(&self, process: Process) -> Result<InjectedProcess> {
+        crate::inject_process(process, self.select(process)?.clone())
+    }
+
+    /// Inject the matching variant into each of many running processes.
+    ///
+    /// Targets are grouped by variant and each group is injected
+    /// concurrently, as with [`inject_processes`](crate::inject_processes).
+    /// Results are in the same order as `processes`; a target no variant
+    /// matches, or whose group could not be injected at all, gets its own
+    /// error. Only an unavailable backend fails the whole call, before any
+    /// target is touched.
+    pub fn inject_processes(&self, processes: &[Process]) -> Result<Vec<Result<InjectedProcess>>> {
+        let backend = crate::backend::default_backend()?;
+        let mut results: Vec<Option<Result<InjectedProcess>>> =
+            processes.iter().map(|_| None).collect();
+        let mut groups: Vec<Vec<usize>> = vec![Vec::new(); self.variants.len()];
+        for (index, &process) in processes.iter().enumerate() {
+            match self.select_index(process) {
+                Ok(variant) => groups[variant].push(index),
+                Err(err) => results[index] = Some(Err(err)),
+            }
+        }
+
+        for (variant, group) in groups.iter().enumerate() {
+            if group.is_empty() {
+                continue;
+            }
+            let targets: Vec<Process> = group.iter().map(|&index| processes[index]).collect();
+            let library = self.variants[variant].library.clone();
+            // Later groups still run, and earlier ones keep their handles.
+            match backend.inject_processes(&targets, library) {
+                Ok(group_results) => {
+                    for (&index, result) in group.iter().zip(group_results) {
+                        results[index] = Some(result);
+                    }
+                }
+                Err(err) => {
+                    for &index in group {
+                        results[index] = Some(Err(err.clone()));
+                    }
+                }
+            }
+        }
+        Ok(results
+            .into_iter()
+            .map(|result| result.expect("every target has a result"))
+            .collect())
+    }
+
+    fn select_index(&self, process: Process) -> Result<usize> {
+        if self.variants.is_empty() {
+            return Err(Error::invalid_input("library bundle is empty"));
+        }
+
+        let target = preflight::target_image(process).or_else(|| {
+            let own = unsafe { Process::from_pid_unchecked(std::process::id() as i32) };
+            preflight::target_image(own)
+        });
+        self.variants
+            .iter()
+            .position(|variant| {
+                variant
+                    .image
+                    .check(target.as_deref(), variant.library.entrypoint())
+                    .is_ok()
+            })
+            .ok_or_else(|| {
+                let arch = target.map_or_else(|| "unknown".to_string(), |image| image.arches());
+                Error::invalid_input(format_args!(
+                    "no library variant matches process {} ({arch})",
+                    process.pid()
+                ))
+            })
+    }
+}
@@ -0,0 +1,222 @@
+use std::cmp::Ordering;
+use std::collections::BinaryHeap;
+use std::sync::{Arc, Condvar, Mutex, OnceLock, Weak};
+use std::time::{Duration, Instant};
+
+use crate::backend::NativeCancellable;
+
+/// Cancellation token and optional deadline for blocking operations.
+///
+/// Pass one to the `*_cancellable` variants of [`inject_process`],
+/// [`inject_program`], [`spawn`], [`SuspendedProgram::resume`],
+/// [`SuspendedProgram::inject`] and `uninject`. Cancelling it, or reaching its deadline, makes every call it
+/// was given return an error for which [`Error::is_cancelled`] is true, so a
+/// wedged target (stopped under a debugger, stuck in a kernel wait) cannot
+/// hold the calling thread forever. Clones share one token, so a whole wave
+/// of operations can be abandoned at once.
+///
+/// Cancellation stops the wait, not necessarily the work: an injection that
+/// Frida already started may still land, and a cancelled spawn may leave a
+/// suspended process behind.
+///
+/// [`inject_process`]: crate::inject_process
+/// [`inject_program`]: crate::inject_program
+/// [`spawn`]: crate::spawn
+/// [`SuspendedProgram::resume`]: crate::SuspendedProgram::resume
+/// [`SuspendedProgram::inject`]: crate::SuspendedProgram::inject
+/// [`Error::is_cancelled`]: crate::Error::is_cancelled
+///
+/// # Examples
+/// ```no_run
+/// use hook_inject::{inject_process_cancellable, Cancellation, Library, Process};
+/// use std::time::Duration;
+///
+/// let library = Library::from_path("/path/to/libagent.so")?;
+/// let wave = Cancellation::with_timeout(Duration::from_secs(10));
+/// for pid in [1234, 5678] {
+///     let process = Process::from_pid(pid)?;
+///     match inject_process_cancellable(process, library.clone(), &wave) {
+///         Ok(injected) => println!("injected {}", injected.process().pid()),
+///         Err(err) if err.is_cancelled() => eprintln!("{pid}: gave up"),
+///         Err(err) => return Err(err),
+///     }
+/// }
+/// # Ok::<(), hook_inject::Error>(())
+/// ```
+#[derive(Clone)]
+pub struct Cancellation {
+    inner: Arc<Token>,
+}
+
+struct Token {
+    native: NativeCancellable,
+    deadline: Option<Instant>,
+}
+
+impl Cancellation {
+    /// A token that is only cancelled by [`cancel`](Self::cancel).
+    pub fn new() -> Self {
+        Self::build(None)
+    }
+
+    /// A token that cancels itself `timeout` from now.
+    pub fn with_timeout(timeout: Duration) -> Self {
+        match Instant::now().checked_add(timeout) {
+            Some(deadline) => Self::with_deadline(deadline),
+            None => Self::new(),
+        }
+    }
+
+    /// A token that cancels itself at `deadline`.
+    pub fn with_deadline(deadline: Instant) -> Self {
+        let cancellation = Self::build(Some(deadline));
+        if deadline <= Instant::now() {
+            cancellation.cancel();
+        } else {
+            timer().schedule(deadline, Arc::downgrade(&cancellation.inner));
+        }
+        cancellation
+    }
+
+    fn build(deadline: Option<Instant>) -> Self {
+        Self {
+            inner: Arc::new(Token {
+                native: NativeCancellable::new(),
+                deadline,
+            }),
+        }
+    }
+
+    /// Cancel every operation using this token, now and in the future.
+    pub fn cancel(&self) {
+        self.inner.native.cancel();
+    }
+
+    /// Whether the token was cancelled or its deadline has passed.
+    pub fn is_cancelled(&self) -> bool {
+        self.inner.native.is_cancelled() || self.expired()
+    }
+
+    /// The deadline, if the token has one.
+    pub fn deadline(&self) -> Option<Instant> {
+        self.inner.deadline
+    }
+
+    /// The native cancellable to hand to the shim.
+    pub(crate) fn native(&self) -> &NativeCancellable {
+        // Do not rely on the timer thread for a deadline that already passed.
+        if self.expired() {
+            self.cancel();
+        }
+        &self.inner.native
+    }
+
+    fn expired(&self) -> bool {
+        self.inner
+            .deadline
+            .is_some_and(|deadline| deadline <= Instant::now())
+    }
+}
+
+impl Default for Cancellation {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+impl std::fmt::Debug for Cancellation {
+    fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
+        f.debug_struct("Cancellation")
+            .field("cancelled", &self.is_cancelled())
+            .field("deadline", &self.inner.deadline)
+            .finish()
+    }
+}
+
+/// Deadlines of live tokens, serviced by one lazily started thread.
+///
+/// If the thread cannot be started, deadlines are still honoured when an
+/// operation starts, just not while it is waiting.
+struct Timer {
+    queue: Mutex<BinaryHeap<Scheduled>>,
+    changed: Condvar,
+}
+
+struct Scheduled {
+    deadline: Instant,
+    token: Weak<Token>,
+}
+
+// Ordered so the BinaryHeap pops the earliest deadline first.
+impl Ord for Scheduled {
+    fn cmp(&self, other: &Self) -> Ordering {
+        other.deadline.cmp(&self.deadline)
+    }
+}
+
+impl PartialOrd for Scheduled {
+    fn partial_cmp(&self, other: &Self) -> Option<Ordering> {
+        Some(self.cmp(other))
+    }
+}
+
+impl PartialEq for Scheduled {
+    fn eq(&self, other: &Self) -> bool {
+        self.deadline == other.deadline
+    }
+}
+
+impl Eq for Scheduled {}
+
+fn timer() -> &'static Timer {
+    static TIMER: OnceLock<Timer> = OnceLock::new();
+    TIMER.get_or_init(|| {
+        let _ = std::thread::Builder::new()
+            .name("hook-inject-deadline".into())
+            .spawn(|| timer().run());
+        Timer {
+            queue: Mutex::new(BinaryHeap::new()),
+            changed: Condvar::new(),
+        }
+    })
+}
+
+impl Timer {
+    fn schedule(&self, deadline: Instant, token: Weak<Token>) {
+        lock(&self.queue).push(Scheduled { deadline, token });
+        self.changed.notify_one();
+    }
+
+    fn run(&self) {
+        let mut queue = lock(&self.queue);
+        loop {
+            let now = Instant::now();
+            match queue.peek() {
+                None => {
+                    queue = self
+                        .changed
+                        .wait(queue)
+                        .unwrap_or_else(|err| err.into_inner());
+                }
+                Some(next) if next.deadline > now => {
+                    let timeout = next.deadline - now;
+                    queue = match self.changed.wait_timeout(queue, timeout) {
+                        Ok((queue, _)) => queue,
+                        Err(err) => err.into_inner().0,
+                    };
+                }
+                Some(_) => {
+                    let due = queue.pop().expect("peeked entry");
+                    // Dropped tokens have nothing left to cancel.
+                    if let Some(token) = due.token.upgrade() {
+                        token.native.cancel();
+                    }
+                }
+            }
+        }
+    }
+}
+
+fn lock<T>(mutex: &Mutex<T>) -> std::sync::MutexGuard<'_, T> {
+    mutex.lock().unwrap_or_else(|err| err.into_inner())
+}
@@ -0,0 +1,206 @@
+use std::collections::HashMap;
+use std::sync::{Mutex, MutexGuard, OnceLock};
+use std::time::Duration;
+
+use crate::backend::{self, BackendHandle};
+use crate::{
+    InjectedProcess, InjectedProgram, Library, PreparedProgram, Process, ProcessInfo, Program,
+    Result, SuspendedProgram, WarmUpReport,
+};
+
+/// How long [`Device::connect`] waits for a USB or id-selected device to
+/// appear.
+const LOOKUP_TIMEOUT: Duration = Duration::from_secs(5);
+
+/// Which Frida device a [`Device`] talks to.
+#[derive(Debug, Clone, PartialEq, Eq, Hash)]
+pub enum DeviceTarget {
+    /// This machine, through the crate's default backend.
+    Local,
+    /// The first USB device.
+    Usb,
+    /// A `frida-server` reachable over TCP, as `"host"` or `"host:port"`.
+    Remote(String),
+    /// Any device by its Frida id, such as a USB serial number.
+    Id(String),
+}
+
+/// A connection to a Frida device, shared by everything connected to it.
+///
+/// Connections are pooled per [`DeviceTarget`] for the life of the process:
+/// the first [`connect`](Self::connect) creates a backend and brings up the
+/// device's host session, and later calls for the same target reuse it, so
+/// a controller pushing injections to many nodes pays each node's cold
+/// start once. A connection that drops (server restart, cable pulled) is
+/// re-established by the next operation. [`close`](Self::close) removes a
+/// target from the pool.
+///
+/// Pids, library paths and program paths are interpreted on the device.
+/// [`Library::from_path`] only checks that the file exists here, so for
+/// remote targets prefer [`Library::from_bytes`] or [`Library::from_mmap`],
+/// which send the payload over the connection. Remote pids are not
+/// validated locally; take them from [`processes`](Self::processes) or use
+/// [`Process::from_pid_unchecked`].
+///
+/// Non-local devices have no local injector: every injection uses Frida's
+/// device path, whose injections are not monitored, so `uninject` has
+/// nothing to stop and succeeds immediately.
+///
+/// # Examples
+/// ```no_run
+/// use hook_inject::{Device, DeviceTarget, Library};
+///
+/// let agent = Library::from_bytes(std::fs::read("/opt/agent/libagent.so")?)?;
+/// for node in ["10.0.0.11:27042", "10.0.0.12:27042"] {
+///     let device = Device::connect(DeviceTarget::Remote(node.into()))?;
+///     let workers: Vec<_> = device
+///         .processes()?
+///         .into_iter()
+///         .filter(|info| info.matches_name("worker"))
+///         .map(|info| info.process())
+///         .collect();
+///     for result in device.inject_processes(&workers, agent.clone())? {
+///         let _injected = result?;
+///     }
+/// }
+/// # Ok::<(), hook_inject::Error>(())
+/// ```
+#[derive(Debug, Clone)]
+pub struct Device {
+    backend: BackendHandle,
+    target: DeviceTarget,
+}
+
+impl Device {
+    /// Connect to `target`, or reuse the pooled connection to it.
+    ///
+    /// USB and id lookups wait up to five seconds for the device to appear.
+    pub fn connect(target: DeviceTarget) -> Result<Device> {
+        Self::connect_timeout(target, LOOKUP_TIMEOUT)
+    }
+
+    /// [`connect`](Self::connect) with an explicit lookup timeout for USB
+    /// and id targets.
+    ///
+    /// The timeout only applies when the connection is first made.
+    pub fn connect_timeout(target: DeviceTarget, timeout: Duration) -> Result<Device> {
+        if target == DeviceTarget::Local {
+            return Ok(Device {
+                backend: backend::default_backend()?,
+                target,
+            });
+        }
+
+        if let Some(backend) = lock(pool()).get(&target) {
+            return Ok(Device {
+                backend: backend.clone(),
+                target,
+            });
+        }
+
+        // Connect outside the lock so one slow node does not stall the rest.
+        let backend = backend::new_device_backend(&target, timeout)?;
+        backend.warm_up()?;
+        // A racing connect may have won; keep its connection and drop ours.
+        let backend = lock(pool())
+            .entry(target.clone())
+            .or_insert(backend)
+            .clone();
+        Ok(Device { backend, target })
+    }
+
+    /// The device this connection talks to.
+    pub fn target(&self) -> &DeviceTarget {
+        &self.target
+    }
+
+    /// Remove the connection from the pool.
+    ///
+    /// It closes once this and every other handle using it, including
+    /// injections and spawned programs, are dropped. The next
+    /// [`connect`](Self::connect) to the target opens a new one. Closing the
+    /// local device does nothing.
+    pub fn close(self) {
+        let mut pool = lock(pool());
+        if pool
+            .get(&self.target)
+            .is_some_and(|pooled| pooled.same_backend(&self.backend))
+        {
+            pool.remove(&self.target);
+        }
+    }
+
+    /// Bring up the device's host session, reconnecting if it was lost.
+    ///
+    /// See [`warm_up`](crate::warm_up).
+    pub fn warm_up(&self) -> Result<WarmUpReport> {
+        self.backend.warm_up()
+    }
+
+    /// Processes running on the device, with names, paths and owners.
+    pub fn processes(&self) -> Result<Vec<ProcessInfo>> {
+        Ok(self
+            .backend
+            .enumerate_processes(&[], true)?
+            .into_iter()
+            .map(ProcessInfo::new)
+            .collect())
+    }
+
+    /// Inject a library into a process running on the device.
+    ///
+    /// See [`inject_process`](crate::inject_process).
+    pub fn inject_process(
+        &self,
+        process: Process,
+        library: impl Into<Library>,
+    ) -> Result<InjectedProcess> {
+        self.backend.inject_process(process, library.into(), None)
+    }
+
+    /// Inject the same library into many processes on the device at once.
+    ///
+    /// See [`inject_processes`](crate::inject_processes).
+    pub fn inject_processes(
+        &self,
+        processes: &[Process],
+        library: impl Into<Library>,
+    ) -> Result<Vec<Result<InjectedProcess>>> {
+        self.backend.inject_processes(processes, library.into())
+    }
+
+    /// Launch a program on the device with the library injected.
+    ///
+    /// See [`inject_program`](crate::inject_program).
+    pub fn inject_program(
+        &self,
+        spec: impl Into<Program>,
+        library: impl Into<Library>,
+    ) -> Result<InjectedProgram> {
+        self.backend
+            .inject_program(spec.into(), library.into(), None)
+    }
+
+    /// Spawn a program on the device, suspended.
+    ///
+    /// See [`spawn`](crate::spawn).
+    pub fn spawn(&self, spec: impl Into<Program>) -> Result<SuspendedProgram> {
+        self.backend.spawn(spec.into(), None)
+    }
+
+    /// Marshal a program once for repeated launches on the device.
+    ///
+    /// See [`PreparedProgram`].
+    pub fn prepare(&self, spec: impl Into<Program>) -> Result<PreparedProgram> {
+        PreparedProgram::with_backend(self.backend.clone(), &spec.into())
+    }
+}
+
+fn pool() -> &'static Mutex<HashMap<DeviceTarget, BackendHandle>> {
+    static POOL: OnceLock<Mutex<HashMap<DeviceTarget, BackendHandle>>> = OnceLock::new();
+    POOL.get_or_init(Default::default)
+}
+
+fn lock<T>(mutex: &Mutex<T>) -> MutexGuard<'_, T> {
+    mutex.lock().unwrap_or_else(|err| err.into_inner())
+}
@@ -0,0 +1,222 @@
+use std::collections::{BTreeMap, BTreeSet};
+use std::path::{Path, PathBuf};
+
+use crate::backend::{self, BackendHandle, EnumeratedProcess};
+use crate::{Process, Result};
+
+/// A running process as seen by the backend.
+#[derive(Debug, Clone, PartialEq, Eq)]
+pub struct ProcessInfo {
+    process: Process,
+    name: String,
+    path: Option<PathBuf>,
+    uid: Option<u32>,
+}
+
+impl ProcessInfo {
+    pub(crate) fn new(entry: EnumeratedProcess) -> Self {
+        Self {
+            process: unsafe { Process::from_pid_unchecked(entry.pid as i32) },
+            name: entry.name,
+            path: entry.path,
+            uid: entry.uid,
+        }
+    }
+
+    /// Handle to the process.
+    pub fn process(&self) -> Process {
+        self.process
+    }
+
+    /// Process name, usually the executable's file name.
+    pub fn name(&self) -> &str {
+        &self.name
+    }
+
+    /// Executable path, when the platform reports one.
+    pub fn path(&self) -> Option<&Path> {
+        self.path.as_deref()
+    }
+
+    /// Owner uid, when the platform reports one.
+    pub fn uid(&self) -> Option<u32> {
+        self.uid
+    }
+
+    /// Whether the process name or executable file name equals `name`.
+    pub fn matches_name(&self, name: &str) -> bool {
+        self.name == name
+            || self
+                .path
+                .as_deref()
+                .and_then(Path::file_name)
+                .is_some_and(|file_name| file_name == name)
+    }
+}
+
+/// Processes that appeared or went away during [`ProcessIndex::refresh`].
+///
+/// A pid that was reused by a different program shows up in both lists.
+#[derive(Debug, Clone, Default, PartialEq, Eq)]
+pub struct ProcessChanges {
+    added: Vec<Process>,
+    removed: Vec<Process>,
+}
+
+impl ProcessChanges {
+    /// Processes new to the index.
+    pub fn added(&self) -> &[Process] {
+        &self.added
+    }
+
+    /// Processes no longer running.
+    pub fn removed(&self) -> &[Process] {
+        &self.removed
+    }
+
+    /// Whether nothing changed.
+    pub fn is_empty(&self) -> bool {
+        self.added.is_empty() && self.removed.is_empty()
+    }
+}
+
+/// Snapshot of the local process list that can be refreshed cheaply.
+///
+/// The first scan collects name, path and uid for every process. Later
+/// [`refresh`](Self::refresh) calls only list pids and names, then look up
+/// details for the pids that are new or whose name changed, so repeated
+/// sweeps stay cheap on hosts with many long-lived processes.
+///
+/// # Examples
+/// ```no_run
+/// use hook_inject::{Library, Process, ProcessIndex, inject_processes};
+///
+/// let mut index = ProcessIndex::new()?;
+/// let library = Library::from_path("/path/to/libagent.so")?;
+/// let workers: Vec<Process> = index
+///     .find_by_name("nginx")
+///     .map(|info| info.process())
+///     .collect();
+/// let _ = inject_processes(&workers, library.clone())?;
+///
+/// // Later: only inject into workers started since the last sweep.
+/// let changes = index.refresh()?;
+/// let fresh: Vec<Process> = changes
+///     .added()
+///     .iter()
+///     .copied()
+///     .filter(|&process| index.get(process).is_some_and(|info| info.matches_name("nginx")))
+///     .collect();
+/// let _ = inject_processes(&fresh, library)?;
+/// # Ok::<(), hook_inject::Error>(())
+/// ```
+#[derive(Debug)]
+pub struct ProcessIndex {
+    backend: BackendHandle,
+    entries: BTreeMap<i32, ProcessInfo>,
+}
+
+impl ProcessIndex {
+    /// Scan the local process list.
+    pub fn new() -> Result<Self> {
+        let backend = backend::default_backend()?;
+        let entries = backend
+            .enumerate_processes(&[], true)?
+            .into_iter()
+            .map(|entry| {
+                let info = ProcessInfo::new(entry);
+                (info.process.pid(), info)
+            })
+            .collect();
+        Ok(Self { backend, entries })
+    }
+
+    /// Bring the index up to date and report what changed.
+    pub fn refresh(&mut self) -> Result<ProcessChanges> {
+        let current = self.backend.enumerate_processes(&[], false)?;
+
+        let mut changes = ProcessChanges::default();
+        let mut stale = Vec::new();
+        let mut alive = BTreeSet::new();
+        for entry in current {
+            let pid = entry.pid as i32;
+            match self.entries.get(&pid) {
+                Some(known) if known.name == entry.name => {}
+                Some(known) => {
+                    changes.removed.push(known.process);
+                    stale.push(entry.pid);
+                }
+                None => stale.push(entry.pid),
+            }
+            alive.insert(pid);
+        }
+
+        self.entries.retain(|pid, info| {
+            let keep = alive.contains(pid);
+            if !keep {
+                changes.removed.push(info.process);
+            }
+            keep
+        });
+
+        if !stale.is_empty() {
+            for pid in &stale {
+                self.entries.remove(&(*pid as i32));
+            }
+            // Processes that exit before the detail query are simply absent.
+            for entry in self.backend.enumerate_processes(&stale, true)? {
+                let info = ProcessInfo::new(entry);
+                changes.added.push(info.process);
+                self.entries.insert(info.process.pid(), info);
+            }
+        }
+
+        changes.removed.sort_by_key(Process::pid);
+        changes.added.sort_by_key(Process::pid);
+        Ok(changes)
+    }
+
+    /// Look up a process by handle.
+    pub fn get(&self, process: Process) -> Option<&ProcessInfo> {
+        self.entries.get(&process.pid())
+    }
+
+    /// All indexed processes, ordered by pid.
+    pub fn iter(&self) -> impl Iterator<Item = &ProcessInfo> {
+        self.entries.values()
+    }
+
+    /// Processes whose name or executable file name equals `name`.
+    pub fn find_by_name<'a>(&'a self, name: &'a str) -> impl Iterator<Item = &'a ProcessInfo> {
+        self.iter().filter(move |info| info.matches_name(name))
+    }
+
+    /// Number of indexed processes.
+    pub fn len(&self) -> usize {
+        self.entries.len()
+    }
+
+    /// Whether the index is empty.
+    pub fn is_empty(&self) -> bool {
+        self.entries.is_empty()
+    }
+}
+
+/// List running processes on the local machine.
+///
+/// # Examples
+/// ```no_run
+/// let targets: Vec<_> = hook_inject::processes()?
+///     .into_iter()
+///     .filter(|info| info.matches_name("nginx"))
+///     .map(|info| info.process())
+///     .collect();
+/// # Ok::<(), hook_inject::Error>(())
+/// ```
+pub fn processes() -> Result<Vec<ProcessInfo>> {
+    Ok(backend::default_backend()?
+        .enumerate_processes(&[], true)?
+        .into_iter()
+        .map(ProcessInfo::new)
+        .collect())
+}
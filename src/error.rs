@@ -13,6 +13,7 @@ enum ErrorKind {
     PermissionDenied,
     Io,
     Runtime,
+    Cancelled,
 }
 
 /// Error type for this crate.
@@ -54,6 +55,10 @@ impl Error {
         Self::new(ErrorKind::Runtime, msg)
     }
 
+    pub(crate) fn cancelled(msg: impl Display) -> Self {
+        Self::new(ErrorKind::Cancelled, msg)
+    }
+
     pub(crate) fn from_io(err: std::io::Error) -> Self {
         Self {
             kind: ErrorKind::Io,
@@ -94,6 +99,12 @@ impl Error {
     pub fn is_not_supported(&self) -> bool {
         self.kind == ErrorKind::NotSupported
     }
+
+    /// Returns true if the operation was cancelled or ran past its deadline
+    /// (see [`Cancellation`](crate::Cancellation)).
+    pub fn is_cancelled(&self) -> bool {
+        self.kind == ErrorKind::Cancelled
+    }
 }
 
 impl Clone for Error {
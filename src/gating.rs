@@ -0,0 +1,332 @@
+use std::collections::HashMap;
+use std::sync::atomic::{AtomicBool, Ordering};
+use std::sync::mpsc::{self, Sender};
+use std::sync::{Arc, Mutex, MutexGuard, Weak};
+
+use crate::backend::{BackendHandle, WeakBackend};
+use crate::{Error, InjectedProcess, Library, Process, Result};
+
+/// How a gated child process came to be.
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Hash)]
+pub enum ChildOrigin {
+    /// `fork()`: the child starts as a copy of its parent, library included.
+    Fork,
+    /// `exec()`: the process kept its pid but replaced its image.
+    Exec,
+    /// A spawn API such as `posix_spawn` or `CreateProcess`.
+    Spawn,
+}
+
+/// A child caught by [`ChildGating`], after injection and resume.
+#[derive(Debug)]
+pub struct GatedChild {
+    process: Process,
+    parent: Process,
+    origin: ChildOrigin,
+    injected: Option<Result<InjectedProcess>>,
+}
+
+impl GatedChild {
+    /// The new child process.
+    pub fn process(&self) -> Process {
+        self.process
+    }
+
+    /// The process that created it (the child itself for `exec`).
+    pub fn parent(&self) -> Process {
+        self.parent
+    }
+
+    /// How the child was created.
+    pub fn origin(&self) -> ChildOrigin {
+        self.origin
+    }
+
+    /// Outcome of injecting the child, or `None` for a fork child that
+    /// was resumed as is (see [`ChildGating::inject_forks`]).
+    pub fn injected(&self) -> Option<&Result<InjectedProcess>> {
+        self.injected.as_ref()
+    }
+
+    /// Take the injection outcome.
+    pub fn into_injected(self) -> Option<Result<InjectedProcess>> {
+        self.injected
+    }
+}
+
+/// Child gating for a process tree, from [`InjectedProcess::follow_children`].
+///
+/// While enabled, Frida holds every child the process (or any gated
+/// descendant) forks, execs or spawns before it runs. Each child is
+/// injected with the library, gated in turn and then resumed, so even
+/// short-lived children are covered without polling for new pids.
+///
+/// A `fork` child is a copy of its parent and already carries whatever the
+/// parent had loaded, so by default it is only gated and resumed; injecting
+/// it again would run the entrypoint a second time in the same image. Its
+/// `exec`, if any, is reported separately and injected. Use
+/// [`inject_forks`](Self::inject_forks) when the parent may not have the
+/// library, for example with [`follow_children_with`](InjectedProcess::follow_children_with).
+///
+/// Gating stops when this handle is dropped or [`disable`](Self::disable)d;
+/// children that were already resumed keep their injection.
+///
+/// # Examples
+/// ```no_run
+/// use hook_inject::{inject_process, Library, Process};
+///
+/// let process = unsafe { Process::from_pid_unchecked(1234) };
+/// let library = Library::from_path("/path/to/libagent.so")?;
+/// let injected = inject_process(process, library)?;
+///
+/// let gating = injected.follow_children()?;
+/// gating.on_child(|child| {
+///     if let Some(Err(err)) = child.injected() {
+///         eprintln!("child {} not injected: {err}", child.process().pid());
+///     }
+/// });
+/// # drop(gating);
+/// # Ok::<(), hook_inject::Error>(())
+/// ```
+pub struct ChildGating {
+    backend: BackendHandle,
+    process: Process,
+    rule: Arc<Rule>,
+    enabled: bool,
+}
+
+impl ChildGating {
+    pub(crate) fn enable(
+        backend: BackendHandle,
+        process: Process,
+        library: Library,
+    ) -> Result<ChildGating> {
+        let rule = backend.gating().follow(&backend, process, library)?;
+        Ok(ChildGating {
+            backend,
+            process,
+            rule,
+            enabled: true,
+        })
+    }
+
+    /// The root process whose children are gated.
+    pub fn process(&self) -> Process {
+        self.process
+    }
+
+    /// Whether `fork` children are injected too. Off by default.
+    pub fn inject_forks(&self, inject: bool) {
+        self.rule.inject_forks.store(inject, Ordering::Relaxed);
+    }
+
+    /// Call `handler` for every gated child, replacing any previous handler.
+    ///
+    /// The handler runs on the backend's gating thread once the child has
+    /// been resumed; slow handlers delay the next child.
+    pub fn on_child(&self, handler: impl Fn(GatedChild) + Send + Sync + 'static) {
+        *lock(&self.rule.handler) = Some(Arc::new(handler));
+    }
+
+    /// Stop gating the process and every descendant gated so far.
+    pub fn disable(mut self) -> Result<()> {
+        self.enabled = false;
+        self.backend.gating().unfollow(&self.backend, &self.rule)
+    }
+}
+
+impl Drop for ChildGating {
+    fn drop(&mut self) {
+        if self.enabled {
+            let _ = self.backend.gating().unfollow(&self.backend, &self.rule);
+        }
+    }
+}
+
+impl std::fmt::Debug for ChildGating {
+    fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
+        f.debug_struct("ChildGating")
+            .field("process", &self.process)
+            .finish_non_exhaustive()
+    }
+}
+
+type ChildHandler = Arc<dyn Fn(GatedChild) + Send + Sync>;
+
+/// What to do with the children of one gated tree.
+pub(crate) struct Rule {
+    library: Library,
+    inject_forks: AtomicBool,
+    handler: Mutex<Option<ChildHandler>>,
+}
+
+pub(crate) enum ChildEvent {
+    /// A held child: pid, parent pid and origin.
+    Added(u32, u32, ChildOrigin),
+    /// The gating session of a pid ended.
+    Ended(u32),
+}
+
+/// Gated pids of one backend and the thread that services their children.
+///
+/// Frida reports children on its event thread, where the blocking inject
+/// and resume calls cannot run, so events are queued to a worker thread.
+#[derive(Default)]
+pub(crate) struct GatingRegistry {
+    state: Mutex<GatingState>,
+}
+
+#[derive(Default)]
+struct GatingState {
+    rules: HashMap<u32, Arc<Rule>>,
+    worker: Option<Sender<ChildEvent>>,
+}
+
+impl GatingRegistry {
+    pub(crate) fn post(&self, event: ChildEvent) {
+        if let Some(worker) = &lock(&self.state).worker {
+            let _ = worker.send(event);
+        }
+    }
+
+    fn follow(
+        self: &Arc<Self>,
+        backend: &BackendHandle,
+        process: Process,
+        library: Library,
+    ) -> Result<Arc<Rule>> {
+        let pid = process.pid() as u32;
+        let rule = Arc::new(Rule {
+            library,
+            inject_forks: AtomicBool::new(false),
+            handler: Mutex::new(None),
+        });
+        {
+            let mut state = lock(&self.state);
+            if state.rules.contains_key(&pid) {
+                return Err(Error::invalid_input(
+                    "child gating is already enabled for this process",
+                ));
+            }
+            if state.worker.is_none() {
+                state.worker = Some(spawn_worker(Arc::downgrade(self), backend.downgrade())?);
+            }
+            state.rules.insert(pid, rule.clone());
+        }
+
+        if let Err(err) = backend.enable_child_gating(process) {
+            lock(&self.state).rules.remove(&pid);
+            return Err(err);
+        }
+        Ok(rule)
+    }
+
+    fn unfollow(&self, backend: &BackendHandle, rule: &Arc<Rule>) -> Result<()> {
+        let pids: Vec<u32> = {
+            let mut state = lock(&self.state);
+            let pids = state
+                .rules
+                .iter()
+                .filter(|(_, entry)| Arc::ptr_eq(entry, rule))
+                .map(|(&pid, _)| pid)
+                .collect();
+            state.rules.retain(|_, entry| !Arc::ptr_eq(entry, rule));
+            pids
+        };
+
+        let mut result = Ok(());
+        for pid in pids {
+            let process = unsafe { Process::from_pid_unchecked(pid as i32) };
+            match backend.disable_child_gating(process) {
+                Err(err) if result.is_ok() && !err.is_process_not_found() => result = Err(err),
+                _ => {}
+            }
+        }
+        result
+    }
+
+    fn handle(&self, backend: &BackendHandle, event: ChildEvent) {
+        match event {
+            ChildEvent::Added(pid, parent_pid, origin) => {
+                self.adopt(backend, pid, parent_pid, origin)
+            }
+            ChildEvent::Ended(pid) => {
+                // An exec'd target is still alive and keeps its rule.
+                let gone =
+                    Process::from_pid(pid as i32).is_err_and(|err| err.is_process_not_found());
+                if gone {
+                    lock(&self.state).rules.remove(&pid);
+                }
+            }
+        }
+    }
+
+    fn adopt(&self, backend: &BackendHandle, pid: u32, parent_pid: u32, origin: ChildOrigin) {
+        let child = unsafe { Process::from_pid_unchecked(pid as i32) };
+        let parent = unsafe { Process::from_pid_unchecked(parent_pid as i32) };
+        let rule = {
+            let mut state = lock(&self.state);
+            let rule = state.rules.get(&parent_pid).cloned();
+            if let Some(rule) = &rule {
+                state.rules.insert(pid, rule.clone());
+            }
+            rule
+        };
+        let Some(rule) = rule else {
+            // Gating was disabled while the child was held.
+            let _ = backend.resume(child, None);
+            return;
+        };
+
+        let inject = origin != ChildOrigin::Fork || rule.inject_forks.load(Ordering::Relaxed);
+        let injected = inject.then(|| backend.inject_process(child, rule.library.clone(), None));
+        // Gate the child before it runs so its own children are held too.
+        if backend.enable_child_gating(child).is_err() {
+            let mut state = lock(&self.state);
+            if state
+                .rules
+                .get(&pid)
+                .is_some_and(|entry| Arc::ptr_eq(entry, &rule))
+            {
+                state.rules.remove(&pid);
+            }
+        }
+        let _ = backend.resume(child, None);
+
+        let handler = lock(&rule.handler).clone();
+        if let Some(handler) = handler {
+            let gated = GatedChild {
+                process: child,
+                parent,
+                origin,
+                injected,
+            };
+            let _ = std::panic::catch_unwind(std::panic::AssertUnwindSafe(|| handler(gated)));
+        }
+    }
+}
+
+fn spawn_worker(
+    registry: Weak<GatingRegistry>,
+    backend: WeakBackend,
+) -> Result<Sender<ChildEvent>> {
+    let (tx, rx) = mpsc::channel();
+    std::thread::Builder::new()
+        .name("hook-inject-gating".into())
+        .spawn(move || {
+            // The registry owns the sender, so this ends with the backend.
+            while let Ok(event) = rx.recv() {
+                let (Some(registry), Some(backend)) = (registry.upgrade(), backend.upgrade())
+                else {
+                    break;
+                };
+                registry.handle(&backend, event);
+            }
+        })
+        .map_err(Error::from)?;
+    Ok(tx)
+}
+
+fn lock<T>(mutex: &Mutex<T>) -> MutexGuard<'_, T> {
+    mutex.lock().unwrap_or_else(|err| err.into_inner())
+}
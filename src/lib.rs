@@ -42,21 +42,84 @@
 //!
 
 mod backend;
+mod bundle;
+mod cancel;
+mod device;
+mod discovery;
 mod error;
+mod gating;
 mod library;
+mod live_objects;
+mod mapping;
+mod metrics;
+mod pool;
+mod preflight;
 mod process;
 mod program;
+mod reaper;
+mod shared_data;
+mod staging;
+mod stdio;
+mod warm_up;
 
+pub use bundle::LibraryBundle;
+pub use cancel::Cancellation;
+pub use device::{Device, DeviceTarget};
+pub use discovery::{ProcessChanges, ProcessIndex, ProcessInfo, processes};
 pub use error::{Error, Result};
+pub use gating::{ChildGating, ChildOrigin, GatedChild};
 pub use library::Library;
-pub use process::Process;
-pub use program::{Child, Program, Stdio};
+pub use live_objects::LiveObjects;
+pub use metrics::{InjectionMetrics, InjectionOp, clear_metrics_hook, set_metrics_hook};
+pub use pool::{BackendPool, PoolStrategy};
+pub use process::{Process, ProcessHandle};
+pub use program::{Child, PreparedLaunch, PreparedProgram, Program, Stdio};
+pub use reaper::UninjectGuard;
+pub use shared_data::{SHARED_DATA_PREFIX, SharedData};
+pub use stdio::{ChildStderr, ChildStdin, ChildStdout, OUTPUT_BUFFER_LIMIT};
+pub use warm_up::WarmUpReport;
+
+/// Initialize the injection backend eagerly.
+///
+/// The first injection otherwise pays for `frida_init` and starting the
+/// injector helper, and the first spawn or device fallback for looking up the
+/// local device. Call this during start-up to move that cost off the first
+/// operation; the report says how long each phase took.
+///
+/// Fails if the injector helper or the host session cannot be brought up,
+/// with the error the first operation would otherwise have hit.
+///
+/// # Examples
+/// ```no_run
+/// let report = hook_inject::warm_up()?;
+/// println!("backend ready in {:?}", report.total());
+/// # Ok::<(), hook_inject::Error>(())
+/// ```
+pub fn warm_up() -> Result<WarmUpReport> {
+    backend::default_backend()?.warm_up()
+}
+
+/// Count the backend objects currently alive, for leak checks.
+///
+/// Cheap enough to poll; does not start a backend.
+///
+/// # Examples
+/// ```no_run
+/// let before = hook_inject::live_objects();
+/// // ... inject and uninject ...
+/// assert_eq!(hook_inject::live_objects().payloads(), before.payloads());
+/// ```
+pub fn live_objects() -> LiveObjects {
+    backend::live_objects()
+}
 
 /// Inject a library into a program launched under injector control.
 ///
 /// This spawns the process suspended, injects the library, and then resumes it.
-/// Stdout/stderr pipes are not exposed on this path; if you need to capture
-/// output, spawn with `Program::into_command()` and then inject by pid.
+/// To capture output, launch with [`Stdio::Pipe`] and take the streams from
+/// the returned [`InjectedProgram`]'s [`child_mut()`](InjectedProgram::child_mut)
+/// with [`take_stdout`](Child::take_stdout), [`take_stderr`](Child::take_stderr)
+/// and [`take_stdin`](Child::take_stdin).
 ///
 /// # Examples
 /// ```no_run
@@ -74,7 +137,18 @@ pub fn inject_program(
     spec: impl Into<Program>,
     library: impl Into<Library>,
 ) -> Result<InjectedProgram> {
-    backend::default_backend()?.inject_program(spec.into(), library.into())
+    backend::default_backend()?.inject_program(spec.into(), library.into(), None)
+}
+
+/// [`inject_program`] that gives up once `cancel` is cancelled or expires.
+///
+/// A child whose injection or resume is cancelled is killed.
+pub fn inject_program_cancellable(
+    spec: impl Into<Program>,
+    library: impl Into<Library>,
+    cancel: &Cancellation,
+) -> Result<InjectedProgram> {
+    backend::default_backend()?.inject_program(spec.into(), library.into(), Some(cancel))
 }
 
 /// Inject a library into an already-running process.
@@ -90,7 +164,81 @@ pub fn inject_program(
 /// # Ok::<(), hook_inject::Error>(())
 /// ```
 pub fn inject_process(process: Process, library: impl Into<Library>) -> Result<InjectedProcess> {
-    backend::default_backend()?.inject_process(process, library.into())
+    backend::default_backend()?.inject_process(process, library.into(), None)
+}
+
+/// [`inject_process`] that gives up once `cancel` is cancelled or expires.
+///
+/// See [`Cancellation`] for an example.
+pub fn inject_process_cancellable(
+    process: Process,
+    library: impl Into<Library>,
+    cancel: &Cancellation,
+) -> Result<InjectedProcess> {
+    backend::default_backend()?.inject_process(process, library.into(), Some(cancel))
+}
+
+/// Inject the same library into many running processes at once.
+///
+/// All injections are started concurrently, so the call takes roughly as long
+/// as the slowest target rather than the sum of all of them. The outer error
+/// reports a backend failure; each target gets its own result, in the same
+/// order as `processes`.
+///
+/// # Examples
+/// ```no_run
+/// use hook_inject::{inject_processes, Library, Process};
+///
+/// let processes = [
+///     unsafe { Process::from_pid_unchecked(1234) },
+///     unsafe { Process::from_pid_unchecked(5678) },
+/// ];
+/// let library = Library::from_path("/path/to/libagent.so")?;
+/// for result in inject_processes(&processes, library)? {
+///     match result {
+///         Ok(injected) => injected.uninject()?,
+///         Err(err) => eprintln!("injection failed: {err}"),
+///     }
+/// }
+/// # Ok::<(), hook_inject::Error>(())
+/// ```
+pub fn inject_processes(
+    processes: &[Process],
+    library: impl Into<Library>,
+) -> Result<Vec<Result<InjectedProcess>>> {
+    backend::default_backend()?.inject_processes(processes, library.into())
+}
+
+/// Uninject many libraries at once.
+///
+/// Every demonitor is submitted before any is waited on, so Frida runs them
+/// concurrently and tearing down a fleet costs about one round trip instead
+/// of one per handle. Handles may come from different backends, e.g. the
+/// members of a [`BackendPool`]. Each handle gets its own result, in order.
+///
+/// # Examples
+/// ```no_run
+/// use hook_inject::{inject_processes, uninject_all, Library, Process};
+///
+/// let processes = [Process::from_pid(1234)?, Process::from_pid(5678)?];
+/// let library = Library::from_path("/path/to/libagent.so")?;
+/// let injected = inject_processes(&processes, library)?.into_iter().flatten();
+/// for result in uninject_all(injected) {
+///     if let Err(err) = result {
+///         eprintln!("uninject failed: {err}");
+///     }
+/// }
+/// # Ok::<(), hook_inject::Error>(())
+/// ```
+pub fn uninject_all(injected: impl IntoIterator<Item = InjectedProcess>) -> Vec<Result<()>> {
+    let pending: Vec<_> = injected
+        .into_iter()
+        .map(|injected| injected.backend.begin_uninject(injected.id, injected.path))
+        .collect();
+    pending
+        .into_iter()
+        .map(backend::PendingUninject::wait)
+        .collect()
 }
 
 /// Spawn a program in a suspended state.
@@ -106,7 +254,85 @@ pub fn inject_process(process: Process, library: impl Into<Library>) -> Result<I
 /// # Ok::<(), hook_inject::Error>(())
 /// ```
 pub fn spawn(spec: impl Into<Program>) -> Result<SuspendedProgram> {
-    backend::default_backend()?.spawn(spec.into())
+    backend::default_backend()?.spawn(spec.into(), None)
+}
+
+/// [`spawn`] that gives up once `cancel` is cancelled or expires.
+pub fn spawn_cancellable(
+    spec: impl Into<Program>,
+    cancel: &Cancellation,
+) -> Result<SuspendedProgram> {
+    backend::default_backend()?.spawn(spec.into(), Some(cancel))
+}
+
+/// Launch a fleet of programs with the library injected, starting them together.
+///
+/// Every program is spawned suspended and injected concurrently, then all of
+/// them are resumed back to back, so the whole batch comes up in about one
+/// spawn+inject latency. Each program gets its own result, in order; a child
+/// whose injection or resume fails is killed.
+///
+/// # Examples
+/// ```no_run
+/// use hook_inject::{spawn_batch, Library, Program};
+///
+/// let workers = (0..8).map(|_| Program::new("/usr/bin/worker"));
+/// let library = Library::from_path("/path/to/libagent.so")?;
+/// for result in spawn_batch(workers, library)? {
+///     let _injected = result?;
+/// }
+/// # Ok::<(), hook_inject::Error>(())
+/// ```
+pub fn spawn_batch<P: Into<Program>>(
+    programs: impl IntoIterator<Item = P>,
+    library: impl Into<Library>,
+) -> Result<Vec<Result<InjectedProgram>>> {
+    let programs = programs.into_iter().map(Into::into).collect();
+    backend::default_backend()?.spawn_batch(programs, library.into())
+}
+
+/// Asynchronously inject a library into an already-running process.
+///
+/// The injection runs on Frida's own event loop, so awaiting it does not tie
+/// up the calling thread. Dropping the future does not cancel the injection.
+///
+/// # Examples
+/// ```no_run
+/// use hook_inject::{inject_process_async, Library, Process};
+///
+/// # async fn run() -> hook_inject::Result<()> {
+/// let process = unsafe { Process::from_pid_unchecked(1234) };
+/// let library = Library::from_path("/path/to/libagent.so")?;
+/// let injected = inject_process_async(process, library).await?;
+/// injected.uninject_async().await?;
+/// # Ok(())
+/// # }
+/// ```
+pub async fn inject_process_async(
+    process: Process,
+    library: impl Into<Library>,
+) -> Result<InjectedProcess> {
+    let library = library.into();
+    backend::default_backend()?
+        .inject_process_async(process, library)
+        .await
+}
+
+/// Asynchronously spawn a program in a suspended state.
+///
+/// # Examples
+/// ```no_run
+/// use hook_inject::{spawn_async, Program};
+///
+/// # async fn run() -> hook_inject::Result<()> {
+/// let suspended = spawn_async(Program::new("/usr/bin/true")).await?;
+/// let _child = suspended.resume_async().await?;
+/// # Ok(())
+/// # }
+/// ```
+pub async fn spawn_async(spec: impl Into<Program>) -> Result<SuspendedProgram> {
+    let spec = spec.into();
+    backend::default_backend()?.spawn_async(spec).await
 }
 
 /// Handle to a suspended program spawned by the injector.
@@ -133,13 +359,43 @@ impl SuspendedProgram {
 
     /// Inject a library and resume the suspended program.
     pub fn inject(self, library: Library) -> Result<InjectedProgram> {
-        let injected = self.backend.inject_process(self.process, library)?;
-        if let Err(err) = self.backend.resume(self.process) {
+        let injected = self.backend.inject_process(self.process, library, None)?;
+        if let Err(err) = self.backend.resume(self.process, None) {
             let _ = injected.uninject();
             return Err(err);
         }
 
-        let child = Child::new(self.process, self.stdio);
+        let child = self.backend.child(self.process, self.stdio);
+        Ok(injected.into_program(child))
+    }
+
+    /// [`inject`](Self::inject) that gives up once `cancel` is cancelled or
+    /// expires.
+    ///
+    /// On any failure, cancellation included, the program is killed rather
+    /// than left suspended, since this handle is consumed.
+    pub fn inject_cancellable(
+        self,
+        library: Library,
+        cancel: &Cancellation,
+    ) -> Result<InjectedProgram> {
+        let injected = match self
+            .backend
+            .inject_process(self.process, library, Some(cancel))
+        {
+            Ok(injected) => injected,
+            Err(err) => {
+                let _ = self.backend.kill(self.process);
+                return Err(err);
+            }
+        };
+        if let Err(err) = self.backend.resume(self.process, Some(cancel)) {
+            let _ = self.backend.kill(self.process);
+            let _ = injected.uninject();
+            return Err(err);
+        }
+
+        let child = self.backend.child(self.process, self.stdio);
         Ok(injected.into_program(child))
     }
 
@@ -147,25 +403,63 @@ impl SuspendedProgram {
     ///
     /// Returns an opaque handle to the spawned program.
     pub fn resume(self) -> Result<Child> {
-        self.backend.resume(self.process)?;
-        Ok(Child::new(self.process, self.stdio))
+        self.backend.resume(self.process, None)?;
+        Ok(self.backend.child(self.process, self.stdio))
+    }
+
+    /// [`resume`](Self::resume) that gives up once `cancel` is cancelled or
+    /// expires.
+    pub fn resume_cancellable(self, cancel: &Cancellation) -> Result<Child> {
+        self.backend.resume(self.process, Some(cancel))?;
+        Ok(self.backend.child(self.process, self.stdio))
+    }
+
+    /// Asynchronously resume the suspended program without injection.
+    pub async fn resume_async(self) -> Result<Child> {
+        self.backend.resume_async(self.process).await?;
+        Ok(self.backend.child(self.process, self.stdio))
     }
 }
 
+/// Which Frida mechanism performed an injection.
+///
+/// The backend remembers the path that last worked for each kind of target
+/// (user and architecture) and tries it first next time, re-probing the
+/// injector periodically.
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Hash)]
+pub enum InjectionPath {
+    /// Frida's injector (helper-based, or in-process with
+    /// `HOOK_INJECT_INJECTOR=inprocess`).
+    Injector,
+    /// The local device's injection API, used as a fallback when the injector
+    /// is not supported or denied permission.
+    Device,
+}
+
 /// Handle to an injected library in a running process.
 #[derive(Debug)]
 pub struct InjectedProcess {
     backend: backend::BackendHandle,
     id: u64,
     process: Process,
+    path: InjectionPath,
+    library: Library,
 }
 
 impl InjectedProcess {
-    pub(crate) fn new(backend: backend::BackendHandle, id: u64, process: Process) -> Self {
+    pub(crate) fn new(
+        backend: backend::BackendHandle,
+        id: u64,
+        process: Process,
+        path: InjectionPath,
+        library: Library,
+    ) -> Self {
         Self {
             backend,
             id,
             process,
+            path,
+            library,
         }
     }
 
@@ -174,52 +468,192 @@ impl InjectedProcess {
         self.process
     }
 
+    /// Return the mechanism that performed the injection.
+    pub fn injection_path(&self) -> InjectionPath {
+        self.path
+    }
+
+    /// Run the library's entrypoint again in the target with new `data`.
+    ///
+    /// Use this to push new configuration to an agent that keeps itself loaded
+    /// by setting `*stay_resident` in its entrypoint. The library is injected
+    /// again from the same path; the target's loader finds it already mapped
+    /// and hands back the resident image, so relocation and initializers do
+    /// not run again and the entrypoint sees the state left by earlier calls.
+    /// An agent that unloaded after its entrypoint is simply loaded afresh.
+    ///
+    /// The library must be file-backed. A blob would be written to a new
+    /// temporary file and loaded as a second copy beside the resident one,
+    /// so [`Library::stage`] blobs before the first injection; otherwise
+    /// this returns an invalid-input error.
+    ///
+    /// The returned handle tracks the new invocation; this one stays valid.
+    ///
+    /// # Examples
+    /// ```no_run
+    /// use hook_inject::{inject_process, Library, Process};
+    /// use std::ffi::CString;
+    ///
+    /// let process = unsafe { Process::from_pid_unchecked(1234) };
+    /// let library = Library::from_path("/path/to/libagent.so")?;
+    /// let injected = inject_process(process, library)?;
+    /// let update = injected.reinvoke(CString::new("level=debug").unwrap())?;
+    /// update.uninject()?;
+    /// # Ok::<(), hook_inject::Error>(())
+    /// ```
+    pub fn reinvoke(&self, data: impl Into<std::ffi::CString>) -> Result<InjectedProcess> {
+        if self.library.path().is_none() {
+            return Err(Error::invalid_input(
+                "reinvoke needs a file-backed library; stage blobs before injecting",
+            ));
+        }
+        let library = self.library.clone().with_data(data);
+        self.backend.inject_process(self.process, library, None)
+    }
+
+    /// Call `callback` once the library unloads or the target process exits.
+    ///
+    /// Frida reports this as the `uninjected` signal, so there is no need to
+    /// poll the target. The callback runs on Frida's event thread and should
+    /// return quickly; forward to a channel for anything heavier. If the
+    /// library is already gone, the callback runs immediately. Frida stops
+    /// reporting once the injection is uninjected, so a successful
+    /// [`uninject`](Self::uninject) runs any callbacks still waiting.
+    ///
+    /// # Examples
+    /// ```no_run
+    /// use hook_inject::{inject_process, Library, Process};
+    /// use std::sync::mpsc;
+    ///
+    /// let process = unsafe { Process::from_pid_unchecked(1234) };
+    /// let library = Library::from_path("/path/to/libagent.so")?;
+    /// let injected = inject_process(process, library)?;
+    ///
+    /// let (tx, rx) = mpsc::channel();
+    /// injected.on_uninjected(move || {
+    ///     let _ = tx.send(process);
+    /// });
+    /// let gone = rx.recv().unwrap();
+    /// # let _ = gone;
+    /// # Ok::<(), hook_inject::Error>(())
+    /// ```
+    pub fn on_uninjected(&self, callback: impl FnOnce() + Send + 'static) {
+        self.backend
+            .on_uninjected(self.id, self.path, Box::new(callback));
+    }
+
+    /// Inject the same library into every child this process creates.
+    ///
+    /// See [`ChildGating`]; gating lasts as long as the returned handle.
+    pub fn follow_children(&self) -> Result<ChildGating> {
+        self.follow_children_with(self.library.clone())
+    }
+
+    /// Inject `library` into every child this process creates.
+    pub fn follow_children_with(&self, library: impl Into<Library>) -> Result<ChildGating> {
+        ChildGating::enable(self.backend.clone(), self.process, library.into())
+    }
+
     /// Stop monitoring the injected library (Frida: `demonitor`).
     pub fn uninject(self) -> Result<()> {
-        self.backend.uninject(self.id)
+        self.backend.uninject(self.id, self.path, None)
+    }
+
+    /// [`uninject`](Self::uninject) that gives up once `cancel` is cancelled
+    /// or expires.
+    pub fn uninject_cancellable(self, cancel: &Cancellation) -> Result<()> {
+        self.backend.uninject(self.id, self.path, Some(cancel))
+    }
+
+    /// Asynchronously stop monitoring the injected library.
+    pub async fn uninject_async(self) -> Result<()> {
+        self.backend.uninject_async(self.id, self.path).await
+    }
+
+    /// Uninject in the background once the returned guard is dropped.
+    ///
+    /// See [`UninjectGuard`].
+    pub fn uninject_on_drop(self) -> UninjectGuard {
+        UninjectGuard::new(self)
     }
 
     pub(crate) fn into_program(self, child: Child) -> InjectedProgram {
-        InjectedProgram::new(self.backend, self.id, self.process, child)
+        InjectedProgram::new(self, child)
     }
 }
 
 /// Handle to an injected library in a launched process.
 #[derive(Debug)]
 pub struct InjectedProgram {
-    backend: backend::BackendHandle,
-    id: u64,
-    process: Process,
+    injected: InjectedProcess,
     child: Child,
 }
 
 impl InjectedProgram {
-    pub(crate) fn new(
-        backend: backend::BackendHandle,
-        id: u64,
-        process: Process,
-        child: Child,
-    ) -> Self {
-        Self {
-            backend,
-            id,
-            process,
-            child,
-        }
+    pub(crate) fn new(injected: InjectedProcess, child: Child) -> Self {
+        Self { injected, child }
     }
 
     /// Return the target process handle.
     pub fn process(&self) -> Process {
-        self.process
+        self.injected.process()
+    }
+
+    /// Return the mechanism that performed the injection.
+    pub fn injection_path(&self) -> InjectionPath {
+        self.injected.injection_path()
     }
 
-    /// Access the opaque spawned-process handle.
+    /// Access the spawned-process handle.
     pub fn child(&self) -> &Child {
         &self.child
     }
 
+    /// Mutably access the spawned-process handle, e.g. to take its stdio.
+    pub fn child_mut(&mut self) -> &mut Child {
+        &mut self.child
+    }
+
+    /// Run the library's entrypoint again with new `data`.
+    ///
+    /// See [`InjectedProcess::reinvoke`].
+    pub fn reinvoke(&self, data: impl Into<std::ffi::CString>) -> Result<InjectedProcess> {
+        self.injected.reinvoke(data)
+    }
+
+    /// Call `callback` once the library unloads, the program exits or it is
+    /// uninjected.
+    ///
+    /// See [`InjectedProcess::on_uninjected`].
+    pub fn on_uninjected(&self, callback: impl FnOnce() + Send + 'static) {
+        self.injected.on_uninjected(callback);
+    }
+
     /// Stop monitoring the injected library (Frida: `demonitor`).
     pub fn uninject(self) -> Result<()> {
-        self.backend.uninject(self.id)
+        self.injected.uninject()
+    }
+
+    /// [`uninject`](Self::uninject) that gives up once `cancel` is cancelled
+    /// or expires.
+    pub fn uninject_cancellable(self, cancel: &Cancellation) -> Result<()> {
+        self.injected.uninject_cancellable(cancel)
+    }
+
+    /// Inject the same library into every child the program creates.
+    ///
+    /// See [`ChildGating`]; children forked before this call are not covered.
+    pub fn follow_children(&self) -> Result<ChildGating> {
+        self.injected.follow_children()
+    }
+
+    /// Inject `library` into every child the program creates.
+    pub fn follow_children_with(&self, library: impl Into<Library>) -> Result<ChildGating> {
+        self.injected.follow_children_with(library)
+    }
+
+    /// Asynchronously stop monitoring the injected library.
+    pub async fn uninject_async(self) -> Result<()> {
+        self.injected.uninject_async().await
     }
 }
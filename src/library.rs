@@ -1,8 +1,11 @@
 use std::ffi::{CStr, CString};
 use std::path::{Path, PathBuf};
+use std::sync::Arc;
 
+use crate::mapping::Mapping;
+use crate::staging::StagedFile;
 use crate::{
-    Error, InjectedProcess, InjectedProgram, Process, Program, Result, inject_process,
+    Error, InjectedProcess, InjectedProgram, Process, Program, Result, SharedData, inject_process,
     inject_program,
 };
 
@@ -11,7 +14,34 @@ const DEFAULT_ENTRYPOINT: &str = "frida_agent_main";
 #[derive(Clone, Debug)]
 pub(crate) enum LibrarySource {
     Path(PathBuf),
-    Blob(Vec<u8>),
+    Blob(Payload),
+}
+
+/// In-memory library bytes, shared so clones and concurrent injections reuse
+/// one buffer.
+#[derive(Clone)]
+pub(crate) enum Payload {
+    Shared(Arc<[u8]>),
+    Mapped(Arc<Mapping>),
+}
+
+impl Payload {
+    pub(crate) fn as_slice(&self) -> &[u8] {
+        match self {
+            Payload::Shared(bytes) => bytes,
+            Payload::Mapped(mapping) => mapping.as_slice(),
+        }
+    }
+}
+
+impl std::fmt::Debug for Payload {
+    fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
+        let kind = match self {
+            Payload::Shared(_) => "Shared",
+            Payload::Mapped(_) => "Mapped",
+        };
+        write!(f, "{kind}({} bytes)", self.as_slice().len())
+    }
 }
 
 /// Reference to an injectable library or in-memory payload.
@@ -20,6 +50,10 @@ pub struct Library {
     source: LibrarySource,
     entrypoint: CString,
     data: CString,
+    // Keeps a staged blob's file alive while this library is.
+    _staged: Option<Arc<StagedFile>>,
+    // Keeps the segment named by `data` alive while this library is.
+    _shared: Option<SharedData>,
 }
 
 impl Library {
@@ -43,25 +77,53 @@ impl Library {
 
     /// Create from raw in-memory bytes.
     ///
+    /// The payload is reference counted: cloning the library or injecting it
+    /// into many processes shares one buffer instead of copying it. Pass an
+    /// `Arc<[u8]>` to share a buffer you already hold.
+    ///
     /// # Examples
     /// ```no_run
     /// # use hook_inject::Library;
     /// let lib = Library::from_bytes(vec![1, 2, 3])?;
     /// # Ok::<(), hook_inject::Error>(())
     /// ```
-    pub fn from_bytes<B: Into<Vec<u8>>>(bytes: B) -> Result<Library> {
+    pub fn from_bytes<B: Into<Arc<[u8]>>>(bytes: B) -> Result<Library> {
         let bytes = bytes.into();
         if bytes.is_empty() {
             return Err(Error::invalid_input("library blob is empty"));
         }
 
-        library_with_defaults(LibrarySource::Blob(bytes))
+        library_with_defaults(LibrarySource::Blob(Payload::Shared(bytes)))
+    }
+
+    /// Create from a read-only memory mapping of a library file.
+    ///
+    /// The mapping is handed to the injector as an in-memory blob, so large
+    /// agents are never read into a heap buffer; every clone and injection
+    /// shares the same page-cache-backed pages.
+    ///
+    /// # Safety
+    /// The file must not be truncated or modified while this library (or any
+    /// clone of it) is alive.
+    ///
+    /// # Examples
+    /// ```no_run
+    /// # use hook_inject::Library;
+    /// let lib = unsafe { Library::from_mmap("/path/to/libagent.so")? };
+    /// # Ok::<(), hook_inject::Error>(())
+    /// ```
+    pub unsafe fn from_mmap<P: AsRef<Path>>(path: P) -> Result<Library> {
+        let mapping = unsafe { Mapping::open(path.as_ref())? };
+        library_with_defaults(LibrarySource::Blob(Payload::Mapped(Arc::new(mapping))))
     }
 
     /// Resolve a cdylib built from a Rust crate.
     ///
     /// The path may be a directory containing Cargo.toml or a direct path to Cargo.toml.
     /// If the library is not found, this will run `cargo build` once and retry.
+    /// The result is cached under the crate's target directory and reused
+    /// until the manifest, lockfile, build script or any file under `src/`
+    /// changes, so repeated calls do not parse TOML or invoke cargo.
     ///
     /// You can optionally specify metadata in `Cargo.toml`:
     /// ```text
@@ -79,15 +141,9 @@ impl Library {
     pub fn from_crate<P: AsRef<Path>>(path: P) -> Result<Library> {
         let crate_path = path.as_ref();
 
-        let dylib = if let Some(result) = hook_inject_build::read_cdylib_file(crate_path) {
-            result.map_err(|err| {
-                Error::invalid_input(format_args!("Failed to read library: {}", err))
-            })?
-        } else {
-            hook_inject_build::build_cdylib(crate_path).map_err(|err| {
-                Error::invalid_input(format_args!("Failed to build library: {err}"))
-            })?
-        };
+        let dylib = hook_inject_build::resolve_cdylib_cached(crate_path).map_err(|err| {
+            Error::invalid_input(format_args!("Failed to resolve library: {err}"))
+        })?;
 
         Ok(Library {
             source: LibrarySource::Path(dylib.path),
@@ -96,9 +152,55 @@ impl Library {
                 "entrypoint",
             )?,
             data: cstring_from_str(dylib.data.as_deref().unwrap_or_default(), "data")?,
+            _staged: None,
+            _shared: None,
+        })
+    }
+
+    /// Stage an in-memory library once so later injections load it by path.
+    ///
+    /// Every blob injection otherwise uploads and stages the whole payload
+    /// again for each target. Staging writes it to a content-addressed
+    /// temporary file once; the returned library injects like
+    /// [`from_path`](Self::from_path) and keeps the file alive until it and
+    /// all its clones are dropped. Libraries that already have a path are
+    /// returned unchanged.
+    ///
+    /// # Examples
+    /// ```no_run
+    /// use hook_inject::{inject_processes, Library, Process};
+    ///
+    /// let processes = [unsafe { Process::from_pid_unchecked(1234) }];
+    /// let staged = Library::from_bytes(std::fs::read("libagent.so")?)?.stage()?;
+    /// let _ = inject_processes(&processes, staged)?;
+    /// # Ok::<(), hook_inject::Error>(())
+    /// ```
+    pub fn stage(&self) -> Result<Library> {
+        let payload = match &self.source {
+            LibrarySource::Path(_) => return Ok(self.clone()),
+            LibrarySource::Blob(payload) => payload,
+        };
+
+        let staged = StagedFile::stage(payload.as_slice())?;
+        Ok(Library {
+            source: LibrarySource::Path(staged.path().to_path_buf()),
+            entrypoint: self.entrypoint.clone(),
+            data: self.data.clone(),
+            _staged: Some(staged),
+            _shared: self._shared.clone(),
         })
     }
 
+    /// Return the file the library is loaded from, if it is file-backed.
+    ///
+    /// This includes staged blobs; in-memory payloads have no path.
+    pub fn path(&self) -> Option<&Path> {
+        match &self.source {
+            LibrarySource::Path(path) => Some(path),
+            LibrarySource::Blob(_) => None,
+        }
+    }
+
     /// Return the entrypoint symbol name.
     pub fn entrypoint(&self) -> &CStr {
         &self.entrypoint
@@ -126,6 +228,9 @@ impl Library {
 
     /// Override data passed to the entrypoint.
     ///
+    /// The string is copied into each target; for binary or large payloads
+    /// use [`with_shared_data`](Self::with_shared_data).
+    ///
     /// # Examples
     /// ```no_run
     /// # use hook_inject::Library;
@@ -136,9 +241,55 @@ impl Library {
     /// ```
     pub fn with_data(mut self, data: impl Into<CString>) -> Self {
         self.data = data.into();
+        self._shared = None;
+        self
+    }
+
+    /// Pass a [`SharedData`] segment to the entrypoint by reference.
+    ///
+    /// The entrypoint's data becomes the segment's
+    /// [`descriptor`](SharedData::descriptor), and the segment stays alive
+    /// as long as this library or any of its clones.
+    ///
+    /// # Examples
+    /// ```no_run
+    /// # use hook_inject::{Library, SharedData};
+    /// let config = SharedData::new(std::fs::read("/etc/agent/symbols.bin")?)?;
+    /// let lib = Library::from_path("/path/to/libagent.so")?.with_shared_data(&config);
+    /// # Ok::<(), hook_inject::Error>(())
+    /// ```
+    pub fn with_shared_data(mut self, data: &SharedData) -> Self {
+        self.data = data.descriptor().to_owned();
+        self._shared = Some(data.clone());
         self
     }
 
+    /// Check, without touching the target, that the library can be injected
+    /// into `process`.
+    ///
+    /// Parses the library's ELF, Mach-O or PE headers and confirms that its
+    /// architecture matches the target's executable and that it exports
+    /// [`entrypoint`](Self::entrypoint), so a bad combination is rejected
+    /// before paying for an attach. Parsed files are cached per device,
+    /// inode, size and mtime: a sweep over many targets parses the library
+    /// and each distinct executable once. In-memory blobs are parsed on every
+    /// call; [`stage`](Self::stage) them first to get the cache. Checks that
+    /// cannot be made, e.g. when the target's executable is unreadable, are
+    /// skipped rather than reported.
+    ///
+    /// # Examples
+    /// ```no_run
+    /// # use hook_inject::{Library, Process};
+    /// let lib = Library::from_path("/path/to/libagent.so")?;
+    /// let process = Process::from_pid(1234)?;
+    /// lib.preflight(process)?;
+    /// let _ = lib.inject_into_process(process)?;
+    /// # Ok::<(), hook_inject::Error>(())
+    /// ```
+    pub fn preflight(&self, process: Process) -> Result<()> {
+        crate::preflight::check(self, process)
+    }
+
     /// Convenience helper to inject into a program at launch.
     ///
     /// # Examples
@@ -183,5 +334,7 @@ fn library_with_defaults(source: LibrarySource) -> Result<Library> {
         source,
         entrypoint: cstring_from_str(DEFAULT_ENTRYPOINT, "entrypoint")?,
         data: cstring_from_str("", "data")?,
+        _staged: None,
+        _shared: None,
     })
 }
@@ -0,0 +1,39 @@
+/// Backend objects currently alive in this process.
+///
+/// Returned by [`live_objects`](crate::live_objects). A long-running
+/// injector should see these return to the same values whenever it is idle;
+/// a count that keeps growing across inject/uninject cycles is a leak. `GBytes`
+/// and GObjects owned by Frida itself are not visible here, only what the
+/// crate hands to Frida and its shim.
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Default)]
+pub struct LiveObjects {
+    contexts: u64,
+    async_ops: u64,
+    payloads: u64,
+}
+
+impl LiveObjects {
+    pub(crate) fn new(contexts: u64, async_ops: u64, payloads: u64) -> Self {
+        Self {
+            contexts,
+            async_ops,
+            payloads,
+        }
+    }
+
+    /// Frida contexts (one per backend, including pooled ones).
+    pub fn contexts(&self) -> u64 {
+        self.contexts
+    }
+
+    /// Asynchronous operations submitted to Frida and not yet completed.
+    pub fn async_ops(&self) -> u64 {
+        self.async_ops
+    }
+
+    /// In-memory library payloads lent to Frida as `GBytes` and not yet
+    /// released by it.
+    pub fn payloads(&self) -> u64 {
+        self.payloads
+    }
+}
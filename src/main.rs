@@ -1,15 +1,382 @@
-use hook_inject::{Library, Process};
+//! `hook-inject` command-line tool.
+//!
+//! Runs a single request in-process, or keeps one warm backend open as a
+//! daemon so each request only pays for the injection itself.
+//!
+//! Requests are one line each, fields separated by tabs:
+//!
+//! ```text
+//! <id> ping
+//! <id> inject <pid> <library> <entrypoint> <data>
+//! <id> launch <library> <entrypoint> <data> <program> [<arg>...]
+//! <id> spawn <program> [<arg>...]
+//! <id> resume <pid>
+//! <id> uninject <handle>
+//! ```
+//!
+//! An empty entrypoint or data field keeps the library default. Every request
+//! is answered with `<id> ok [<field>...]` or `<id> err <message>`, in request
+//! order, so clients can pipeline many requests on one connection.
+//!
+//! `spawn`, `resume` and `uninject` act on state kept between requests, so
+//! they need a daemon. The daemon forgets handles once their target exits.
+
+use std::collections::HashMap;
+use std::ffi::CString;
+use std::io::{self, BufRead, BufReader, BufWriter, Write};
+use std::sync::Mutex;
+use std::sync::atomic::{AtomicU64, Ordering};
+
+use hook_inject::{
+    InjectedProcess, InjectedProgram, Library, Process, ProcessHandle, Program, SuspendedProgram,
+};
+
+const USAGE: &str = "\
+usage:
+  hook-inject daemon <socket>                 serve requests on a Unix socket
+  hook-inject --socket <socket> <verb> [...]  send one request to a daemon
+  hook-inject <verb> [...]                    run one request in-process
+
+verbs:
+  ping
+  inject <pid> <library> [<entrypoint> [<data>]]
+  launch <library> <entrypoint> <data> <program> [<arg>...]
+  spawn <program> [<arg>...]
+  resume <pid>
+  uninject <handle>
+
+spawn, resume and uninject need a daemon.";
+
+/// Verbs that only make sense against state a daemon keeps between requests.
+const DAEMON_ONLY: [&str; 3] = ["spawn", "resume", "uninject"];
 
 fn main() {
-    let library =
-        Library::from_crate("/Users/tundeoladipupo/RustProjects/hook-inject/fixtures/agent")
-            .unwrap()
-            .with_entrypoint(c"hook_inject_entry")
-            .with_data(c"/tmp/new_file");
-    // library
-    //     .inject_program("/Users/tundeoladipupo/RustProjects/hook-inject/zz_lab/misc/mango")
-    //     .unwrap();
-    library
-        .inject_into_process(unsafe { Process::from_pid_unchecked(3626) })
-        .unwrap();
+    let args: Vec<String> = std::env::args().skip(1).collect();
+    let code = match args.first().map(String::as_str) {
+        Some("daemon") if args.len() == 2 => match daemon::serve(&args[1]) {
+            Ok(()) => 0,
+            Err(err) => {
+                eprintln!("hook-inject: {err}");
+                1
+            }
+        },
+        Some("--socket") if args.len() >= 3 => match daemon::send(&args[1], &args[2..]) {
+            Ok(response) => print_response(&response),
+            Err(err) => {
+                eprintln!("hook-inject: {err}");
+                1
+            }
+        },
+        Some(verb) if DAEMON_ONLY.contains(&verb) => {
+            eprintln!("hook-inject: {verb} needs a daemon; use --socket <socket>");
+            2
+        }
+        Some(verb) if !verb.starts_with('-') && verb != "daemon" => {
+            let state = State::default();
+            let fields: Vec<&str> = args[1..].iter().map(String::as_str).collect();
+            print_response(&state.handle(verb, &fields))
+        }
+        _ => {
+            eprintln!("{USAGE}");
+            2
+        }
+    };
+    std::process::exit(code);
+}
+
+fn print_response(response: &Response) -> i32 {
+    match response {
+        Ok(fields) => {
+            println!("{}", fields.join("\t"));
+            0
+        }
+        Err(message) => {
+            eprintln!("hook-inject: {message}");
+            1
+        }
+    }
+}
+
+type Response = Result<Vec<String>, String>;
+
+/// Handles that outlive the request that created them.
+#[derive(Default)]
+struct State {
+    next_handle: AtomicU64,
+    injections: Mutex<HashMap<u64, Kept<Injection>>>,
+    suspended: Mutex<HashMap<i32, Kept<SuspendedProgram>>>,
+}
+
+enum Injection {
+    Process(InjectedProcess),
+    Program(InjectedProgram),
+}
+
+impl Injection {
+    fn process(&self) -> Process {
+        match self {
+            Injection::Process(injected) => injected.process(),
+            Injection::Program(injected) => injected.process(),
+        }
+    }
+}
+
+/// A kept handle and a watch on its target, so it can be dropped once the
+/// target exits even if nobody asks for it again.
+struct Kept<T> {
+    value: T,
+    target: Option<ProcessHandle>,
+}
+
+impl<T> Kept<T> {
+    fn new(value: T, process: Process) -> Self {
+        Self {
+            value,
+            target: process.open().ok(),
+        }
+    }
+
+    fn exited(&self) -> bool {
+        self.target
+            .as_ref()
+            .is_some_and(|target| !target.is_alive().unwrap_or(true))
+    }
+}
+
+impl State {
+    fn handle(&self, verb: &str, args: &[&str]) -> Response {
+        match (verb, args) {
+            ("ping", []) => Ok(Vec::new()),
+            ("inject", [pid, library, rest @ ..]) if rest.len() <= 2 => {
+                let entrypoint = rest.first().copied().unwrap_or("");
+                let data = rest.get(1).copied().unwrap_or("");
+                let process = parse_pid(pid)?;
+                let library = load_library(library, entrypoint, data)?;
+                let injected = hook_inject::inject_process(process, library).map_err(message)?;
+                Ok(vec![self.keep(Injection::Process(injected))])
+            }
+            ("launch", [library, entrypoint, data, program @ ..]) if !program.is_empty() => {
+                let library = load_library(library, entrypoint, data)?;
+                let injected =
+                    hook_inject::inject_program(program_from(program), library).map_err(message)?;
+                let pid = injected.process().pid().to_string();
+                Ok(vec![pid, self.keep(Injection::Program(injected))])
+            }
+            ("spawn", program) if !program.is_empty() => {
+                let suspended = hook_inject::spawn(program_from(program)).map_err(message)?;
+                let process = suspended.process();
+                let mut kept = lock(&self.suspended);
+                kept.retain(|_, suspended| !suspended.exited());
+                kept.insert(process.pid(), Kept::new(suspended, process));
+                Ok(vec![process.pid().to_string()])
+            }
+            ("resume", [pid]) => {
+                let process = parse_pid(pid)?;
+                let suspended = lock(&self.suspended).remove(&process.pid());
+                match suspended {
+                    Some(suspended) => suspended
+                        .value
+                        .resume()
+                        .map(|_| Vec::new())
+                        .map_err(message),
+                    None => Err(format!("no suspended program with pid {}", process.pid())),
+                }
+            }
+            ("uninject", [handle]) => {
+                let id: u64 = handle
+                    .parse()
+                    .map_err(|_| format!("invalid handle: {handle}"))?;
+                let injection = lock(&self.injections).remove(&id);
+                match injection.map(|kept| kept.value) {
+                    Some(Injection::Process(injected)) => injected.uninject(),
+                    Some(Injection::Program(injected)) => injected.uninject(),
+                    None => return Err(format!("unknown handle: {id}")),
+                }
+                .map(|()| Vec::new())
+                .map_err(message)
+            }
+            _ => Err(format!("malformed request: {verb}")),
+        }
+    }
+
+    fn keep(&self, injection: Injection) -> String {
+        let id = self.next_handle.fetch_add(1, Ordering::Relaxed) + 1;
+        let process = injection.process();
+        let mut kept = lock(&self.injections);
+        kept.retain(|_, injection| !injection.exited());
+        kept.insert(id, Kept::new(injection, process));
+        id.to_string()
+    }
+}
+
+fn parse_pid(pid: &str) -> Result<Process, String> {
+    let pid: i32 = pid.parse().map_err(|_| format!("invalid pid: {pid}"))?;
+    Process::from_pid(pid).map_err(message)
+}
+
+fn load_library(path: &str, entrypoint: &str, data: &str) -> Result<Library, String> {
+    let mut library = Library::from_path(path).map_err(message)?;
+    if !entrypoint.is_empty() {
+        library = library.with_entrypoint(cstring(entrypoint)?);
+    }
+    if !data.is_empty() {
+        library = library.with_data(cstring(data)?);
+    }
+    Ok(library)
+}
+
+fn program_from(fields: &[&str]) -> Program {
+    let mut program = Program::new(fields[0]);
+    program.args(&fields[1..]);
+    program
+}
+
+fn cstring(value: &str) -> Result<CString, String> {
+    CString::new(value).map_err(|_| "field contains NUL".to_string())
+}
+
+fn message(err: hook_inject::Error) -> String {
+    err.to_string()
+}
+
+fn lock<T>(mutex: &Mutex<T>) -> std::sync::MutexGuard<'_, T> {
+    mutex.lock().unwrap_or_else(|err| err.into_inner())
+}
+
+/// Serve one connection: answer each request line in order.
+#[cfg_attr(not(unix), allow(dead_code))]
+fn serve_connection(state: &State, reader: impl io::Read, writer: impl Write) -> io::Result<()> {
+    let mut reader = BufReader::new(reader);
+    let mut writer = BufWriter::new(writer);
+    let mut line = String::new();
+    loop {
+        line.clear();
+        if reader.read_line(&mut line)? == 0 {
+            return writer.flush();
+        }
+
+        let mut fields = line.trim_end_matches(['\r', '\n']).split('\t');
+        let id = fields.next().unwrap_or_default();
+        let response = match fields.next() {
+            Some(verb) => state.handle(verb, &fields.collect::<Vec<_>>()),
+            None => Err("missing verb".to_string()),
+        };
+        match response {
+            Ok(fields) if fields.is_empty() => writeln!(writer, "{id}\tok")?,
+            Ok(fields) => writeln!(writer, "{id}\tok\t{}", fields.join("\t"))?,
+            Err(message) => writeln!(writer, "{id}\terr\t{}", message.replace(['\t', '\n'], " "))?,
+        }
+
+        // Batch replies while more pipelined requests are already buffered.
+        if reader.buffer().is_empty() {
+            writer.flush()?;
+        }
+    }
+}
+
+#[cfg(unix)]
+mod daemon {
+    use std::io::{self, BufRead, BufReader, Write};
+    use std::os::unix::fs::FileTypeExt;
+    use std::os::unix::net::{UnixListener, UnixStream};
+    use std::path::Path;
+
+    use super::{Response, State, serve_connection};
+
+    pub(super) fn serve(socket: &str) -> io::Result<()> {
+        let path = Path::new(socket);
+        // Replace only a socket left behind by a daemon that is no longer
+        // running; anything else at the path is not ours to remove.
+        match std::fs::symlink_metadata(path) {
+            Ok(meta) if !meta.file_type().is_socket() => {
+                return Err(io::Error::new(
+                    io::ErrorKind::AlreadyExists,
+                    format!("{} exists and is not a socket", path.display()),
+                ));
+            }
+            Ok(_) if UnixStream::connect(path).is_ok() => {
+                return Err(io::Error::new(
+                    io::ErrorKind::AddrInUse,
+                    format!("a daemon is already listening on {}", path.display()),
+                ));
+            }
+            Ok(_) => std::fs::remove_file(path)?,
+            Err(err) if err.kind() == io::ErrorKind::NotFound => {}
+            Err(err) => return Err(err),
+        }
+
+        // Create the socket owner-only rather than narrowing it after bind.
+        // The umask is process-wide, but no other thread is running yet.
+        let previous = unsafe { libc::umask(0o177) };
+        let listener = UnixListener::bind(path);
+        unsafe { libc::umask(previous) };
+        let listener = listener?;
+
+        match hook_inject::warm_up() {
+            Ok(report) => eprintln!("hook-inject: backend ready in {:?}", report.total()),
+            Err(err) => {
+                let _ = std::fs::remove_file(path);
+                return Err(io::Error::other(err));
+            }
+        }
+
+        let state = State::default();
+        std::thread::scope(|scope| {
+            for stream in listener.incoming() {
+                let stream = match stream {
+                    Ok(stream) => stream,
+                    Err(err) => {
+                        eprintln!("hook-inject: accept failed: {err}");
+                        continue;
+                    }
+                };
+                let state = &state;
+                scope.spawn(move || {
+                    let result = stream
+                        .try_clone()
+                        .and_then(|reader| serve_connection(state, reader, stream));
+                    if let Err(err) = result {
+                        eprintln!("hook-inject: connection failed: {err}");
+                    }
+                });
+            }
+        });
+        Ok(())
+    }
+
+    pub(super) fn send(socket: &str, request: &[String]) -> io::Result<Response> {
+        let mut stream = UnixStream::connect(socket)?;
+        writeln!(stream, "1\t{}", request.join("\t"))?;
+        stream.shutdown(std::net::Shutdown::Write)?;
+
+        let mut line = String::new();
+        BufReader::new(stream).read_line(&mut line)?;
+        let mut fields = line.trim_end_matches('\n').split('\t').skip(1);
+        Ok(match fields.next() {
+            Some("ok") => Ok(fields.map(str::to_string).collect()),
+            Some("err") => Err(fields.collect::<Vec<_>>().join("\t")),
+            _ => Err("daemon closed the connection".to_string()),
+        })
+    }
+}
+
+#[cfg(not(unix))]
+mod daemon {
+    use std::io;
+
+    use super::Response;
+
+    pub(super) fn serve(_socket: &str) -> io::Result<()> {
+        Err(io::Error::new(
+            io::ErrorKind::Unsupported,
+            "daemon mode requires Unix domain sockets",
+        ))
+    }
+
+    pub(super) fn send(_socket: &str, _request: &[String]) -> io::Result<Response> {
+        Err(io::Error::new(
+            io::ErrorKind::Unsupported,
+            "daemon mode requires Unix domain sockets",
+        ))
+    }
 }
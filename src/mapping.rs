@@ -0,0 +1,119 @@
+use std::fs::File;
+use std::path::Path;
+
+use crate::{Error, Result};
+
+/// Read-only, private memory mapping of a whole file.
+pub(crate) struct Mapping {
+    ptr: *const u8,
+    len: usize,
+}
+
+// The mapping is immutable for its whole lifetime and is only ever read.
+unsafe impl Send for Mapping {}
+unsafe impl Sync for Mapping {}
+
+impl Mapping {
+    /// Map `path` read-only.
+    ///
+    /// # Safety
+    /// The file must not be truncated or modified while the mapping is alive.
+    pub(crate) unsafe fn open(path: &Path) -> Result<Mapping> {
+        let file = File::open(path).map_err(Error::from)?;
+        let meta = file.metadata().map_err(Error::from)?;
+        if !meta.is_file() {
+            return Err(Error::invalid_input("library path must be a file"));
+        }
+
+        let len = usize::try_from(meta.len())
+            .map_err(|_| Error::invalid_input("library file is too large to map"))?;
+        if len == 0 {
+            return Err(Error::invalid_input("library file is empty"));
+        }
+
+        let ptr = map_file(&file, len)?;
+        Ok(Mapping { ptr, len })
+    }
+
+    pub(crate) fn as_slice(&self) -> &[u8] {
+        unsafe { std::slice::from_raw_parts(self.ptr, self.len) }
+    }
+}
+
+impl Drop for Mapping {
+    fn drop(&mut self) {
+        unmap(self.ptr, self.len);
+    }
+}
+
+#[cfg(unix)]
+fn map_file(file: &File, len: usize) -> Result<*const u8> {
+    use std::os::unix::io::AsRawFd;
+
+    let ptr = unsafe {
+        libc::mmap(
+            std::ptr::null_mut(),
+            len,
+            libc::PROT_READ,
+            libc::MAP_PRIVATE,
+            file.as_raw_fd(),
+            0,
+        )
+    };
+    if ptr == libc::MAP_FAILED {
+        return Err(Error::from(std::io::Error::last_os_error()));
+    }
+
+    Ok(ptr as *const u8)
+}
+
+#[cfg(unix)]
+fn unmap(ptr: *const u8, len: usize) {
+    unsafe {
+        libc::munmap(ptr as *mut libc::c_void, len);
+    }
+}
+
+#[cfg(windows)]
+fn map_file(file: &File, _len: usize) -> Result<*const u8> {
+    use std::os::windows::io::AsRawHandle;
+    use windows_sys::Win32::Foundation::CloseHandle;
+    use windows_sys::Win32::System::Memory::{
+        CreateFileMappingW, FILE_MAP_READ, MapViewOfFile, PAGE_READONLY,
+    };
+
+    let mapping = unsafe {
+        CreateFileMappingW(
+            file.as_raw_handle() as _,
+            std::ptr::null(),
+            PAGE_READONLY,
+            0,
+            0,
+            std::ptr::null(),
+        )
+    };
+    if mapping.is_null() {
+        return Err(Error::from(std::io::Error::last_os_error()));
+    }
+
+    // The view keeps the section alive, so the mapping handle can go now.
+    let view = unsafe { MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) };
+    let err = std::io::Error::last_os_error();
+    unsafe { CloseHandle(mapping) };
+    if view.Value.is_null() {
+        return Err(Error::from(err));
+    }
+
+    Ok(view.Value as *const u8)
+}
+
+#[cfg(windows)]
+fn unmap(ptr: *const u8, _len: usize) {
+    use windows_sys::Win32::System::Memory::{MEMORY_MAPPED_VIEW_ADDRESS, UnmapViewOfFile};
+
+    unsafe {
+        UnmapViewOfFile(MEMORY_MAPPED_VIEW_ADDRESS {
+            Value: ptr as *mut _,
+        });
+    }
+}
@@ -0,0 +1,147 @@
+use std::sync::atomic::{AtomicBool, Ordering};
+use std::sync::{Arc, RwLock};
+use std::time::Duration;
+
+use crate::{InjectionPath, Process};
+
+type MetricsHook = Arc<dyn Fn(&InjectionMetrics) + Send + Sync>;
+
+static ENABLED: AtomicBool = AtomicBool::new(false);
+static HOOK: RwLock<Option<MetricsHook>> = RwLock::new(None);
+
+/// Which operation an [`InjectionMetrics`] record describes.
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Hash)]
+pub enum InjectionOp {
+    /// Injection into an already-running process.
+    Process,
+    /// Spawn, inject and resume of a new program.
+    Launch,
+}
+
+/// Phase timings for one synchronous injection or launch.
+///
+/// Delivered to the hook installed with [`set_metrics_hook`]. Phases an
+/// operation does not have are zero.
+#[derive(Debug, Clone, PartialEq, Eq)]
+pub struct InjectionMetrics {
+    pub(crate) op: InjectionOp,
+    pub(crate) process: Option<Process>,
+    pub(crate) spawn: Duration,
+    pub(crate) inject: Duration,
+    pub(crate) fallback: Duration,
+    pub(crate) resume: Duration,
+    pub(crate) total: Duration,
+    pub(crate) device_lookup: Duration,
+    pub(crate) payload_len: usize,
+    pub(crate) path: InjectionPath,
+    pub(crate) fell_back: bool,
+    pub(crate) succeeded: bool,
+}
+
+impl InjectionMetrics {
+    /// The operation that was measured.
+    pub fn op(&self) -> InjectionOp {
+        self.op
+    }
+
+    /// Target process, when known (a failed spawn has none).
+    pub fn process(&self) -> Option<Process> {
+        self.process
+    }
+
+    /// Time spent spawning the program suspended.
+    pub fn spawn(&self) -> Duration {
+        self.spawn
+    }
+
+    /// Time spent in the first injection attempt.
+    pub fn inject(&self) -> Duration {
+        self.inject
+    }
+
+    /// Time spent retrying on the other path after the first was refused.
+    pub fn fallback(&self) -> Duration {
+        self.fallback
+    }
+
+    /// Time spent resuming the program.
+    pub fn resume(&self) -> Duration {
+        self.resume
+    }
+
+    /// Wall-clock time for the whole operation inside the backend.
+    pub fn total(&self) -> Duration {
+        self.total
+    }
+
+    /// Time spent waiting for the device lookup, on first use of the device
+    /// or after its connection was lost; zero when it was already connected.
+    ///
+    /// Part of whichever phase needed the device, and of
+    /// [`total`](Self::total).
+    pub fn device_lookup(&self) -> Duration {
+        self.device_lookup
+    }
+
+    /// Blob size in bytes, or 0 for libraries injected from a path.
+    pub fn payload_len(&self) -> usize {
+        self.payload_len
+    }
+
+    /// Path of the last injection attempt.
+    pub fn injection_path(&self) -> InjectionPath {
+        self.path
+    }
+
+    /// Whether the first path was refused and the other one was tried.
+    pub fn fell_back(&self) -> bool {
+        self.fell_back
+    }
+
+    /// Whether the operation succeeded.
+    pub fn succeeded(&self) -> bool {
+        self.succeeded
+    }
+}
+
+/// Install a hook that receives metrics for every synchronous injection and
+/// launch, replacing any previous hook.
+///
+/// The hook runs on the injecting thread after the backend returns. Forward
+/// records to `tracing`, a metrics registry or a channel from here. Without a
+/// hook, the backend does not read the clock at all.
+///
+/// # Examples
+/// ```no_run
+/// hook_inject::set_metrics_hook(|metrics| {
+///     eprintln!(
+///         "{:?} took {:?} (fallback: {})",
+///         metrics.op(),
+///         metrics.total(),
+///         metrics.fell_back()
+///     );
+/// });
+/// ```
+pub fn set_metrics_hook(hook: impl Fn(&InjectionMetrics) + Send + Sync + 'static) {
+    let mut slot = HOOK.write().unwrap_or_else(|err| err.into_inner());
+    *slot = Some(Arc::new(hook));
+    ENABLED.store(true, Ordering::Release);
+}
+
+/// Remove the hook installed with [`set_metrics_hook`].
+pub fn clear_metrics_hook() {
+    let mut slot = HOOK.write().unwrap_or_else(|err| err.into_inner());
+    ENABLED.store(false, Ordering::Release);
+    *slot = None;
+}
+
+pub(crate) fn enabled() -> bool {
+    ENABLED.load(Ordering::Acquire)
+}
+
+pub(crate) fn emit(metrics: InjectionMetrics) {
+    let hook = HOOK.read().unwrap_or_else(|err| err.into_inner()).clone();
+    if let Some(hook) = hook {
+        hook(&metrics);
+    }
+}
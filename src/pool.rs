@@ -0,0 +1,276 @@
+use std::sync::atomic::{AtomicUsize, Ordering};
+
+use crate::backend::{self, BackendHandle};
+use crate::{
+    Error, InjectedProcess, InjectedProgram, Library, PreparedProgram, Process, Program, Result,
+    SuspendedProgram, WarmUpReport,
+};
+
+/// How a [`BackendPool`] picks the context for an operation.
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Default)]
+pub enum PoolStrategy {
+    /// Use the context with the fewest operations in flight.
+    #[default]
+    LeastLoaded,
+    /// Use the context selected by the target pid, so repeated operations on
+    /// the same process land on the same context.
+    PidHash,
+}
+
+/// A set of independent injection backends.
+///
+/// Each member owns its own Frida context, injector and helper process, so
+/// injections issued from many threads are not serialized behind a single
+/// helper. Handles returned by the pool remember the member that created them;
+/// `uninject` always goes back to that member.
+///
+/// # Examples
+/// ```no_run
+/// use hook_inject::{BackendPool, Library, Process, PoolStrategy};
+///
+/// let pool = BackendPool::new(4)?.strategy(PoolStrategy::PidHash);
+/// let process = unsafe { Process::from_pid_unchecked(1234) };
+/// let library = Library::from_path("/path/to/libagent.so")?;
+/// let injected = pool.inject_process(process, library)?;
+/// injected.uninject()?;
+/// # Ok::<(), hook_inject::Error>(())
+/// ```
+#[derive(Debug)]
+pub struct BackendPool {
+    members: Vec<Member>,
+    strategy: PoolStrategy,
+}
+
+#[derive(Debug)]
+struct Member {
+    backend: BackendHandle,
+    in_flight: AtomicUsize,
+}
+
+/// Counts `weight` operations against a member while it is alive.
+struct InFlight<'a> {
+    backend: &'a BackendHandle,
+    count: &'a AtomicUsize,
+    weight: usize,
+}
+
+impl Drop for InFlight<'_> {
+    fn drop(&mut self) {
+        self.count.fetch_sub(self.weight, Ordering::Relaxed);
+    }
+}
+
+impl BackendPool {
+    /// Create a pool of `size` independent backends.
+    pub fn new(size: usize) -> Result<BackendPool> {
+        if size == 0 {
+            return Err(Error::invalid_input("backend pool size must be at least 1"));
+        }
+
+        let members = (0..size)
+            .map(|_| {
+                backend::new_backend().map(|backend| Member {
+                    backend,
+                    in_flight: AtomicUsize::new(0),
+                })
+            })
+            .collect::<Result<Vec<_>>>()?;
+        Ok(BackendPool {
+            members,
+            strategy: PoolStrategy::default(),
+        })
+    }
+
+    /// Set how operations are assigned to members.
+    pub fn strategy(mut self, strategy: PoolStrategy) -> Self {
+        self.strategy = strategy;
+        self
+    }
+
+    /// Number of backends in the pool.
+    pub fn size(&self) -> usize {
+        self.members.len()
+    }
+
+    /// Warm up every member; see [`warm_up`](crate::warm_up).
+    pub fn warm_up(&self) -> Result<Vec<WarmUpReport>> {
+        self.members
+            .iter()
+            .map(|member| member.backend.warm_up())
+            .collect()
+    }
+
+    /// Inject a library into a program launched under injector control.
+    ///
+    /// See [`inject_program`](crate::inject_program).
+    pub fn inject_program(
+        &self,
+        spec: impl Into<Program>,
+        library: impl Into<Library>,
+    ) -> Result<InjectedProgram> {
+        let op = self.acquire(None);
+        op.backend.inject_program(spec.into(), library.into(), None)
+    }
+
+    /// Inject a library into an already-running process.
+    ///
+    /// See [`inject_process`](crate::inject_process).
+    pub fn inject_process(
+        &self,
+        process: Process,
+        library: impl Into<Library>,
+    ) -> Result<InjectedProcess> {
+        let op = self.acquire(Some(process));
+        op.backend.inject_process(process, library.into(), None)
+    }
+
+    /// Inject the same library into many running processes at once.
+    ///
+    /// The targets are split across all members, which inject their share
+    /// concurrently. With [`PoolStrategy::LeastLoaded`] each target goes to
+    /// the member with the fewest operations in flight plus targets already
+    /// assigned, so members busy with other work get a smaller share. A
+    /// running share counts one operation per target, here and for other
+    /// callers picking a member.
+    /// Results are in the same order as `processes`; see
+    /// [`inject_processes`](crate::inject_processes).
+    pub fn inject_processes(
+        &self,
+        processes: &[Process],
+        library: impl Into<Library>,
+    ) -> Result<Vec<Result<InjectedProcess>>> {
+        let library = library.into();
+        let mut shares: Vec<Vec<usize>> = vec![Vec::new(); self.members.len()];
+        let mut load: Vec<usize> = self
+            .members
+            .iter()
+            .map(|member| member.in_flight.load(Ordering::Relaxed))
+            .collect();
+        for (index, process) in processes.iter().enumerate() {
+            let member = match self.strategy {
+                PoolStrategy::LeastLoaded => {
+                    let member = (0..load.len())
+                        .min_by_key(|&member| load[member])
+                        .unwrap_or(0);
+                    load[member] += 1;
+                    member
+                }
+                PoolStrategy::PidHash => self.member_for_pid(*process),
+            };
+            shares[member].push(index);
+        }
+
+        let outcomes: Vec<_> = std::thread::scope(|scope| {
+            let workers: Vec<_> = shares
+                .iter()
+                .enumerate()
+                .filter(|(_, share)| !share.is_empty())
+                .map(|(member, share)| {
+                    let library = library.clone();
+                    let targets: Vec<Process> = share.iter().map(|&i| processes[i]).collect();
+                    scope.spawn(move || {
+                        // The whole share counts against the member while it runs.
+                        let op = self.enter(member, targets.len());
+                        op.backend.inject_processes(&targets, library)
+                    })
+                })
+                .collect();
+            workers
+                .into_iter()
+                .map(|worker| worker.join().expect("pool worker panicked"))
+                .collect()
+        });
+
+        let mut results: Vec<Option<Result<InjectedProcess>>> =
+            processes.iter().map(|_| None).collect();
+        let shares = shares.into_iter().filter(|share| !share.is_empty());
+        for (share, outcome) in shares.zip(outcomes) {
+            for (index, result) in share.into_iter().zip(outcome?) {
+                results[index] = Some(result);
+            }
+        }
+        Ok(results
+            .into_iter()
+            .map(|result| result.expect("every target has a result"))
+            .collect())
+    }
+
+    /// Spawn a program in a suspended state.
+    ///
+    /// The returned handle resumes and injects through the same member.
+    pub fn spawn(&self, spec: impl Into<Program>) -> Result<SuspendedProgram> {
+        let op = self.acquire(None);
+        op.backend.spawn(spec.into(), None)
+    }
+
+    /// Marshal a program once for repeated launches; see [`PreparedProgram`].
+    ///
+    /// Every launch of it runs on the member with the fewest operations in
+    /// flight when it was prepared.
+    pub fn prepare(&self, spec: impl Into<Program>) -> Result<PreparedProgram> {
+        let op = self.acquire(None);
+        PreparedProgram::with_backend(op.backend.clone(), &spec.into())
+    }
+
+    /// Launch a fleet of programs with the library injected, starting them together.
+    ///
+    /// The whole batch runs on one member; see [`spawn_batch`](crate::spawn_batch).
+    pub fn spawn_batch<P: Into<Program>>(
+        &self,
+        programs: impl IntoIterator<Item = P>,
+        library: impl Into<Library>,
+    ) -> Result<Vec<Result<InjectedProgram>>> {
+        let programs = programs.into_iter().map(Into::into).collect();
+        let op = self.acquire(None);
+        op.backend.spawn_batch(programs, library.into())
+    }
+
+    /// Asynchronously inject a library into an already-running process.
+    pub async fn inject_process_async(
+        &self,
+        process: Process,
+        library: impl Into<Library>,
+    ) -> Result<InjectedProcess> {
+        let library = library.into();
+        let op = self.acquire(Some(process));
+        op.backend.inject_process_async(process, library).await
+    }
+
+    /// Asynchronously spawn a program in a suspended state.
+    pub async fn spawn_async(&self, spec: impl Into<Program>) -> Result<SuspendedProgram> {
+        let spec = spec.into();
+        let op = self.acquire(None);
+        op.backend.spawn_async(spec).await
+    }
+
+    fn acquire(&self, process: Option<Process>) -> InFlight<'_> {
+        let member = match (self.strategy, process) {
+            (PoolStrategy::PidHash, Some(process)) => self.member_for_pid(process),
+            _ => self.least_loaded(),
+        };
+        self.enter(member, 1)
+    }
+
+    fn enter(&self, member: usize, weight: usize) -> InFlight<'_> {
+        let member = &self.members[member];
+        member.in_flight.fetch_add(weight, Ordering::Relaxed);
+        InFlight {
+            backend: &member.backend,
+            count: &member.in_flight,
+            weight,
+        }
+    }
+
+    fn least_loaded(&self) -> usize {
+        self.members
+            .iter()
+            .enumerate()
+            .min_by_key(|(_, member)| member.in_flight.load(Ordering::Relaxed))
+            .map(|(index, _)| index)
+            .unwrap_or(0)
+    }
+
+    fn member_for_pid(&self, process: Process) -> usize {
+        process.pid().unsigned_abs() as usize % self.members.len()
+    }
+}
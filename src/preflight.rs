@@ -0,0 +1,720 @@
+use std::collections::{HashMap, HashSet};
+use std::ffi::CStr;
+use std::fmt;
+use std::fs::File;
+use std::io::Read;
+use std::path::{Path, PathBuf};
+use std::sync::{Arc, Mutex, OnceLock};
+use std::time::SystemTime;
+
+use crate::library::LibrarySource;
+use crate::{Error, Library, Process, Result};
+
+/// Bytes read from a target's executable; every header we need is inside.
+const TARGET_HEADER_LEN: u64 = 4096;
+
+/// Parsed files kept before the cache starts over.
+const CACHE_LIMIT: usize = 1024;
+
+/// Check `library` against `process` without touching the target.
+pub(crate) fn check(library: &Library, process: Process) -> Result<()> {
+    // An unreadable target executable only skips the architecture check.
+    inspect(library)?.check(target_image(process).as_deref(), library.entrypoint())
+}
+
+/// Parse a library's headers and exports.
+pub(crate) fn inspect(library: &Library) -> Result<Arc<Image>> {
+    match library.source() {
+        LibrarySource::Path(path) => cached(path, true),
+        LibrarySource::Blob(payload) => Ok(Arc::new(Image::parse(payload.as_slice(), true)?)),
+    }
+}
+
+/// Headers of the executable `process` runs, if they can be read.
+pub(crate) fn target_image(process: Process) -> Option<Arc<Image>> {
+    target_executable(process).and_then(|path| cached(&path, false).ok())
+}
+
+/// Identity of a file version: parsed once per key.
+#[derive(Debug, PartialEq, Eq, Hash)]
+struct FileKey {
+    #[cfg(unix)]
+    id: (u64, u64),
+    #[cfg(not(unix))]
+    id: PathBuf,
+    len: u64,
+    modified: Option<SystemTime>,
+    exports: bool,
+}
+
+fn cached(path: &Path, exports: bool) -> Result<Arc<Image>> {
+    static CACHE: OnceLock<Mutex<HashMap<FileKey, Arc<Image>>>> = OnceLock::new();
+
+    // Stat through the open file so the key describes the bytes we read.
+    let file = File::open(path).map_err(Error::from)?;
+    let meta = file.metadata().map_err(Error::from)?;
+    let key = FileKey {
+        #[cfg(unix)]
+        id: {
+            use std::os::unix::fs::MetadataExt;
+            (meta.dev(), meta.ino())
+        },
+        #[cfg(not(unix))]
+        id: path.to_path_buf(),
+        len: meta.len(),
+        modified: meta.modified().ok(),
+        exports,
+    };
+
+    let cache = CACHE.get_or_init(Default::default);
+    if let Some(image) = lock(cache).get(&key) {
+        return Ok(image.clone());
+    }
+
+    let mut bytes = Vec::new();
+    if exports {
+        (&file).read_to_end(&mut bytes).map_err(Error::from)?;
+    } else {
+        (&file)
+            .take(TARGET_HEADER_LEN)
+            .read_to_end(&mut bytes)
+            .map_err(Error::from)?;
+    }
+    let image = Arc::new(Image::parse(&bytes, exports)?);
+
+    let mut cache = lock(cache);
+    if cache.len() >= CACHE_LIMIT {
+        cache.clear();
+    }
+    cache.insert(key, image.clone());
+    Ok(image)
+}
+
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+enum Format {
+    Elf,
+    MachO,
+    Pe,
+}
+
+impl fmt::Display for Format {
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+        f.write_str(match self {
+            Format::Elf => "ELF",
+            Format::MachO => "Mach-O",
+            Format::Pe => "PE",
+        })
+    }
+}
+
+/// CPU architecture; `Other` keeps the format's raw machine id.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+enum Arch {
+    X86,
+    X86_64,
+    Arm,
+    Arm64,
+    Other(u32),
+}
+
+impl fmt::Display for Arch {
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+        match self {
+            Arch::X86 => f.write_str("x86"),
+            Arch::X86_64 => f.write_str("x86_64"),
+            Arch::Arm => f.write_str("arm"),
+            Arch::Arm64 => f.write_str("arm64"),
+            Arch::Other(id) => write!(f, "machine {id:#x}"),
+        }
+    }
+}
+
+/// Headers of an executable or library; universal Mach-O files have several slices.
+#[derive(Debug)]
+pub(crate) struct Image {
+    format: Format,
+    slices: Vec<Slice>,
+}
+
+#[derive(Debug)]
+struct Slice {
+    arch: Arch,
+    /// Exported symbol names, or `None` if they were not (or could not be) read.
+    exports: Option<HashSet<Box<[u8]>>>,
+}
+
+impl Image {
+    fn parse(data: &[u8], exports: bool) -> Result<Image> {
+        parse_elf(data, exports)
+            .or_else(|| parse_macho(data, exports))
+            .or_else(|| parse_pe(data, exports))
+            .ok_or_else(|| Error::invalid_input("library is not an ELF, Mach-O or PE image"))
+    }
+
+    /// Whether an image with this format and arch exporting `entrypoint` can
+    /// be loaded by `target`; `None` skips the architecture check.
+    pub(crate) fn check(&self, target: Option<&Image>, entrypoint: &CStr) -> Result<()> {
+        let slices: Vec<&Slice> = match target {
+            Some(target) => {
+                if target.format != self.format {
+                    return Err(Error::invalid_input(format_args!(
+                        "library is a {} image but the target process runs a {} executable",
+                        self.format, target.format
+                    )));
+                }
+                let matching: Vec<&Slice> = self
+                    .slices
+                    .iter()
+                    .filter(|slice| target.slices.iter().any(|t| t.arch == slice.arch))
+                    .collect();
+                if matching.is_empty() {
+                    return Err(Error::invalid_input(format_args!(
+                        "library architecture ({}) does not match the target process ({})",
+                        self.arches(),
+                        target.arches()
+                    )));
+                }
+                matching
+            }
+            None => self.slices.iter().collect(),
+        };
+
+        let name = entrypoint.to_bytes();
+        if slices.iter().any(|slice| {
+            slice
+                .exports
+                .as_ref()
+                .is_none_or(|exports| exports.contains(name))
+        }) {
+            Ok(())
+        } else {
+            Err(Error::invalid_input(format_args!(
+                "library does not export its entrypoint `{}`",
+                entrypoint.to_string_lossy()
+            )))
+        }
+    }
+
+    /// Whether both images share a format and at least one architecture.
+    pub(crate) fn shares_arch(&self, other: &Image) -> bool {
+        self.format == other.format
+            && self
+                .slices
+                .iter()
+                .any(|slice| other.slices.iter().any(|o| o.arch == slice.arch))
+    }
+
+    /// Comma-separated architectures, for messages.
+    pub(crate) fn arches(&self) -> String {
+        let arches: Vec<String> = self.slices.iter().map(|s| s.arch.to_string()).collect();
+        arches.join(", ")
+    }
+}
+
+/// Bounds-checked reads from untrusted file bytes.
+struct Reader<'a> {
+    data: &'a [u8],
+    big_endian: bool,
+}
+
+impl<'a> Reader<'a> {
+    fn bytes(&self, offset: usize, len: usize) -> Option<&'a [u8]> {
+        self.data.get(offset..offset.checked_add(len)?)
+    }
+
+    fn u8(&self, offset: usize) -> Option<u8> {
+        self.data.get(offset).copied()
+    }
+
+    fn u16(&self, offset: usize) -> Option<u16> {
+        let raw = self.bytes(offset, 2)?.try_into().ok()?;
+        Some(if self.big_endian {
+            u16::from_be_bytes(raw)
+        } else {
+            u16::from_le_bytes(raw)
+        })
+    }
+
+    fn u32(&self, offset: usize) -> Option<u32> {
+        let raw = self.bytes(offset, 4)?.try_into().ok()?;
+        Some(if self.big_endian {
+            u32::from_be_bytes(raw)
+        } else {
+            u32::from_le_bytes(raw)
+        })
+    }
+
+    fn u64(&self, offset: usize) -> Option<u64> {
+        let raw = self.bytes(offset, 8)?.try_into().ok()?;
+        Some(if self.big_endian {
+            u64::from_be_bytes(raw)
+        } else {
+            u64::from_le_bytes(raw)
+        })
+    }
+
+    /// A `usize` offset stored as a 32- or 64-bit field.
+    fn offset(&self, offset: usize, wide: bool) -> Option<usize> {
+        if wide {
+            usize::try_from(self.u64(offset)?).ok()
+        } else {
+            usize::try_from(self.u32(offset)?).ok()
+        }
+    }
+}
+
+/// The NUL-terminated name at `offset` in a string table.
+fn name_at(table: &[u8], offset: usize) -> Option<&[u8]> {
+    let tail = table.get(offset..)?;
+    let len = tail.iter().position(|&b| b == 0)?;
+    (len > 0).then(|| &tail[..len])
+}
+
+fn parse_elf(data: &[u8], exports: bool) -> Option<Image> {
+    if data.get(..4)? != b"\x7fELF" {
+        return None;
+    }
+    let wide = match data.get(4)? {
+        1 => false,
+        2 => true,
+        _ => return None,
+    };
+    let big_endian = match data.get(5)? {
+        1 => false,
+        2 => true,
+        _ => return None,
+    };
+    let r = Reader { data, big_endian };
+
+    let arch = match (r.u16(18)?, wide) {
+        (3, false) => Arch::X86,
+        (62, true) => Arch::X86_64,
+        (40, false) => Arch::Arm,
+        (183, true) => Arch::Arm64,
+        // Keep the class apart so e.g. x32 does not match x86_64.
+        (machine, wide) => Arch::Other(u32::from(machine) | (u32::from(wide) << 16)),
+    };
+    Some(Image {
+        format: Format::Elf,
+        slices: vec![Slice {
+            arch,
+            exports: if exports { elf_exports(&r, wide) } else { None },
+        }],
+    })
+}
+
+struct ElfSection {
+    kind: u32,
+    offset: usize,
+    size: usize,
+    link: u32,
+}
+
+/// Defined, default- or protected-visibility globals of `.dynsym`.
+fn elf_exports(r: &Reader<'_>, wide: bool) -> Option<HashSet<Box<[u8]>>> {
+    const SHT_DYNSYM: u32 = 11;
+
+    let (shoff, shentsize, shnum) = if wide {
+        (r.offset(40, true)?, r.u16(58)?, r.u16(60)?)
+    } else {
+        (r.offset(32, false)?, r.u16(46)?, r.u16(48)?)
+    };
+    let section = |index: usize| -> Option<ElfSection> {
+        let base = shoff.checked_add(index.checked_mul(usize::from(shentsize))?)?;
+        Some(if wide {
+            ElfSection {
+                kind: r.u32(base + 4)?,
+                offset: r.offset(base + 24, true)?,
+                size: r.offset(base + 32, true)?,
+                link: r.u32(base + 40)?,
+            }
+        } else {
+            ElfSection {
+                kind: r.u32(base + 4)?,
+                offset: r.offset(base + 16, false)?,
+                size: r.offset(base + 20, false)?,
+                link: r.u32(base + 24)?,
+            }
+        })
+    };
+
+    // Stripped section headers leave the exports unknown, not empty.
+    let dynsym = (0..usize::from(shnum))
+        .filter_map(section)
+        .find(|section| section.kind == SHT_DYNSYM)?;
+    let strings = section(dynsym.link as usize)?;
+    let strtab = r.bytes(strings.offset, strings.size)?;
+
+    let entsize = if wide { 24 } else { 16 };
+    let mut names = HashSet::new();
+    for index in 0..dynsym.size / entsize {
+        let base = dynsym.offset.checked_add(index * entsize)?;
+        let (name, info, other, shndx) = if wide {
+            (
+                r.u32(base)?,
+                r.u8(base + 4)?,
+                r.u8(base + 5)?,
+                r.u16(base + 6)?,
+            )
+        } else {
+            (
+                r.u32(base)?,
+                r.u8(base + 12)?,
+                r.u8(base + 13)?,
+                r.u16(base + 14)?,
+            )
+        };
+        // GLOBAL, WEAK or GNU_UNIQUE binding; DEFAULT or PROTECTED visibility.
+        let exported = shndx != 0 && matches!(info >> 4, 1 | 2 | 10) && matches!(other & 3, 0 | 3);
+        if exported && let Some(name) = name_at(strtab, name as usize) {
+            names.insert(name.into());
+        }
+    }
+    Some(names)
+}
+
+fn parse_macho(data: &[u8], exports: bool) -> Option<Image> {
+    let r = Reader {
+        data,
+        big_endian: true,
+    };
+    let slices = match r.u32(0)? {
+        magic @ (0xcafe_babe | 0xcafe_babf) => {
+            let wide = magic == 0xcafe_babf;
+            let count = r.u32(4)? as usize;
+            // Java class files share the fat magic; their "count" is a version.
+            if count == 0 || count > 32 {
+                return None;
+            }
+            let entsize = if wide { 32 } else { 20 };
+            let mut slices = Vec::with_capacity(count);
+            for index in 0..count {
+                let base = 8 + index * entsize;
+                if exports {
+                    let (offset, size) = if wide {
+                        (r.offset(base + 8, true)?, r.offset(base + 16, true)?)
+                    } else {
+                        (r.offset(base + 8, false)?, r.offset(base + 12, false)?)
+                    };
+                    slices.push(macho_slice(r.bytes(offset, size)?, true)?);
+                } else {
+                    slices.push(Slice {
+                        arch: macho_arch(r.u32(base)?),
+                        exports: None,
+                    });
+                }
+            }
+            slices
+        }
+        _ => vec![macho_slice(data, exports)?],
+    };
+    Some(Image {
+        format: Format::MachO,
+        slices,
+    })
+}
+
+fn macho_arch(cputype: u32) -> Arch {
+    match cputype {
+        7 => Arch::X86,
+        0x0100_0007 => Arch::X86_64,
+        12 => Arch::Arm,
+        0x0100_000c => Arch::Arm64,
+        other => Arch::Other(other),
+    }
+}
+
+fn macho_slice(data: &[u8], exports: bool) -> Option<Slice> {
+    let (big_endian, wide) = match u32::from_le_bytes(data.get(..4)?.try_into().ok()?) {
+        0xfeed_face => (false, false),
+        0xfeed_facf => (false, true),
+        0xcefa_edfe => (true, false),
+        0xcffa_edfe => (true, true),
+        _ => return None,
+    };
+    let r = Reader { data, big_endian };
+    Some(Slice {
+        arch: macho_arch(r.u32(4)?),
+        exports: if exports {
+            macho_exports(&r, wide)
+        } else {
+            None
+        },
+    })
+}
+
+/// External symbols defined in a section, from `LC_SYMTAB`, minus the `_` prefix.
+fn macho_exports(r: &Reader<'_>, wide: bool) -> Option<HashSet<Box<[u8]>>> {
+    const LC_SYMTAB: u32 = 0x2;
+
+    let mut command = if wide { 32 } else { 28 };
+    for _ in 0..r.u32(16)? {
+        let (kind, size) = (r.u32(command)?, r.u32(command + 4)? as usize);
+        if kind == LC_SYMTAB {
+            let symoff = r.u32(command + 8)? as usize;
+            let nsyms = r.u32(command + 12)? as usize;
+            let strtab = r.bytes(r.u32(command + 16)? as usize, r.u32(command + 20)? as usize)?;
+
+            let entsize = if wide { 16 } else { 12 };
+            let mut names = HashSet::new();
+            for index in 0..nsyms {
+                let base = symoff.checked_add(index * entsize)?;
+                let (strx, kind) = (r.u32(base)?, r.u8(base + 4)?);
+                // Not a debug entry, external, and defined in a section.
+                let exported = kind & 0xe0 == 0 && kind & 0x01 != 0 && kind & 0x0e == 0x0e;
+                if exported && let Some(name) = name_at(strtab, strx as usize) {
+                    names.insert(name.strip_prefix(b"_").unwrap_or(name).into());
+                }
+            }
+            return Some(names);
+        }
+        if size == 0 {
+            return None;
+        }
+        command = command.checked_add(size)?;
+    }
+    None
+}
+
+fn parse_pe(data: &[u8], exports: bool) -> Option<Image> {
+    let r = Reader {
+        data,
+        big_endian: false,
+    };
+    if data.get(..2)? != b"MZ" {
+        return None;
+    }
+    let pe = r.u32(0x3c)? as usize;
+    if r.bytes(pe, 4)? != b"PE\0\0" {
+        return None;
+    }
+
+    let arch = match r.u16(pe + 4)? {
+        0x014c => Arch::X86,
+        0x8664 => Arch::X86_64,
+        0x01c0 | 0x01c4 => Arch::Arm,
+        0xaa64 => Arch::Arm64,
+        other => Arch::Other(u32::from(other)),
+    };
+    Some(Image {
+        format: Format::Pe,
+        slices: vec![Slice {
+            arch,
+            exports: if exports { pe_exports(&r, pe) } else { None },
+        }],
+    })
+}
+
+/// Names in the export directory.
+fn pe_exports(r: &Reader<'_>, pe: usize) -> Option<HashSet<Box<[u8]>>> {
+    let sections = usize::from(r.u16(pe + 6)?);
+    let optional = pe + 24;
+    let directories = match r.u16(optional)? {
+        0x10b => optional + 96,
+        0x20b => optional + 112,
+        _ => return None,
+    };
+    let table = optional + usize::from(r.u16(pe + 20)?);
+    let file_offset = |rva: u32| -> Option<usize> {
+        (0..sections).find_map(|index| {
+            let section = table + index * 40;
+            let size = r.u32(section + 8)?.max(r.u32(section + 16)?);
+            let start = r.u32(section + 12)?;
+            let raw = r.u32(section + 20)?;
+            let delta = rva.checked_sub(start).filter(|&delta| delta < size)?;
+            usize::try_from(raw.checked_add(delta)?).ok()
+        })
+    };
+
+    let mut names = HashSet::new();
+    let directory = r.u32(directories)?;
+    if directory == 0 {
+        return Some(names);
+    }
+    let directory = file_offset(directory)?;
+    let count = r.u32(directory + 24)? as usize;
+    let name_table = file_offset(r.u32(directory + 32)?)?;
+    for index in 0..count {
+        let name = file_offset(r.u32(name_table.checked_add(index * 4)?)?)?;
+        if let Some(name) = name_at(r.data, name) {
+            names.insert(name.into());
+        }
+    }
+    Some(names)
+}
+
+#[cfg(any(target_os = "linux", target_os = "android"))]
+fn target_executable(process: Process) -> Option<PathBuf> {
+    Some(PathBuf::from(format!("/proc/{}/exe", process.pid())))
+}
+
+#[cfg(target_vendor = "apple")]
+fn target_executable(process: Process) -> Option<PathBuf> {
+    use std::ffi::OsString;
+    use std::os::unix::ffi::OsStringExt;
+
+    let mut buf = vec![0u8; libc::PROC_PIDPATHINFO_MAXSIZE as usize];
+    let len =
+        unsafe { libc::proc_pidpath(process.pid(), buf.as_mut_ptr().cast(), buf.len() as u32) };
+    if len <= 0 {
+        return None;
+    }
+    buf.truncate(len as usize);
+    Some(PathBuf::from(OsString::from_vec(buf)))
+}
+
+#[cfg(windows)]
+fn target_executable(process: Process) -> Option<PathBuf> {
+    use std::ffi::OsString;
+    use std::os::windows::ffi::OsStringExt;
+    use windows_sys::Win32::Foundation::{CloseHandle, HANDLE};
+    use windows_sys::Win32::System::Threading::{
+        OpenProcess, PROCESS_QUERY_LIMITED_INFORMATION, QueryFullProcessImageNameW,
+    };
+
+    let handle: HANDLE =
+        unsafe { OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, 0, process.pid() as u32) };
+    if handle.is_null() {
+        return None;
+    }
+    let mut buf = vec![0u16; 32 * 1024];
+    let mut len = buf.len() as u32;
+    let ok = unsafe { QueryFullProcessImageNameW(handle, 0, buf.as_mut_ptr(), &mut len) };
+    unsafe { CloseHandle(handle) };
+    (ok != 0).then(|| PathBuf::from(OsString::from_wide(&buf[..len as usize])))
+}
+
+#[cfg(not(any(
+    target_os = "linux",
+    target_os = "android",
+    target_vendor = "apple",
+    windows
+)))]
+fn target_executable(_process: Process) -> Option<PathBuf> {
+    None
+}
+
+fn lock<T>(mutex: &Mutex<T>) -> std::sync::MutexGuard<'_, T> {
+    mutex.lock().unwrap_or_else(|err| err.into_inner())
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn put(buf: &mut Vec<u8>, offset: usize, bytes: &[u8]) {
+        if buf.len() < offset + bytes.len() {
+            buf.resize(offset + bytes.len(), 0);
+        }
+        buf[offset..offset + bytes.len()].copy_from_slice(bytes);
+    }
+
+    /// A little-endian 64-bit Mach-O exporting `_hook_inject_entry`.
+    fn thin_macho(cputype: u32) -> Vec<u8> {
+        let mut data = Vec::new();
+        put(&mut data, 0, &0xfeed_facf_u32.to_le_bytes());
+        put(&mut data, 4, &cputype.to_le_bytes());
+        put(&mut data, 16, &1u32.to_le_bytes());
+        // LC_SYMTAB: one symbol at 56, strings at 72.
+        for (offset, value) in [(32, 2u32), (36, 24), (40, 56), (44, 1), (48, 72), (52, 20)] {
+            put(&mut data, offset, &value.to_le_bytes());
+        }
+        put(&mut data, 56, &1u32.to_le_bytes());
+        // N_SECT | N_EXT.
+        put(&mut data, 60, &[0x0f, 1]);
+        put(&mut data, 72, b"\0_hook_inject_entry\0");
+        data
+    }
+
+    #[test]
+    fn parses_thin_macho() {
+        let image = Image::parse(&thin_macho(0x0100_000c), true).expect("thin Mach-O");
+        assert_eq!(image.format, Format::MachO);
+        assert_eq!(image.arches(), "arm64");
+        image
+            .check(None, c"hook_inject_entry")
+            .expect("entrypoint should be exported");
+        assert!(image.check(None, c"hook_inject_missing").is_err());
+    }
+
+    #[test]
+    fn parses_fat_macho() {
+        let slices = [thin_macho(0x0100_000c), thin_macho(0x0100_0007)];
+        let mut data = Vec::new();
+        put(&mut data, 0, &0xcafe_babe_u32.to_be_bytes());
+        put(&mut data, 4, &2u32.to_be_bytes());
+        let mut offset = 256;
+        for (index, slice) in slices.iter().enumerate() {
+            let entry = 8 + index * 20;
+            let cputype = u32::from_le_bytes(slice[4..8].try_into().unwrap());
+            put(&mut data, entry, &cputype.to_be_bytes());
+            put(&mut data, entry + 8, &(offset as u32).to_be_bytes());
+            put(&mut data, entry + 12, &(slice.len() as u32).to_be_bytes());
+            put(&mut data, offset, slice);
+            offset += 256;
+        }
+
+        let headers = Image::parse(&data, false).expect("fat header");
+        assert_eq!(headers.arches(), "arm64, x86_64");
+        let image = Image::parse(&data, true).expect("fat Mach-O");
+        assert_eq!(image.arches(), "arm64, x86_64");
+        image
+            .check(Some(&headers), c"hook_inject_entry")
+            .expect("both slices export the entrypoint");
+
+        let x86_64 = Image::parse(&thin_macho(0x0100_0007), false).expect("thin Mach-O");
+        assert!(image.shares_arch(&x86_64));
+        let arm = Image::parse(&thin_macho(12), false).expect("thin Mach-O");
+        let err = image.check(Some(&arm), c"hook_inject_entry").unwrap_err();
+        assert!(
+            err.to_string()
+                .contains("does not match the target process")
+        );
+    }
+
+    #[test]
+    fn parses_pe_header_and_exports() {
+        let mut data = Vec::new();
+        put(&mut data, 0, b"MZ");
+        put(&mut data, 0x3c, &0x40u32.to_le_bytes());
+        put(&mut data, 0x40, b"PE\0\0");
+        put(&mut data, 0x44, &0x8664u16.to_le_bytes());
+        put(&mut data, 0x46, &1u16.to_le_bytes());
+        put(&mut data, 0x54, &0xf0u16.to_le_bytes());
+        // PE32+ optional header; the export directory is at RVA 0x1000.
+        put(&mut data, 0x58, &0x20bu16.to_le_bytes());
+        put(&mut data, 0x58 + 112, &0x1000u32.to_le_bytes());
+        // One section mapping RVA 0x1000 to file offset 0x200.
+        let section = 0x58 + 0xf0;
+        for (field, value) in [(8, 0x200u32), (12, 0x1000), (16, 0x200), (20, 0x200)] {
+            put(&mut data, section + field, &value.to_le_bytes());
+        }
+        // One name, whose RVA is at 0x1040 and which lives at 0x1050.
+        put(&mut data, 0x200 + 24, &1u32.to_le_bytes());
+        put(&mut data, 0x200 + 32, &0x1040u32.to_le_bytes());
+        put(&mut data, 0x240, &0x1050u32.to_le_bytes());
+        put(&mut data, 0x250, b"hook_inject_entry\0");
+        data.resize(0x400, 0);
+
+        let image = Image::parse(&data, true).expect("PE image");
+        assert_eq!(image.format, Format::Pe);
+        assert_eq!(image.arches(), "x86_64");
+        image
+            .check(None, c"hook_inject_entry")
+            .expect("entrypoint should be exported");
+        assert!(image.check(None, c"hook_inject_missing").is_err());
+
+        let macho = Image::parse(&thin_macho(0x0100_0007), false).expect("Mach-O");
+        let err = image.check(Some(&macho), c"hook_inject_entry").unwrap_err();
+        assert!(err.to_string().contains("runs a Mach-O executable"));
+    }
+
+    #[test]
+    fn rejects_unknown_formats() {
+        assert!(Image::parse(&[0u8; 64], true).is_err());
+        // A Java class file shares the fat Mach-O magic.
+        let mut class = 0xcafe_babe_u32.to_be_bytes().to_vec();
+        class.extend_from_slice(&[0, 0, 0, 52]);
+        assert!(Image::parse(&class, false).is_err());
+    }
+}
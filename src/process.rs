@@ -1,3 +1,5 @@
+use std::time::Duration;
+
 use crate::{Error, Result};
 
 /// Handle to a target process.
@@ -47,6 +49,98 @@ impl Process {
     pub fn pid(&self) -> i32 {
         self.pid
     }
+
+    /// Open an OS handle that tracks this exact process.
+    ///
+    /// The handle is a pidfd on Linux, a kqueue watching the pid on Apple
+    /// platforms and a process `HANDLE` on Windows. Once opened it keeps
+    /// referring to the same process even if the pid is later reused, so
+    /// open it as early as possible (ideally right after spawning).
+    ///
+    /// # Examples
+    /// ```no_run
+    /// # use hook_inject::Process;
+    /// let handle = Process::from_pid(1234)?.open()?;
+    /// if !handle.is_alive()? {
+    ///     println!("{} exited", handle.process().pid());
+    /// }
+    /// # Ok::<(), hook_inject::Error>(())
+    /// ```
+    pub fn open(&self) -> Result<ProcessHandle> {
+        if self.pid <= 0 {
+            return Err(Error::invalid_input("pid must be > 0"));
+        }
+
+        Ok(ProcessHandle {
+            process: *self,
+            inner: sys::Handle::open(self.pid)?,
+        })
+    }
+}
+
+/// OS handle to a process, safe against pid reuse.
+///
+/// Created by [`Process::open`]. Liveness checks and waits go through the
+/// handle instead of probing the pid. On Linux and Apple platforms the handle
+/// is also a file descriptor that becomes readable when the process exits,
+/// and on Windows a waitable object, so many targets can be watched from a single
+/// epoll/IOCP/`WaitForMultipleObjects` loop.
+#[derive(Debug)]
+pub struct ProcessHandle {
+    process: Process,
+    inner: sys::Handle,
+}
+
+impl ProcessHandle {
+    /// The process this handle tracks.
+    pub fn process(&self) -> Process {
+        self.process
+    }
+
+    /// Whether the process is still running.
+    pub fn is_alive(&self) -> Result<bool> {
+        self.inner.wait(Some(Duration::ZERO)).map(|exited| !exited)
+    }
+
+    /// Block until the process exits.
+    pub fn wait(&self) -> Result<()> {
+        self.inner.wait(None).map(|_| ())
+    }
+
+    /// Block until the process exits or `timeout` elapses.
+    ///
+    /// Returns `true` if the process exited.
+    pub fn wait_timeout(&self, timeout: Duration) -> Result<bool> {
+        self.inner.wait(Some(timeout))
+    }
+}
+
+#[cfg(any(target_os = "linux", target_vendor = "apple"))]
+impl std::os::fd::AsFd for ProcessHandle {
+    fn as_fd(&self) -> std::os::fd::BorrowedFd<'_> {
+        self.inner.fd.as_fd()
+    }
+}
+
+#[cfg(any(target_os = "linux", target_vendor = "apple"))]
+impl std::os::fd::AsRawFd for ProcessHandle {
+    fn as_raw_fd(&self) -> std::os::fd::RawFd {
+        self.inner.fd.as_raw_fd()
+    }
+}
+
+#[cfg(windows)]
+impl std::os::windows::io::AsHandle for ProcessHandle {
+    fn as_handle(&self) -> std::os::windows::io::BorrowedHandle<'_> {
+        self.inner.handle.as_handle()
+    }
+}
+
+#[cfg(windows)]
+impl std::os::windows::io::AsRawHandle for ProcessHandle {
+    fn as_raw_handle(&self) -> std::os::windows::io::RawHandle {
+        self.inner.handle.as_raw_handle()
+    }
 }
 
 impl TryFrom<i32> for Process {
@@ -103,3 +197,249 @@ fn process_exists(pid: i32) -> Result<bool> {
 
     Ok(false)
 }
+
+#[cfg(target_os = "linux")]
+fn timeout_millis(timeout: Option<Duration>) -> libc::c_int {
+    match timeout {
+        None => -1,
+        Some(timeout) => timeout
+            .as_nanos()
+            .div_ceil(1_000_000)
+            .min(libc::c_int::MAX as u128) as libc::c_int,
+    }
+}
+
+#[cfg(target_os = "linux")]
+mod sys {
+    use std::os::fd::{AsRawFd, FromRawFd, OwnedFd};
+    use std::time::Duration;
+
+    use crate::{Error, Result};
+
+    #[derive(Debug)]
+    pub(super) struct Handle {
+        pub(super) fd: OwnedFd,
+    }
+
+    impl Handle {
+        pub(super) fn open(pid: i32) -> Result<Handle> {
+            let fd = unsafe { libc::syscall(libc::SYS_pidfd_open, pid, 0) };
+            if fd < 0 {
+                let err = std::io::Error::last_os_error();
+                return Err(match err.raw_os_error() {
+                    Some(libc::ESRCH) => Error::process_not_found(pid),
+                    Some(libc::ENOSYS) => {
+                        Error::not_supported("pidfd_open requires Linux 5.3 or newer")
+                    }
+                    _ => Error::from(err),
+                });
+            }
+
+            Ok(Handle {
+                fd: unsafe { OwnedFd::from_raw_fd(fd as libc::c_int) },
+            })
+        }
+
+        /// Returns `true` once the process has exited.
+        pub(super) fn wait(&self, timeout: Option<Duration>) -> Result<bool> {
+            let mut pollfd = libc::pollfd {
+                fd: self.fd.as_raw_fd(),
+                events: libc::POLLIN,
+                revents: 0,
+            };
+            loop {
+                // A pidfd becomes readable when the process terminates.
+                let res = unsafe { libc::poll(&mut pollfd, 1, super::timeout_millis(timeout)) };
+                if res >= 0 {
+                    return Ok(res > 0);
+                }
+                let err = std::io::Error::last_os_error();
+                if err.kind() != std::io::ErrorKind::Interrupted {
+                    return Err(Error::from(err));
+                }
+            }
+        }
+    }
+}
+
+#[cfg(target_vendor = "apple")]
+mod sys {
+    use std::os::fd::{AsRawFd, FromRawFd, OwnedFd};
+    use std::sync::atomic::{AtomicBool, Ordering};
+    use std::time::Duration;
+
+    use crate::{Error, Result};
+
+    #[derive(Debug)]
+    pub(super) struct Handle {
+        pub(super) fd: OwnedFd,
+        exited: AtomicBool,
+    }
+
+    impl Handle {
+        pub(super) fn open(pid: i32) -> Result<Handle> {
+            let raw = unsafe { libc::kqueue() };
+            if raw < 0 {
+                return Err(Error::from(std::io::Error::last_os_error()));
+            }
+            let fd = unsafe { OwnedFd::from_raw_fd(raw) };
+
+            // Registering NOTE_EXIT pins the watch to the process that owns
+            // the pid right now; it fails with ESRCH if it is already gone.
+            let change = libc::kevent {
+                ident: pid as libc::uintptr_t,
+                filter: libc::EVFILT_PROC,
+                flags: libc::EV_ADD | libc::EV_ONESHOT,
+                fflags: libc::NOTE_EXIT,
+                data: 0,
+                udata: std::ptr::null_mut(),
+            };
+            let res = unsafe {
+                libc::kevent(
+                    fd.as_raw_fd(),
+                    &change,
+                    1,
+                    std::ptr::null_mut(),
+                    0,
+                    std::ptr::null(),
+                )
+            };
+            if res < 0 {
+                let err = std::io::Error::last_os_error();
+                return Err(match err.raw_os_error() {
+                    Some(libc::ESRCH) => Error::process_not_found(pid),
+                    _ => Error::from(err),
+                });
+            }
+
+            Ok(Handle {
+                fd,
+                exited: AtomicBool::new(false),
+            })
+        }
+
+        /// Returns `true` once the process has exited.
+        pub(super) fn wait(&self, timeout: Option<Duration>) -> Result<bool> {
+            // The one-shot event is consumed by the first successful read.
+            if self.exited.load(Ordering::Acquire) {
+                return Ok(true);
+            }
+
+            let timespec = timeout.map(|timeout| libc::timespec {
+                tv_sec: timeout.as_secs().min(libc::time_t::MAX as u64) as libc::time_t,
+                tv_nsec: timeout.subsec_nanos() as libc::c_long,
+            });
+            let mut event: libc::kevent = unsafe { std::mem::zeroed() };
+            loop {
+                let res = unsafe {
+                    libc::kevent(
+                        self.fd.as_raw_fd(),
+                        std::ptr::null(),
+                        0,
+                        &mut event,
+                        1,
+                        timespec
+                            .as_ref()
+                            .map_or(std::ptr::null(), |timespec| timespec as *const _),
+                    )
+                };
+                if res >= 0 {
+                    let exited = res > 0 && event.fflags & libc::NOTE_EXIT != 0;
+                    if exited {
+                        self.exited.store(true, Ordering::Release);
+                    }
+                    return Ok(exited);
+                }
+                let err = std::io::Error::last_os_error();
+                if err.kind() != std::io::ErrorKind::Interrupted {
+                    return Err(Error::from(err));
+                }
+            }
+        }
+    }
+}
+
+#[cfg(windows)]
+mod sys {
+    use std::os::windows::io::{AsRawHandle, FromRawHandle, OwnedHandle};
+    use std::time::Duration;
+
+    use windows_sys::Win32::Foundation::{
+        ERROR_ACCESS_DENIED, ERROR_INVALID_PARAMETER, GetLastError, WAIT_OBJECT_0, WAIT_TIMEOUT,
+    };
+    use windows_sys::Win32::System::Threading::{
+        INFINITE, OpenProcess, PROCESS_QUERY_LIMITED_INFORMATION, PROCESS_SYNCHRONIZE,
+        WaitForSingleObject,
+    };
+
+    use crate::{Error, Result};
+
+    #[derive(Debug)]
+    pub(super) struct Handle {
+        pub(super) handle: OwnedHandle,
+    }
+
+    impl Handle {
+        pub(super) fn open(pid: i32) -> Result<Handle> {
+            let raw = unsafe {
+                OpenProcess(
+                    PROCESS_QUERY_LIMITED_INFORMATION | PROCESS_SYNCHRONIZE,
+                    0,
+                    pid as u32,
+                )
+            };
+            if raw.is_null() {
+                return Err(match unsafe { GetLastError() } {
+                    ERROR_INVALID_PARAMETER => Error::process_not_found(pid),
+                    ERROR_ACCESS_DENIED => Error::permission_denied(
+                        "permission denied while opening process (OpenProcess)",
+                    ),
+                    _ => Error::from(std::io::Error::last_os_error()),
+                });
+            }
+
+            Ok(Handle {
+                handle: unsafe { OwnedHandle::from_raw_handle(raw as _) },
+            })
+        }
+
+        /// Returns `true` once the process has exited.
+        pub(super) fn wait(&self, timeout: Option<Duration>) -> Result<bool> {
+            let millis = match timeout {
+                None => INFINITE,
+                Some(timeout) => timeout.as_millis().min((INFINITE - 1) as u128) as u32,
+            };
+            match unsafe { WaitForSingleObject(self.handle.as_raw_handle() as _, millis) } {
+                WAIT_OBJECT_0 => Ok(true),
+                WAIT_TIMEOUT => Ok(false),
+                _ => Err(Error::from(std::io::Error::last_os_error())),
+            }
+        }
+    }
+}
+
+#[cfg(not(any(target_os = "linux", target_vendor = "apple", windows)))]
+mod sys {
+    use std::time::Duration;
+
+    use crate::{Error, Result};
+
+    #[derive(Debug)]
+    pub(super) struct Handle {
+        _priv: (),
+    }
+
+    impl Handle {
+        pub(super) fn open(_pid: i32) -> Result<Handle> {
+            Err(Error::not_supported(
+                "process handles are not supported on this platform",
+            ))
+        }
+
+        pub(super) fn wait(&self, _timeout: Option<Duration>) -> Result<bool> {
+            Err(Error::not_supported(
+                "process handles are not supported on this platform",
+            ))
+        }
+    }
+}
@@ -1,16 +1,18 @@
-use std::ffi::OsStr;
+use std::ffi::{OsStr, OsString};
 use std::ops::{Deref, DerefMut};
 use std::process::Command;
 
-use crate::Process;
+use crate::backend::{self, BackendHandle, SpawnOverrides, SpawnSpec};
+use crate::stdio::{ChildPipes, ChildStderr, ChildStdin, ChildStdout};
+use crate::{Cancellation, InjectedProgram, Library, Process, Result, SuspendedProgram};
 
 // Note: not every `Command` setting is honored by Frida's spawn API. We capture
 // program, args, env, cwd, and stdio for injection purposes.
 /// Wrapper around a program launch specification.
 ///
 /// This is a type-safe, introspectable equivalent of `std::process::Command`.
-/// When used with `inject_program`, stdio pipes are not exposed; spawn with
-/// `std::process::Command` if you need to capture output.
+/// When used with `inject_program`, `Stdio::Pipe` output is relayed through
+/// Frida and exposed on the returned [`Child`].
 ///
 /// # Examples
 /// ```no_run
@@ -35,7 +37,8 @@ pub enum Stdio {
     Inherit,
     /// Redirect stdio to `/dev/null` (or equivalent).
     Null,
-    /// Create pipes for stdio (pipe handles are exposed by `Command::spawn`).
+    /// Create pipes for stdio. Frida launches expose them on [`Child`];
+    /// `Command::spawn` exposes its own pipe handles.
     Pipe,
 }
 
@@ -129,24 +132,216 @@ impl DerefMut for Program {
     }
 }
 
-/// Opaque handle to a launched process spawned by the injector.
+/// A [`Program`] marshalled once for repeated launches.
 ///
-/// This exists for API stability; it intentionally exposes no child-style
-/// methods until Frida exposes the necessary handles.
+/// Encoding argv, the environment and the spawn options is paid once, when
+/// the spec is prepared. Each launch reuses them as they are, or re-encodes
+/// only the extra arguments and environment variables given to
+/// [`launch`](Self::launch). The spec is immutable, so one `PreparedProgram`
+/// can be shared by many threads.
+///
+/// # Examples
+/// ```no_run
+/// use hook_inject::{Library, PreparedProgram, Program};
+///
+/// let mut worker = Program::new("/usr/bin/worker");
+/// worker.arg("--queue").env("RUST_LOG", "info");
+/// let worker = PreparedProgram::new(worker)?;
+/// let library = Library::from_path("/path/to/libagent.so")?;
+///
+/// for shard in 0..4 {
+///     let injected = worker
+///         .launch()
+///         .arg(shard.to_string())
+///         .env("SHARD", shard.to_string())
+///         .inject(library.clone())?;
+///     println!("shard {shard}: pid {}", injected.process().pid());
+/// }
+/// # Ok::<(), hook_inject::Error>(())
+/// ```
+#[derive(Debug)]
+pub struct PreparedProgram {
+    backend: BackendHandle,
+    spec: SpawnSpec,
+}
+
+impl PreparedProgram {
+    /// Marshal `spec` for the default backend.
+    ///
+    /// Use [`BackendPool::prepare`](crate::BackendPool::prepare) or
+    /// [`Device::prepare`](crate::Device::prepare) to launch through another
+    /// backend.
+    pub fn new(spec: impl Into<Program>) -> Result<Self> {
+        Self::with_backend(backend::default_backend()?, &spec.into())
+    }
+
+    pub(crate) fn with_backend(backend: BackendHandle, spec: &Program) -> Result<Self> {
+        let spec = backend.prepare(spec)?;
+        Ok(Self { backend, spec })
+    }
+
+    /// The stdio mode every launch uses.
+    pub fn stdio(&self) -> Stdio {
+        self.spec.stdio()
+    }
+
+    /// Start a launch that can add arguments and environment variables.
+    pub fn launch(&self) -> PreparedLaunch<'_> {
+        PreparedLaunch {
+            prepared: self,
+            args: Vec::new(),
+            envs: Vec::new(),
+            cancel: None,
+        }
+    }
+
+    /// Launch the program unchanged and inject `library`,
+    /// like [`inject_program`](crate::inject_program).
+    pub fn inject(&self, library: impl Into<Library>) -> Result<InjectedProgram> {
+        self.launch().inject(library)
+    }
+
+    /// Spawn the program unchanged and leave it suspended,
+    /// like [`spawn`](crate::spawn).
+    pub fn spawn(&self) -> Result<SuspendedProgram> {
+        self.launch().spawn()
+    }
+}
+
+/// One launch of a [`PreparedProgram`], from [`PreparedProgram::launch`].
+///
+/// Arguments are appended after the prepared ones; an environment variable
+/// replaces the prepared value of the same name.
+#[derive(Debug)]
+pub struct PreparedLaunch<'a> {
+    prepared: &'a PreparedProgram,
+    args: Vec<OsString>,
+    envs: Vec<(OsString, OsString)>,
+    cancel: Option<&'a Cancellation>,
+}
+
+impl<'a> PreparedLaunch<'a> {
+    /// Append an argument for this launch.
+    pub fn arg(mut self, arg: impl AsRef<OsStr>) -> Self {
+        self.args.push(arg.as_ref().to_owned());
+        self
+    }
+
+    /// Append several arguments for this launch.
+    pub fn args<I, S>(mut self, args: I) -> Self
+    where
+        I: IntoIterator<Item = S>,
+        S: AsRef<OsStr>,
+    {
+        self.args
+            .extend(args.into_iter().map(|arg| arg.as_ref().to_owned()));
+        self
+    }
+
+    /// Set an environment variable for this launch.
+    pub fn env(mut self, key: impl AsRef<OsStr>, value: impl AsRef<OsStr>) -> Self {
+        self.envs
+            .push((key.as_ref().to_owned(), value.as_ref().to_owned()));
+        self
+    }
+
+    /// Give up on this launch once `cancel` is cancelled or expires.
+    pub fn cancellable(mut self, cancel: &'a Cancellation) -> Self {
+        self.cancel = Some(cancel);
+        self
+    }
+
+    /// Launch and inject `library`, like [`inject_program`](crate::inject_program).
+    pub fn inject(self, library: impl Into<Library>) -> Result<InjectedProgram> {
+        self.prepared.backend.inject_prepared(
+            &self.prepared.spec,
+            &self.overrides(),
+            library.into(),
+            self.cancel,
+        )
+    }
+
+    /// Spawn suspended, like [`spawn`](crate::spawn).
+    pub fn spawn(self) -> Result<SuspendedProgram> {
+        self.prepared
+            .backend
+            .spawn_prepared(&self.prepared.spec, &self.overrides(), self.cancel)
+    }
+
+    fn overrides(&self) -> SpawnOverrides<'_> {
+        SpawnOverrides {
+            args: &self.args,
+            envs: &self.envs,
+        }
+    }
+}
+
+/// Handle to a launched process spawned by the injector.
+///
+/// With [`Stdio::Pipe`] the child's stdio is relayed by Frida; take the
+/// streams with [`take_stdout`](Self::take_stdout),
+/// [`take_stderr`](Self::take_stderr) and [`take_stdin`](Self::take_stdin).
+///
+/// # Examples
+/// ```no_run
+/// use hook_inject::{inject_program, Library, Program, Stdio};
+/// use std::io::{BufRead, BufReader};
+///
+/// let program = Program::new("/usr/bin/env").stdio(Stdio::Pipe);
+/// let library = Library::from_path("/path/to/libagent.so")?;
+/// let mut injected = inject_program(program, library)?;
+/// let stdout = injected.child_mut().take_stdout().expect("piped stdout");
+/// for line in BufReader::new(stdout).lines() {
+///     println!("child: {}", line?);
+/// }
+/// # Ok::<(), Box<dyn std::error::Error>>(())
+/// ```
 #[derive(Debug)]
-#[allow(dead_code)]
 pub struct Child {
-    pid: i32,
+    process: Process,
     stdio: Stdio,
-    _priv: (),
+    stdin: Option<ChildStdin>,
+    stdout: Option<ChildStdout>,
+    stderr: Option<ChildStderr>,
 }
 
 impl Child {
-    pub(crate) fn new(process: Process, stdio: Stdio) -> Self {
+    pub(crate) fn new(process: Process, stdio: Stdio, pipes: Option<ChildPipes>) -> Self {
+        let (stdin, stdout, stderr) = match pipes {
+            Some(pipes) => (Some(pipes.stdin), Some(pipes.stdout), Some(pipes.stderr)),
+            None => (None, None, None),
+        };
         Self {
-            pid: process.pid(),
+            process,
             stdio,
-            _priv: (),
+            stdin,
+            stdout,
+            stderr,
         }
     }
+
+    /// The launched process.
+    pub fn process(&self) -> Process {
+        self.process
+    }
+
+    /// The stdio mode the child was launched with.
+    pub fn stdio(&self) -> Stdio {
+        self.stdio
+    }
+
+    /// Take the child's stdin writer; `None` unless launched with `Stdio::Pipe`.
+    pub fn take_stdin(&mut self) -> Option<ChildStdin> {
+        self.stdin.take()
+    }
+
+    /// Take the child's stdout reader; `None` unless launched with `Stdio::Pipe`.
+    pub fn take_stdout(&mut self) -> Option<ChildStdout> {
+        self.stdout.take()
+    }
+
+    /// Take the child's stderr reader; `None` unless launched with `Stdio::Pipe`.
+    pub fn take_stderr(&mut self) -> Option<ChildStderr> {
+        self.stderr.take()
+    }
 }
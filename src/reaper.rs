@@ -0,0 +1,111 @@
+use std::sync::OnceLock;
+use std::sync::mpsc::{self, Sender};
+
+use crate::backend::BackendHandle;
+use crate::{InjectedProcess, InjectionPath, Result};
+
+/// An [`InjectedProcess`] that is uninjected in the background when dropped.
+///
+/// Created by [`InjectedProcess::uninject_on_drop`]. Dropping the guard hands
+/// the injection to a shared reaper thread, which demonitors everything
+/// queued since its last pass as one batch, so teardown neither blocks the
+/// dropping thread nor leaks the injector's state for the library. Errors
+/// from the reaper are discarded; use [`uninject`](Self::uninject) to see them.
+///
+/// # Examples
+/// ```no_run
+/// use hook_inject::{inject_process, Library, Process};
+///
+/// let process = Process::from_pid(1234)?;
+/// let library = Library::from_path("/path/to/libagent.so")?;
+/// let injected = inject_process(process, library)?.uninject_on_drop();
+/// println!("guarding {}", injected.process().pid());
+/// drop(injected);
+/// # Ok::<(), hook_inject::Error>(())
+/// ```
+pub struct UninjectGuard {
+    injected: Option<InjectedProcess>,
+}
+
+impl UninjectGuard {
+    pub(crate) fn new(injected: InjectedProcess) -> Self {
+        Self {
+            injected: Some(injected),
+        }
+    }
+
+    /// Disarm the guard and return the handle.
+    pub fn into_inner(mut self) -> InjectedProcess {
+        self.injected.take().expect("guard holds its handle")
+    }
+
+    /// Uninject now, on the calling thread.
+    pub fn uninject(self) -> Result<()> {
+        self.into_inner().uninject()
+    }
+}
+
+impl std::ops::Deref for UninjectGuard {
+    type Target = InjectedProcess;
+
+    fn deref(&self) -> &InjectedProcess {
+        self.injected.as_ref().expect("guard holds its handle")
+    }
+}
+
+impl Drop for UninjectGuard {
+    fn drop(&mut self) {
+        if let Some(injected) = self.injected.take() {
+            reap(Reap {
+                backend: injected.backend,
+                id: injected.id,
+                path: injected.path,
+            });
+        }
+    }
+}
+
+impl std::fmt::Debug for UninjectGuard {
+    fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
+        f.debug_tuple("UninjectGuard").field(&**self).finish()
+    }
+}
+
+struct Reap {
+    backend: BackendHandle,
+    id: u64,
+    path: InjectionPath,
+}
+
+fn reap(job: Reap) {
+    static REAPER: OnceLock<Option<Sender<Reap>>> = OnceLock::new();
+    let unsent = match REAPER.get_or_init(spawn_reaper) {
+        Some(reaper) => reaper.send(job).err().map(|err| err.0),
+        None => Some(job),
+    };
+    // Without a reaper thread, uninject inline rather than leak.
+    if let Some(job) = unsent {
+        let _ = job.backend.uninject(job.id, job.path, None);
+    }
+}
+
+fn spawn_reaper() -> Option<Sender<Reap>> {
+    let (tx, rx) = mpsc::channel::<Reap>();
+    std::thread::Builder::new()
+        .name("hook-inject-reaper".into())
+        .spawn(move || {
+            while let Ok(first) = rx.recv() {
+                // Take everything queued meanwhile so the demonitors overlap.
+                let batch: Vec<Reap> = std::iter::once(first).chain(rx.try_iter()).collect();
+                let pending: Vec<_> = batch
+                    .iter()
+                    .map(|job| job.backend.begin_uninject(job.id, job.path))
+                    .collect();
+                for pending in pending {
+                    let _ = pending.wait();
+                }
+            }
+        })
+        .ok()?;
+    Some(tx)
+}
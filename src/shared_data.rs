@@ -0,0 +1,162 @@
+use std::ffi::{CStr, CString};
+use std::path::{Path, PathBuf};
+use std::sync::Arc;
+
+use crate::staging::PrivateDir;
+use crate::{Error, Result};
+
+/// Prefix of the entrypoint data string that describes a [`SharedData`].
+pub const SHARED_DATA_PREFIX: &str = "hook-inject-shm:";
+
+/// A read-only payload for the agent, passed by reference instead of by value.
+///
+/// [`Library::with_data`](crate::Library::with_data) copies a C string into
+/// every target, so it cannot carry NULs and gets slow for multi-megabyte
+/// configs. A `SharedData` is written once to a file on a memory-backed
+/// filesystem (`/dev/shm` on Linux, the temporary directory elsewhere) or
+/// wraps a file that already exists, and the entrypoint receives only a
+/// short descriptor:
+///
+/// ```text
+/// hook-inject-shm:<length>:<path>
+/// ```
+///
+/// The agent maps `<path>` read-only and reads the `<length>` bytes in place,
+/// so every target shares the same pages and nothing is parsed out of the
+/// data string. Map the file from the entrypoint: a segment created by
+/// [`new`](Self::new) is removed once this and every library using it are
+/// dropped, and existing mappings outlive the removal. Injection handles
+/// ([`InjectedProcess`](crate::InjectedProcess) and
+/// [`InjectedProgram`](crate::InjectedProgram)) keep their library, so the
+/// segment stays in place until the handle is dropped or uninjected, even
+/// if the agent maps it after `inject_process` returns.
+///
+/// Segments live in a directory only this process can write, under a name
+/// nobody can guess, and are readable by every user, like staged
+/// libraries, so targets running as another user can map them. The path is
+/// local to this machine; for a remote [`Device`](crate::Device), send the
+/// payload some other way.
+///
+/// # Examples
+/// ```no_run
+/// use hook_inject::{inject_process, Library, Process, SharedData};
+///
+/// let rules = SharedData::new(std::fs::read("/etc/agent/rules.bin")?)?;
+/// let library = Library::from_path("/path/to/libagent.so")?.with_shared_data(&rules);
+/// let process = Process::from_pid(1234)?;
+/// inject_process(process, library)?;
+/// # Ok::<(), hook_inject::Error>(())
+/// ```
+#[derive(Debug, Clone)]
+pub struct SharedData {
+    inner: Arc<Segment>,
+}
+
+#[derive(Debug)]
+struct Segment {
+    path: PathBuf,
+    len: u64,
+    descriptor: CString,
+    // Set for segments written by `new`, which are removed on drop.
+    dir: Option<Arc<PrivateDir>>,
+}
+
+impl SharedData {
+    /// Write `bytes` to a new segment.
+    ///
+    /// # Examples
+    /// ```no_run
+    /// # use hook_inject::SharedData;
+    /// let data = SharedData::new(b"binary\0config".as_slice())?;
+    /// assert_eq!(data.len(), 13);
+    /// # Ok::<(), hook_inject::Error>(())
+    /// ```
+    pub fn new(bytes: impl AsRef<[u8]>) -> Result<SharedData> {
+        let bytes = bytes.as_ref();
+        let (parent, in_memory) = segment_dir();
+        let dir = PrivateDir::get(&parent)?;
+        // Nothing to flush on tmpfs; syncing would only cost a round trip.
+        let path = dir.create_file(".data", bytes, !in_memory)?;
+        Self::build(path, bytes.len() as u64, Some(dir))
+    }
+
+    /// Share an existing file without copying it.
+    ///
+    /// The file is not removed; it must stay in place and unmodified until
+    /// every target has mapped it.
+    pub fn from_file<P: AsRef<Path>>(path: P) -> Result<SharedData> {
+        let path = std::path::absolute(path.as_ref()).map_err(Error::from)?;
+        let meta = std::fs::metadata(&path).map_err(Error::from)?;
+        if !meta.is_file() {
+            return Err(Error::invalid_input("shared data path must be a file"));
+        }
+        Self::build(path, meta.len(), None)
+    }
+
+    fn build(path: PathBuf, len: u64, dir: Option<Arc<PrivateDir>>) -> Result<SharedData> {
+        let descriptor = format!("{SHARED_DATA_PREFIX}{len}:{}", path.display());
+        let descriptor = CString::new(descriptor).map_err(|_| {
+            if dir.is_some() {
+                let _ = std::fs::remove_file(&path);
+            }
+            Error::invalid_input("shared data path contains NUL")
+        })?;
+        Ok(SharedData {
+            inner: Arc::new(Segment {
+                path,
+                len,
+                descriptor,
+                dir,
+            }),
+        })
+    }
+
+    /// The file backing the segment.
+    pub fn path(&self) -> &Path {
+        &self.inner.path
+    }
+
+    /// Payload length in bytes.
+    pub fn len(&self) -> u64 {
+        self.inner.len
+    }
+
+    /// Whether the payload is empty.
+    pub fn is_empty(&self) -> bool {
+        self.inner.len == 0
+    }
+
+    /// The data string handed to the entrypoint.
+    pub fn descriptor(&self) -> &CStr {
+        &self.inner.descriptor
+    }
+}
+
+/// The descriptor, for [`InjectedProcess::reinvoke`](crate::InjectedProcess::reinvoke);
+/// keep the `SharedData` alive until the agent has mapped it.
+impl From<&SharedData> for CString {
+    fn from(data: &SharedData) -> CString {
+        data.inner.descriptor.clone()
+    }
+}
+
+impl Drop for Segment {
+    fn drop(&mut self) {
+        if self.dir.is_some() {
+            let _ = std::fs::remove_file(&self.path);
+        }
+    }
+}
+
+/// Where segments go, and whether that is memory-backed.
+fn segment_dir() -> (PathBuf, bool) {
+    // tmpfs keeps the segment in memory even where /tmp is disk-backed.
+    #[cfg(any(target_os = "linux", target_os = "android"))]
+    {
+        let shm = Path::new("/dev/shm");
+        if shm.is_dir() {
+            return (shm.to_path_buf(), true);
+        }
+    }
+    (std::env::temp_dir(), false)
+}
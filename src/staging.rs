@@ -0,0 +1,199 @@
+use std::collections::HashMap;
+use std::fs::{File, OpenOptions};
+use std::hash::{BuildHasher, RandomState};
+use std::io::Write;
+use std::path::{Path, PathBuf};
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::sync::{Arc, Mutex, MutexGuard, OnceLock, Weak};
+
+use hook_inject_build::sha256::Sha256;
+
+use crate::{Error, Result};
+
+type Digest = [u8; 32];
+
+/// A blob written once to a temporary file in a [`PrivateDir`].
+///
+/// The file is shared by every library staged from the same bytes in this
+/// process and removed when the last handle drops.
+#[derive(Debug)]
+pub(crate) struct StagedFile {
+    path: PathBuf,
+    digest: Digest,
+    _dir: Arc<PrivateDir>,
+}
+
+static STAGED: OnceLock<Mutex<HashMap<Digest, Weak<StagedFile>>>> = OnceLock::new();
+
+impl StagedFile {
+    /// Stage `bytes`, reusing a live staging of the same content.
+    pub(crate) fn stage(bytes: &[u8]) -> Result<Arc<StagedFile>> {
+        let mut hasher = Sha256::new();
+        hasher.update(bytes);
+        let digest = hasher.finish();
+
+        let mut staged = lock(STAGED.get_or_init(Default::default));
+        // A matching digest is only trusted once the content matches too.
+        let mut replaced = None;
+        if let Some(existing) = staged.get(&digest).and_then(Weak::upgrade) {
+            if std::fs::read(&existing.path).is_ok_and(|staged| staged == bytes) {
+                return Ok(existing);
+            }
+            replaced = Some(existing);
+        }
+
+        let dir = PrivateDir::get(&std::env::temp_dir())?;
+        let path = dir.create_file(std::env::consts::DLL_SUFFIX, bytes, true)?;
+        let file = Arc::new(StagedFile {
+            path,
+            digest,
+            _dir: dir,
+        });
+        staged.insert(digest, Arc::downgrade(&file));
+        // `replaced` may be the last handle, and its drop takes the lock.
+        drop(staged);
+        drop(replaced);
+        Ok(file)
+    }
+
+    pub(crate) fn path(&self) -> &Path {
+        &self.path
+    }
+}
+
+impl Drop for StagedFile {
+    fn drop(&mut self) {
+        let Some(registry) = STAGED.get() else {
+            return;
+        };
+        // Under the lock, so `stage` never hands out a file being removed.
+        let mut staged = lock(registry);
+        // A newer staging of the same bytes may have replaced the entry; its
+        // file has its own name, so this one is still ours to remove.
+        if staged
+            .get(&self.digest)
+            .is_some_and(|entry| entry.strong_count() == 0)
+        {
+            staged.remove(&self.digest);
+        }
+        let _ = std::fs::remove_file(&self.path);
+    }
+}
+
+/// A directory only this process writes to, removed with its last file.
+///
+/// Files are created in it under unpredictable names with `create_new`, so
+/// no other local user can plant a symlink or swap a file before a target
+/// maps it. On Unix the directory is `0711`: other users cannot list or
+/// write it, but targets running as another user can still open a file
+/// whose name they were given.
+#[derive(Debug)]
+pub(crate) struct PrivateDir {
+    path: PathBuf,
+}
+
+static PRIVATE_DIRS: OnceLock<Mutex<HashMap<PathBuf, Weak<PrivateDir>>>> = OnceLock::new();
+
+impl PrivateDir {
+    /// This process's directory under `parent`, created on first use.
+    pub(crate) fn get(parent: &Path) -> Result<Arc<PrivateDir>> {
+        let mut dirs = lock(PRIVATE_DIRS.get_or_init(Default::default));
+        if let Some(existing) = dirs.get(parent).and_then(Weak::upgrade) {
+            return Ok(existing);
+        }
+
+        let path = loop {
+            let path = parent.join(format!(
+                "hook-inject-{}-{}",
+                std::process::id(),
+                unique_name()
+            ));
+            match create_private_dir(&path) {
+                Ok(()) => break path,
+                Err(err) if err.kind() == std::io::ErrorKind::AlreadyExists => continue,
+                Err(err) => return Err(Error::from(err)),
+            }
+        };
+        let dir = Arc::new(PrivateDir { path });
+        dirs.insert(parent.to_path_buf(), Arc::downgrade(&dir));
+        Ok(dir)
+    }
+
+    /// Write `bytes` to a new, world-readable file named with `suffix`.
+    ///
+    /// `sync` flushes it to disk; skip that on memory-backed filesystems.
+    pub(crate) fn create_file(&self, suffix: &str, bytes: &[u8], sync: bool) -> Result<PathBuf> {
+        let path = self.path.join(format!("{}{suffix}", unique_name()));
+        let mut file = create_new(&path).map_err(Error::from)?;
+        let written = file
+            .write_all(bytes)
+            .and_then(|()| if sync { file.sync_all() } else { Ok(()) });
+        if let Err(err) = written {
+            drop(file);
+            let _ = std::fs::remove_file(&path);
+            return Err(Error::from(err));
+        }
+        Ok(path)
+    }
+}
+
+impl Drop for PrivateDir {
+    fn drop(&mut self) {
+        if let Some(registry) = PRIVATE_DIRS.get() {
+            let mut dirs = lock(registry);
+            dirs.retain(|_, entry| entry.strong_count() > 0);
+        }
+        let _ = std::fs::remove_dir(&self.path);
+    }
+}
+
+/// A name nobody else can guess: SipHash keyed from the OS random source.
+fn unique_name() -> String {
+    static NEXT: AtomicU64 = AtomicU64::new(0);
+
+    let n = NEXT.fetch_add(1, Ordering::Relaxed);
+    format!(
+        "{:016x}{:016x}",
+        RandomState::new().hash_one(n),
+        RandomState::new().hash_one((n, std::process::id()))
+    )
+}
+
+#[cfg(unix)]
+fn create_private_dir(path: &Path) -> std::io::Result<()> {
+    use std::os::unix::fs::DirBuilderExt;
+
+    std::fs::DirBuilder::new().mode(0o711).create(path)?;
+    // The umask may have cleared the search bit other users need.
+    std::fs::set_permissions(path, std::os::unix::fs::PermissionsExt::from_mode(0o711))
+}
+
+#[cfg(not(unix))]
+fn create_private_dir(path: &Path) -> std::io::Result<()> {
+    // The per-user temporary directory is already private on Windows.
+    std::fs::create_dir(path)
+}
+
+#[cfg(unix)]
+fn create_new(path: &Path) -> std::io::Result<File> {
+    use std::os::unix::fs::{OpenOptionsExt, PermissionsExt};
+
+    let file = OpenOptions::new()
+        .write(true)
+        .create_new(true)
+        .mode(0o644)
+        .open(path)?;
+    // Targets may run as another user; they only need to read the file.
+    // Set through the descriptor, since the umask may have narrowed it.
+    file.set_permissions(std::fs::Permissions::from_mode(0o644))?;
+    Ok(file)
+}
+
+#[cfg(not(unix))]
+fn create_new(path: &Path) -> std::io::Result<File> {
+    OpenOptions::new().write(true).create_new(true).open(path)
+}
+
+fn lock<T>(mutex: &Mutex<T>) -> MutexGuard<'_, T> {
+    mutex.lock().unwrap_or_else(|err| err.into_inner())
+}
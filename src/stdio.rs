@@ -0,0 +1,302 @@
+use std::collections::{HashMap, VecDeque};
+use std::io::{self, Read, Write};
+use std::sync::atomic::{AtomicBool, Ordering};
+use std::sync::{Arc, Condvar, Mutex, MutexGuard, Weak};
+
+use crate::Process;
+use crate::backend::BackendHandle;
+
+/// Bytes buffered per stream before the oldest output is discarded.
+///
+/// Output arrives on Frida's event thread, which must never block on a slow
+/// reader, so a full buffer drops its oldest bytes instead of applying
+/// backpressure. [`ChildStdout::dropped_bytes`] reports how much was lost.
+pub const OUTPUT_BUFFER_LIMIT: usize = 1 << 20;
+
+/// Output of piped children, keyed by pid.
+///
+/// The shim announces every child spawned with [`Stdio::Pipe`](crate::Stdio::Pipe)
+/// before it is resumed, and only announced pids are buffered: output can
+/// reach us before the launch call returns and the `Child` claims it.
+/// Output for any other pid, including one whose entry was released, is
+/// dropped, so a reused pid never sees an earlier child's output.
+#[derive(Default)]
+pub(crate) struct OutputRegistry {
+    pipes: Mutex<HashMap<u32, Arc<Pipes>>>,
+}
+
+#[derive(Default)]
+struct Pipes {
+    stdout: Stream,
+    stderr: Stream,
+    claimed: AtomicBool,
+}
+
+#[derive(Default)]
+struct Stream {
+    state: Mutex<StreamState>,
+    ready: Condvar,
+}
+
+#[derive(Default)]
+struct StreamState {
+    buf: VecDeque<u8>,
+    closed: bool,
+    dropped: u64,
+}
+
+impl OutputRegistry {
+    /// Record a chunk from the device "output" signal; empty means EOF.
+    ///
+    /// fd 0 with no data announces a new piped child under `pid`.
+    pub(crate) fn push(&self, pid: u32, fd: i32, data: &[u8]) {
+        if fd == 0 && data.is_empty() {
+            // Replaces anything a previous child with this pid left behind.
+            lock(&self.pipes).insert(pid, Arc::default());
+            return;
+        }
+        if fd != 1 && fd != 2 {
+            return;
+        }
+
+        let Some(pipes) = lock(&self.pipes).get(&pid).cloned() else {
+            return;
+        };
+        let stream = if fd == 1 {
+            &pipes.stdout
+        } else {
+            &pipes.stderr
+        };
+        stream.push(data);
+
+        if pipes.claimed.load(Ordering::Acquire) && pipes.finished() {
+            self.release(pid, &pipes);
+        }
+    }
+
+    /// Take ownership of a child's output streams.
+    ///
+    /// Called once the spawn that announced `pid` has returned.
+    pub(crate) fn claim(self: &Arc<Self>, pid: u32) -> OutputClaim {
+        let pipes = lock(&self.pipes).entry(pid).or_default().clone();
+        pipes.claimed.store(true, Ordering::Release);
+        if pipes.finished() {
+            self.release(pid, &pipes);
+        }
+
+        OutputClaim {
+            registry: Arc::downgrade(self),
+            pid,
+            pipes,
+        }
+    }
+
+    fn release(&self, pid: u32, pipes: &Arc<Pipes>) {
+        let mut map = lock(&self.pipes);
+        if map.get(&pid).is_some_and(|entry| Arc::ptr_eq(entry, pipes)) {
+            map.remove(&pid);
+        }
+    }
+}
+
+impl Pipes {
+    fn finished(&self) -> bool {
+        self.stdout.closed() && self.stderr.closed()
+    }
+}
+
+impl Stream {
+    fn push(&self, data: &[u8]) {
+        let mut state = lock(&self.state);
+        if data.is_empty() {
+            state.closed = true;
+        } else {
+            let trimmed = data.len().saturating_sub(OUTPUT_BUFFER_LIMIT);
+            let data = &data[trimmed..];
+            let overflow = (state.buf.len() + data.len()).saturating_sub(OUTPUT_BUFFER_LIMIT);
+            state.buf.drain(..overflow);
+            state.buf.extend(data);
+            state.dropped += (trimmed + overflow) as u64;
+        }
+        drop(state);
+        self.ready.notify_all();
+    }
+
+    fn closed(&self) -> bool {
+        lock(&self.state).closed
+    }
+
+    fn read(&self, buf: &mut [u8], block: bool) -> io::Result<usize> {
+        if buf.is_empty() {
+            return Ok(0);
+        }
+
+        let mut state = lock(&self.state);
+        while state.buf.is_empty() && !state.closed {
+            if !block {
+                return Err(io::ErrorKind::WouldBlock.into());
+            }
+            state = self
+                .ready
+                .wait(state)
+                .unwrap_or_else(|err| err.into_inner());
+        }
+
+        let (front, back) = state.buf.as_slices();
+        let n = buf.len().min(state.buf.len());
+        let head = n.min(front.len());
+        buf[..head].copy_from_slice(&front[..head]);
+        buf[head..n].copy_from_slice(&back[..n - head]);
+        state.buf.drain(..n);
+        Ok(n)
+    }
+
+    fn dropped(&self) -> u64 {
+        lock(&self.state).dropped
+    }
+}
+
+/// A child's claimed output; unregisters it once every reader is gone.
+pub(crate) struct OutputClaim {
+    registry: Weak<OutputRegistry>,
+    pid: u32,
+    pipes: Arc<Pipes>,
+}
+
+impl Drop for OutputClaim {
+    fn drop(&mut self) {
+        if let Some(registry) = self.registry.upgrade() {
+            registry.release(self.pid, &self.pipes);
+        }
+    }
+}
+
+/// Piped stdio handles for a launched child.
+pub(crate) struct ChildPipes {
+    pub(crate) stdin: ChildStdin,
+    pub(crate) stdout: ChildStdout,
+    pub(crate) stderr: ChildStderr,
+}
+
+impl ChildPipes {
+    pub(crate) fn new(backend: BackendHandle, process: Process, claim: OutputClaim) -> Self {
+        let claim = Arc::new(claim);
+        Self {
+            stdin: ChildStdin { backend, process },
+            stdout: ChildStdout {
+                claim: claim.clone(),
+            },
+            stderr: ChildStderr { claim },
+        }
+    }
+}
+
+/// Writer for the stdin of a child launched with [`Stdio::Pipe`](crate::Stdio::Pipe).
+///
+/// Each `write` is forwarded to the child as one chunk. Frida has no way to
+/// close a child's stdin, so it stays open until the child exits.
+pub struct ChildStdin {
+    backend: BackendHandle,
+    process: Process,
+}
+
+impl Write for ChildStdin {
+    fn write(&mut self, buf: &[u8]) -> io::Result<usize> {
+        if buf.is_empty() {
+            return Ok(0);
+        }
+        self.backend
+            .input(self.process, buf)
+            .map_err(io::Error::other)?;
+        Ok(buf.len())
+    }
+
+    fn flush(&mut self) -> io::Result<()> {
+        Ok(())
+    }
+}
+
+impl std::fmt::Debug for ChildStdin {
+    fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
+        f.debug_struct("ChildStdin")
+            .field("pid", &self.process.pid())
+            .finish_non_exhaustive()
+    }
+}
+
+/// Reader for the stdout of a child launched with [`Stdio::Pipe`](crate::Stdio::Pipe).
+///
+/// `read` blocks until output arrives or the stream ends; `try_read` never
+/// blocks. Output is buffered up to [`OUTPUT_BUFFER_LIMIT`] bytes.
+pub struct ChildStdout {
+    claim: Arc<OutputClaim>,
+}
+
+/// Reader for the stderr of a child launched with [`Stdio::Pipe`](crate::Stdio::Pipe).
+///
+/// Behaves like [`ChildStdout`].
+pub struct ChildStderr {
+    claim: Arc<OutputClaim>,
+}
+
+impl ChildStdout {
+    /// Read buffered output without blocking.
+    ///
+    /// Returns `ErrorKind::WouldBlock` when nothing is buffered yet, and
+    /// `Ok(0)` once the stream has ended.
+    pub fn try_read(&mut self, buf: &mut [u8]) -> io::Result<usize> {
+        self.claim.pipes.stdout.read(buf, false)
+    }
+
+    /// Bytes discarded because the buffer was full.
+    pub fn dropped_bytes(&self) -> u64 {
+        self.claim.pipes.stdout.dropped()
+    }
+}
+
+impl ChildStderr {
+    /// Read buffered output without blocking.
+    ///
+    /// Returns `ErrorKind::WouldBlock` when nothing is buffered yet, and
+    /// `Ok(0)` once the stream has ended.
+    pub fn try_read(&mut self, buf: &mut [u8]) -> io::Result<usize> {
+        self.claim.pipes.stderr.read(buf, false)
+    }
+
+    /// Bytes discarded because the buffer was full.
+    pub fn dropped_bytes(&self) -> u64 {
+        self.claim.pipes.stderr.dropped()
+    }
+}
+
+impl Read for ChildStdout {
+    fn read(&mut self, buf: &mut [u8]) -> io::Result<usize> {
+        self.claim.pipes.stdout.read(buf, true)
+    }
+}
+
+impl Read for ChildStderr {
+    fn read(&mut self, buf: &mut [u8]) -> io::Result<usize> {
+        self.claim.pipes.stderr.read(buf, true)
+    }
+}
+
+impl std::fmt::Debug for ChildStdout {
+    fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
+        f.debug_struct("ChildStdout")
+            .field("pid", &self.claim.pid)
+            .finish_non_exhaustive()
+    }
+}
+
+impl std::fmt::Debug for ChildStderr {
+    fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
+        f.debug_struct("ChildStderr")
+            .field("pid", &self.claim.pid)
+            .finish_non_exhaustive()
+    }
+}
+
+fn lock<T>(mutex: &Mutex<T>) -> MutexGuard<'_, T> {
+    mutex.lock().unwrap_or_else(|err| err.into_inner())
+}
@@ -0,0 +1,65 @@
+use std::time::Duration;
+
+/// Time spent in each phase of backend start-up.
+///
+/// Returned by [`warm_up`](crate::warm_up). The first two phases describe
+/// the original backend initialization, even when `warm_up` runs after the
+/// backend was already in use. The local device is looked up on first use,
+/// so [`device_lookup`](Self::device_lookup) covers whichever call needed it
+/// first, which is `warm_up` itself for an otherwise idle backend.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct WarmUpReport {
+    frida_init: Duration,
+    injector: Duration,
+    device_lookup: Duration,
+    helper: Duration,
+    host_session: Duration,
+}
+
+impl WarmUpReport {
+    pub(crate) fn new(
+        frida_init: Duration,
+        injector: Duration,
+        device_lookup: Duration,
+        helper: Duration,
+        host_session: Duration,
+    ) -> Self {
+        Self {
+            frida_init,
+            injector,
+            device_lookup,
+            helper,
+            host_session,
+        }
+    }
+
+    /// Time spent in `frida_init`.
+    pub fn frida_init(&self) -> Duration {
+        self.frida_init
+    }
+
+    /// Time spent creating the injector.
+    pub fn injector(&self) -> Duration {
+        self.injector
+    }
+
+    /// Time spent creating the device manager and looking up the local device.
+    pub fn device_lookup(&self) -> Duration {
+        self.device_lookup
+    }
+
+    /// Time spent starting the injector helper process.
+    pub fn helper(&self) -> Duration {
+        self.helper
+    }
+
+    /// Time spent bringing up the local host session (spawn/resume/fallback).
+    pub fn host_session(&self) -> Duration {
+        self.host_session
+    }
+
+    /// Sum of all phases.
+    pub fn total(&self) -> Duration {
+        self.frida_init + self.injector + self.device_lookup + self.helper + self.host_session
+    }
+}
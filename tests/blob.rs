@@ -12,3 +12,59 @@ fn blob_accepts_bytes() {
     assert_eq!(lib.entrypoint().to_str().unwrap(), "frida_agent_main");
     assert_eq!(lib.data().to_str().unwrap(), "");
 }
+
+#[test]
+fn blob_accepts_shared_bytes() {
+    use std::sync::Arc;
+
+    let shared: Arc<[u8]> = Arc::from(&[1u8, 2, 3][..]);
+    let lib = Library::from_bytes(shared.clone()).unwrap();
+    let _clone = lib.clone();
+    // Cloning the library shares the payload instead of copying it.
+    assert_eq!(Arc::strong_count(&shared), 3);
+}
+
+#[test]
+fn mmap_accepts_file() {
+    let path = std::env::temp_dir().join(format!("hook-inject-mmap-{}.bin", std::process::id()));
+    std::fs::write(&path, [0x7f, b'E', b'L', b'F']).expect("write temp library");
+
+    let lib = unsafe { Library::from_mmap(&path) }.unwrap();
+    assert_eq!(lib.entrypoint().to_str().unwrap(), "frida_agent_main");
+    drop(lib);
+    let _ = std::fs::remove_file(path);
+}
+
+#[test]
+fn mmap_rejects_empty_file() {
+    let path =
+        std::env::temp_dir().join(format!("hook-inject-mmap-empty-{}.bin", std::process::id()));
+    std::fs::write(&path, []).expect("write temp library");
+
+    let err = unsafe { Library::from_mmap(&path) }.unwrap_err();
+    assert!(err.to_string().contains("library file is empty"));
+    let _ = std::fs::remove_file(path);
+}
+
+#[test]
+fn stage_writes_blob_once_and_cleans_up() {
+    let bytes: Vec<u8> = b"\x7fELF hook-inject stage test".to_vec();
+    let staged = Library::from_bytes(bytes.clone())
+        .unwrap()
+        .stage()
+        .expect("stage blob");
+    let path = staged
+        .path()
+        .expect("staged library has a path")
+        .to_path_buf();
+    assert_eq!(std::fs::read(&path).unwrap(), bytes);
+
+    // Staging the same bytes again reuses the file.
+    let again = Library::from_bytes(bytes).unwrap().stage().unwrap();
+    assert_eq!(again.path(), Some(path.as_path()));
+
+    drop(staged);
+    assert!(path.is_file(), "file lives while any staged handle does");
+    drop(again);
+    assert!(!path.exists(), "file removed with the last staged handle");
+}
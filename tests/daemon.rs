@@ -0,0 +1,152 @@
+#![cfg(unix)]
+
+use std::io::{BufRead, BufReader, Write};
+use std::os::unix::fs::PermissionsExt;
+use std::os::unix::net::{UnixListener, UnixStream};
+use std::path::{Path, PathBuf};
+use std::process::{Child, Command, Stdio};
+use std::time::{Duration, Instant};
+
+const BIN: &str = env!("CARGO_BIN_EXE_hook-inject");
+
+#[test]
+fn daemon_answers_pipelined_requests_in_order() {
+    if !unix_socket_available() {
+        eprintln!("skipping daemon test (unix socket bind denied)");
+        return;
+    }
+
+    let socket = socket_path("pipelined");
+    // A socket nobody listens on is stale and gets replaced.
+    drop(UnixListener::bind(&socket).expect("bind stale socket"));
+
+    let mut daemon = Daemon::start(&socket);
+    let mode = std::fs::metadata(&socket)
+        .expect("socket metadata")
+        .permissions()
+        .mode();
+    assert_eq!(mode & 0o777, 0o600, "socket should be owner-only");
+
+    let mut stream = UnixStream::connect(&socket).expect("connect to daemon");
+    stream
+        .write_all(b"a\tping\nb\tbogus\nc\tresume\t1\nd\tuninject\t42\ne\n")
+        .expect("send requests");
+    stream
+        .shutdown(std::net::Shutdown::Write)
+        .expect("shutdown write half");
+
+    let replies: Vec<String> = BufReader::new(stream)
+        .lines()
+        .map(|line| line.expect("read reply"))
+        .collect();
+    assert_eq!(
+        replies,
+        [
+            "a\tok",
+            "b\terr\tmalformed request: bogus",
+            "c\terr\tno suspended program with pid 1",
+            "d\terr\tunknown handle: 42",
+            "e\terr\tmissing verb",
+        ]
+    );
+
+    let output = Command::new(BIN)
+        .arg("--socket")
+        .arg(&socket)
+        .arg("ping")
+        .output()
+        .expect("run client");
+    assert!(output.status.success(), "client ping should succeed");
+
+    daemon.stop();
+}
+
+#[test]
+fn daemon_refuses_to_replace_other_files() {
+    let path = socket_path("regular");
+    std::fs::write(&path, b"keep me").expect("write file");
+
+    let output = Command::new(BIN)
+        .arg("daemon")
+        .arg(&path)
+        .output()
+        .expect("run daemon");
+    assert!(!output.status.success());
+    assert!(String::from_utf8_lossy(&output.stderr).contains("not a socket"));
+    assert_eq!(std::fs::read(&path).expect("file survives"), b"keep me");
+
+    let _ = std::fs::remove_file(&path);
+}
+
+#[test]
+fn stateful_verbs_need_a_daemon() {
+    for args in [
+        &["spawn", "/bin/true"][..],
+        &["resume", "1"],
+        &["uninject", "1"],
+    ] {
+        let output = Command::new(BIN).args(args).output().expect("run one-shot");
+        assert_eq!(output.status.code(), Some(2), "{args:?} should be rejected");
+        assert!(String::from_utf8_lossy(&output.stderr).contains("needs a daemon"));
+    }
+}
+
+struct Daemon {
+    child: Child,
+    socket: PathBuf,
+}
+
+impl Daemon {
+    fn start(socket: &Path) -> Daemon {
+        let child = Command::new(BIN)
+            .arg("daemon")
+            .arg(socket)
+            .stderr(Stdio::null())
+            .spawn()
+            .expect("spawn daemon");
+        let mut daemon = Daemon {
+            child,
+            socket: socket.to_path_buf(),
+        };
+
+        let deadline = Instant::now() + Duration::from_secs(10);
+        while UnixStream::connect(socket).is_err() {
+            if Instant::now() >= deadline {
+                daemon.stop();
+                panic!("daemon did not start listening");
+            }
+            std::thread::sleep(Duration::from_millis(20));
+        }
+        daemon
+    }
+
+    fn stop(&mut self) {
+        let _ = self.child.kill();
+        let _ = self.child.wait();
+        let _ = std::fs::remove_file(&self.socket);
+    }
+}
+
+impl Drop for Daemon {
+    fn drop(&mut self) {
+        self.stop();
+    }
+}
+
+fn socket_path(tag: &str) -> PathBuf {
+    std::env::temp_dir().join(format!(
+        "hook-inject-{}-{tag}-{}.sock",
+        std::process::id(),
+        std::time::SystemTime::now()
+            .duration_since(std::time::UNIX_EPOCH)
+            .unwrap()
+            .as_millis()
+    ))
+}
+
+fn unix_socket_available() -> bool {
+    let path = socket_path("probe");
+    let ok = UnixListener::bind(&path).is_ok();
+    let _ = std::fs::remove_file(&path);
+    ok
+}
@@ -0,0 +1,62 @@
+use hook_inject::{Device, DeviceTarget, Process, live_objects};
+
+// Kept alone in this binary: it counts live contexts, which any other test
+// creating a backend would disturb.
+#[test]
+fn device_connections_are_pooled_and_reopened_after_close() {
+    if !unix_socket_available() {
+        eprintln!("skipping device pool test (unix socket bind denied)");
+        return;
+    }
+
+    let me = Process::from_pid(std::process::id() as i32).expect("own pid");
+    let target = DeviceTarget::Id("local".into());
+    let baseline = live_objects().contexts();
+
+    let first = Device::connect(target.clone()).expect("connect to the local device by id");
+    assert_eq!(live_objects().contexts(), baseline + 1);
+
+    let second = Device::connect(target.clone()).expect("second connect");
+    assert_eq!(
+        live_objects().contexts(),
+        baseline + 1,
+        "a second connect should reuse the pooled backend"
+    );
+    assert_eq!(second.target(), &target);
+
+    // Closing only unpools; the backend lives until its last handle drops.
+    first.close();
+    assert_eq!(live_objects().contexts(), baseline + 1);
+    drop(second);
+    assert_eq!(live_objects().contexts(), baseline);
+
+    let reopened = Device::connect(target).expect("connect after close");
+    assert_eq!(live_objects().contexts(), baseline + 1);
+    let processes = reopened.processes().expect("reopened device should work");
+    assert!(
+        processes.iter().any(|info| info.process() == me),
+        "the local device should list this process"
+    );
+}
+
+#[cfg(unix)]
+fn unix_socket_available() -> bool {
+    use std::os::unix::net::UnixListener;
+
+    let path = std::env::temp_dir().join(format!("hook-inject-sock-{}", std::process::id()));
+
+    match UnixListener::bind(&path) {
+        Ok(listener) => {
+            drop(listener);
+            let _ = std::fs::remove_file(path);
+            true
+        }
+        Err(err) if err.kind() == std::io::ErrorKind::PermissionDenied => false,
+        Err(_) => true,
+    }
+}
+
+#[cfg(not(unix))]
+fn unix_socket_available() -> bool {
+    true
+}
@@ -0,0 +1,148 @@
+use std::path::{Path, PathBuf};
+use std::process::Command;
+use std::time::{Duration, Instant};
+
+use hook_inject::{InjectionPath, Library, Process, inject_process, uninject_all};
+
+// Kept alone in this binary: the injector mode is read when a backend is
+// created, so the variable must be set before any other test makes one.
+#[test]
+fn device_path_injections_uninject_cleanly() {
+    if !unix_socket_available() {
+        eprintln!("skipping device path test (unix socket bind denied)");
+        return;
+    }
+
+    // SAFETY: no backend (and so no backend thread) exists yet in this process.
+    unsafe { std::env::set_var("HOOK_INJECT_INJECTOR", "device") };
+
+    let root = PathBuf::from(env!("CARGO_MANIFEST_DIR"));
+    let target_bin = build_fixtures(&root);
+
+    let mut child = Command::new(&target_bin)
+        .arg("10000")
+        .spawn()
+        .expect("failed to spawn fixture target");
+    let process = Process::from_pid(child.id() as i32).expect("target pid should exist");
+
+    let inject = |tag: &str| {
+        let stamp = stamp_path(tag);
+        let library = Library::from_crate(root.join("fixtures/agent"))
+            .expect("fixture lib")
+            .with_data(std::ffi::CString::new(stamp.to_string_lossy().as_ref()).unwrap());
+        let injected = inject_process(process, library).expect("injection should succeed");
+        assert_eq!(injected.injection_path(), InjectionPath::Device);
+        assert!(
+            wait_for_file(&stamp),
+            "expected injection to write stamp file"
+        );
+        injected
+    };
+
+    inject("device-sync")
+        .uninject()
+        .expect("uninjecting a device-path injection should succeed");
+
+    block_on(inject("device-async").uninject_async())
+        .expect("async uninject of a device-path injection should succeed");
+
+    let injected = vec![inject("device-all-1"), inject("device-all-2")];
+    for result in uninject_all(injected) {
+        result.expect("uninject_all should succeed for device-path injections");
+    }
+
+    let _ = child.kill();
+    let _ = child.wait();
+}
+
+fn build_fixtures(root: &Path) -> PathBuf {
+    let status = Command::new("cargo")
+        .arg("build")
+        .arg("-p")
+        .arg("hook-inject-fixture-target")
+        .current_dir(root)
+        .status()
+        .expect("failed to build fixture target");
+    assert!(status.success());
+
+    let status = Command::new("cargo")
+        .arg("build")
+        .arg("-p")
+        .arg("hook-inject-fixture-agent")
+        .current_dir(root)
+        .status()
+        .expect("failed to build fixture agent");
+    assert!(status.success());
+
+    root.join("target")
+        .join("debug")
+        .join("hook-inject-fixture-target")
+}
+
+fn stamp_path(tag: &str) -> PathBuf {
+    std::env::temp_dir().join(format!(
+        "hook-inject-{}-{tag}-{}.stamp",
+        std::process::id(),
+        std::time::SystemTime::now()
+            .duration_since(std::time::UNIX_EPOCH)
+            .unwrap()
+            .as_millis()
+    ))
+}
+
+fn wait_for_file(path: &Path) -> bool {
+    let deadline = Instant::now() + Duration::from_secs(5);
+    while Instant::now() < deadline {
+        if path.is_file() {
+            return true;
+        }
+        std::thread::sleep(Duration::from_millis(50));
+    }
+    path.is_file()
+}
+
+fn block_on<F: std::future::Future>(future: F) -> F::Output {
+    use std::sync::Arc;
+    use std::task::{Context, Poll, Wake, Waker};
+    use std::thread::Thread;
+
+    struct ThreadWaker(Thread);
+
+    impl Wake for ThreadWaker {
+        fn wake(self: Arc<Self>) {
+            self.0.unpark();
+        }
+    }
+
+    let waker = Waker::from(Arc::new(ThreadWaker(std::thread::current())));
+    let mut cx = Context::from_waker(&waker);
+    let mut future = std::pin::pin!(future);
+    loop {
+        match future.as_mut().poll(&mut cx) {
+            Poll::Ready(output) => return output,
+            Poll::Pending => std::thread::park(),
+        }
+    }
+}
+
+#[cfg(unix)]
+fn unix_socket_available() -> bool {
+    use std::os::unix::net::UnixListener;
+
+    let path = std::env::temp_dir().join(format!("hook-inject-sock-{}", std::process::id()));
+
+    match UnixListener::bind(&path) {
+        Ok(listener) => {
+            drop(listener);
+            let _ = std::fs::remove_file(path);
+            true
+        }
+        Err(err) if err.kind() == std::io::ErrorKind::PermissionDenied => false,
+        Err(_) => true,
+    }
+}
+
+#[cfg(not(unix))]
+fn unix_socket_available() -> bool {
+    true
+}
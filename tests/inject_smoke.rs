@@ -1,9 +1,45 @@
+use std::path::{Path, PathBuf};
+use std::process::Command;
+use std::time::{Duration, Instant};
+
 #[test]
 fn inject_fixture_into_target() {
-    use std::path::PathBuf;
-    use std::process::Command;
-    use std::time::{Duration, Instant};
+    use hook_inject::{Library, Process, inject_process};
+
+    if !unix_socket_available() {
+        eprintln!("skipping inject smoke test (unix socket bind denied)");
+        return;
+    }
+
+    let root = PathBuf::from(env!("CARGO_MANIFEST_DIR"));
+    let target_bin = build_fixtures(&root);
+    let stamp = stamp_path("single");
+
+    let mut child = Command::new(&target_bin)
+        .arg("10000")
+        .spawn()
+        .expect("failed to spawn fixture target");
 
+    let process = Process::from_pid(child.id() as i32).expect("target pid should exist");
+    let library = Library::from_crate(root.join("fixtures/agent"))
+        .expect("fixture lib")
+        .with_data(std::ffi::CString::new(stamp.to_string_lossy().as_ref()).unwrap());
+
+    let _inject = inject_process(process, library).expect("injection should succeed");
+
+    assert!(
+        wait_for_file(&stamp),
+        "expected injection to write stamp file"
+    );
+    let contents = std::fs::read(&stamp).expect("read stamp");
+    assert_eq!(contents, b"ok");
+
+    let _ = child.kill();
+    let _ = child.wait();
+}
+
+#[test]
+fn reinvoke_runs_entrypoint_with_new_data() {
     use hook_inject::{Library, Process, inject_process};
 
     if !unix_socket_available() {
@@ -12,24 +48,655 @@ fn inject_fixture_into_target() {
     }
 
     let root = PathBuf::from(env!("CARGO_MANIFEST_DIR"));
-    let target_bin = root
-        .join("target")
-        .join("debug")
-        .join("hook-inject-fixture-target");
-    let stamp = std::env::temp_dir().join(format!(
-        "hook-inject-{}-{}.stamp",
-        std::process::id(),
-        std::time::SystemTime::now()
-            .duration_since(std::time::UNIX_EPOCH)
-            .unwrap()
-            .as_millis()
-    ));
+    let target_bin = build_fixtures(&root);
+    let first = stamp_path("reinvoke-first");
+    let second = stamp_path("reinvoke-second");
+    let resident =
+        |stamp: &Path| std::ffi::CString::new(format!("resident:{}", stamp.display())).unwrap();
+
+    let mut child = Command::new(&target_bin)
+        .arg("10000")
+        .spawn()
+        .expect("failed to spawn fixture target");
+
+    let process = Process::from_pid(child.id() as i32).expect("target pid should exist");
+    let library = Library::from_crate(root.join("fixtures/agent"))
+        .expect("fixture lib")
+        .with_data(resident(&first));
+
+    let injected = inject_process(process, library).expect("injection should succeed");
+    assert!(wait_for_contents(&first, b"1"), "expected first stamp file");
+
+    let update = injected
+        .reinvoke(resident(&second))
+        .expect("reinvoke should succeed");
+    assert_eq!(update.process(), process);
+    // The counter lives in the agent's image; a second copy would write 1.
+    assert!(
+        wait_for_contents(&second, b"2"),
+        "reinvoke should re-enter the resident agent"
+    );
+
+    let _ = child.kill();
+    let _ = child.wait();
+}
+
+#[test]
+fn shared_data_reaches_entrypoint_intact() {
+    use hook_inject::{Library, Process, SharedData, inject_process};
+
+    if !unix_socket_available() {
+        eprintln!("skipping inject smoke test (unix socket bind denied)");
+        return;
+    }
+
+    let root = PathBuf::from(env!("CARGO_MANIFEST_DIR"));
+    let target_bin = build_fixtures(&root);
+    let stamp = stamp_path("shared-data");
+
+    // The fixture agent writes everything after the first NUL to the stamp.
+    let blob: Vec<u8> = (0..=255u8).cycle().take(1 << 20).collect();
+    let mut payload = stamp.to_string_lossy().into_owned().into_bytes();
+    payload.push(0);
+    payload.extend_from_slice(&blob);
+    let shared = SharedData::new(&payload).expect("shared data segment");
+    assert_eq!(shared.len(), payload.len() as u64);
+
+    let mut child = Command::new(&target_bin)
+        .arg("10000")
+        .spawn()
+        .expect("failed to spawn fixture target");
+
+    let process = Process::from_pid(child.id() as i32).expect("target pid should exist");
+    let library = Library::from_crate(root.join("fixtures/agent"))
+        .expect("fixture lib")
+        .with_shared_data(&shared);
+    let injected = inject_process(process, library).expect("injection should succeed");
+
+    // The agent may map the segment after inject_process returns; the
+    // handle keeps it in place until then.
+    let segment = shared.path().to_path_buf();
+    drop(shared);
+    assert!(segment.exists(), "injection handle should keep the segment");
+
+    let deadline = Instant::now() + Duration::from_secs(5);
+    while std::fs::read(&stamp).ok().as_deref() != Some(blob.as_slice()) {
+        assert!(
+            Instant::now() < deadline,
+            "expected shared data in stamp file"
+        );
+        std::thread::sleep(Duration::from_millis(50));
+    }
+
+    drop(injected);
+    assert!(
+        !segment.exists(),
+        "segment should be removed with its last handle"
+    );
+
+    let _ = std::fs::remove_file(&stamp);
+    let _ = child.kill();
+    let _ = child.wait();
+}
+
+#[test]
+fn uninjected_fires_when_target_exits() {
+    use hook_inject::{Library, Process, inject_process};
+
+    if !unix_socket_available() {
+        eprintln!("skipping inject smoke test (unix socket bind denied)");
+        return;
+    }
+
+    let root = PathBuf::from(env!("CARGO_MANIFEST_DIR"));
+    let target_bin = build_fixtures(&root);
+    let stamp = stamp_path("uninjected");
+
+    let mut child = Command::new(&target_bin)
+        .arg("10000")
+        .spawn()
+        .expect("failed to spawn fixture target");
+
+    let process = Process::from_pid(child.id() as i32).expect("target pid should exist");
+    let library = Library::from_crate(root.join("fixtures/agent"))
+        .expect("fixture lib")
+        .with_data(std::ffi::CString::new(stamp.to_string_lossy().as_ref()).unwrap());
+
+    let injected = inject_process(process, library).expect("injection should succeed");
+    let (tx, rx) = std::sync::mpsc::channel();
+    injected.on_uninjected(move || {
+        let _ = tx.send(());
+    });
+
+    let _ = child.kill();
+    let _ = child.wait();
+    rx.recv_timeout(Duration::from_secs(5))
+        .expect("expected uninjected notification");
+}
+
+#[test]
+fn dropped_guard_is_uninjected_by_reaper() {
+    use hook_inject::{Library, Process, inject_process};
+
+    if !unix_socket_available() {
+        eprintln!("skipping inject smoke test (unix socket bind denied)");
+        return;
+    }
+
+    let root = PathBuf::from(env!("CARGO_MANIFEST_DIR"));
+    let target_bin = build_fixtures(&root);
+    let stamp = stamp_path("reaper");
+
+    let mut child = Command::new(&target_bin)
+        .arg("10000")
+        .spawn()
+        .expect("failed to spawn fixture target");
+
+    // A resident agent never unloads, so only the reaper's demonitor can
+    // release the watch.
+    let process = Process::from_pid(child.id() as i32).expect("target pid should exist");
+    let data = format!("resident:{}", stamp.display());
+    let library = Library::from_crate(root.join("fixtures/agent"))
+        .expect("fixture lib")
+        .with_data(std::ffi::CString::new(data).unwrap());
+
+    let guard = inject_process(process, library)
+        .expect("injection should succeed")
+        .uninject_on_drop();
+    assert!(wait_for_file(&stamp), "expected resident stamp file");
+    let (tx, rx) = std::sync::mpsc::channel();
+    guard.on_uninjected(move || {
+        let _ = tx.send(());
+    });
+    assert!(
+        rx.recv_timeout(Duration::from_millis(200)).is_err(),
+        "resident agent should not unload on its own"
+    );
+
+    drop(guard);
+    rx.recv_timeout(Duration::from_secs(5))
+        .expect("expected the reaper to uninject the dropped guard");
+
+    let _ = child.kill();
+    let _ = child.wait();
+}
+
+#[test]
+#[cfg(target_os = "linux")]
+fn gating_skips_fork_children_and_injects_execs() {
+    use hook_inject::{ChildOrigin, Library, Process, inject_process};
+    use std::io::Write;
+
+    if !unix_socket_available() {
+        eprintln!("skipping inject smoke test (unix socket bind denied)");
+        return;
+    }
+
+    let root = PathBuf::from(env!("CARGO_MANIFEST_DIR"));
+    build_fixtures(&root);
+    let stamp = stamp_path("gating");
+
+    // The shell waits for a line, forks a subshell that does not exec, then
+    // forks and execs `true`.
+    let mut child = Command::new("/bin/sh")
+        .arg("-c")
+        .arg("read go; (exit 0); /bin/true; sleep 2")
+        .stdin(std::process::Stdio::piped())
+        .spawn()
+        .expect("failed to spawn shell");
+
+    let process = Process::from_pid(child.id() as i32).expect("shell pid should exist");
+    let library = Library::from_crate(root.join("fixtures/agent"))
+        .expect("fixture lib")
+        .with_data(std::ffi::CString::new(stamp.to_string_lossy().as_ref()).unwrap());
+    let injected = inject_process(process, library).expect("injection should succeed");
+    assert!(wait_for_file(&stamp), "expected the shell to be injected");
+    std::fs::remove_file(&stamp).expect("reset stamp");
+
+    let gating = injected
+        .follow_children()
+        .expect("child gating should enable");
+    let (tx, rx) = std::sync::mpsc::channel();
+    let tx = std::sync::Mutex::new(tx);
+    gating.on_child(move |child| {
+        let injected = child.injected().map(|result| result.is_ok());
+        let _ = tx.lock().unwrap().send((child.origin(), injected));
+    });
+
+    let mut stdin = child.stdin.take().expect("shell stdin");
+    writeln!(stdin, "go").expect("release the shell");
+
+    let mut forks = Vec::new();
+    let mut execs = Vec::new();
+    let deadline = Instant::now() + Duration::from_secs(10);
+    while execs.is_empty() && Instant::now() < deadline {
+        match rx.recv_timeout(Duration::from_millis(200)) {
+            Ok((ChildOrigin::Fork, injected)) => forks.push(injected),
+            Ok((ChildOrigin::Exec, injected)) => execs.push(injected),
+            Ok(_) | Err(_) => {}
+        }
+    }
+
+    assert!(!forks.is_empty(), "expected fork children");
+    assert!(
+        forks.iter().all(Option::is_none),
+        "fork children should be resumed without re-injection"
+    );
+    assert_eq!(execs, [Some(true)], "the exec'd child should be injected");
+    assert!(
+        wait_for_file(&stamp),
+        "expected the exec'd child to run the agent"
+    );
+
+    drop(gating);
+    let _ = std::fs::remove_file(&stamp);
+    let _ = child.kill();
+    let _ = child.wait();
+}
+
+#[test]
+#[cfg(target_os = "linux")]
+fn cancelling_a_launch_midway_kills_the_child() {
+    use hook_inject::{Cancellation, Library, spawn};
+
+    if !unix_socket_available() {
+        eprintln!("skipping inject smoke test (unix socket bind denied)");
+        return;
+    }
+
+    let root = PathBuf::from(env!("CARGO_MANIFEST_DIR"));
+    build_fixtures(&root);
+    let library = Library::from_crate(root.join("fixtures/agent"))
+        .expect("fixture lib")
+        .with_data(c"/dev/null");
+
+    // Cancel from another thread after growing delays. The spawn itself is
+    // not cancellable, so every cancellation lands once the child exists,
+    // and none of them may leave it behind.
+    let cancelled = launch_until_finished(|delay| {
+        let cancel = Cancellation::new();
+        let canceller = cancel.clone();
+        std::thread::spawn(move || {
+            std::thread::sleep(delay);
+            canceller.cancel();
+        });
+        let result = spawn(sleeper(delay))
+            .and_then(|suspended| suspended.inject_cancellable(library.clone(), &cancel));
+        (result, cancel)
+    });
+    assert!(
+        cancelled > 0,
+        "expected at least one launch to be cancelled"
+    );
+}
+
+#[test]
+#[cfg(target_os = "linux")]
+fn launch_deadline_cancels_and_kills_the_child() {
+    use hook_inject::{Cancellation, Library, spawn};
+
+    if !unix_socket_available() {
+        eprintln!("skipping inject smoke test (unix socket bind denied)");
+        return;
+    }
+
+    let root = PathBuf::from(env!("CARGO_MANIFEST_DIR"));
+    build_fixtures(&root);
+    let library = Library::from_crate(root.join("fixtures/agent"))
+        .expect("fixture lib")
+        .with_data(c"/dev/null");
+
+    // Only the deadline's timer thread cancels these.
+    let cancelled = launch_until_finished(|delay| {
+        let cancel = Cancellation::with_timeout(delay);
+        let result = spawn(sleeper(delay))
+            .and_then(|suspended| suspended.inject_cancellable(library.clone(), &cancel));
+        (result, cancel)
+    });
+    assert!(cancelled > 0, "expected at least one deadline to expire");
+}
+
+/// Launch with each delay until one finishes in time; returns how many
+/// launches were cancelled, having checked each left no child behind.
+#[cfg(target_os = "linux")]
+fn launch_until_finished(
+    mut launch: impl FnMut(
+        Duration,
+    ) -> (
+        hook_inject::Result<hook_inject::InjectedProgram>,
+        hook_inject::Cancellation,
+    ),
+) -> usize {
+    let mut cancelled = 0;
+    for millis in [0, 1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000] {
+        let delay = Duration::from_millis(millis);
+        let tag = sleeper_tag(delay);
+        match launch(delay) {
+            (Ok(program), _) => {
+                unsafe { libc::kill(program.process().pid(), libc::SIGKILL) };
+                return cancelled;
+            }
+            (Err(err), cancel) => {
+                assert!(err.is_cancelled(), "unexpected error: {err}");
+                assert!(cancel.is_cancelled());
+                assert!(
+                    wait_for_exit(&tag),
+                    "a cancelled launch left its child running ({millis}ms)"
+                );
+                cancelled += 1;
+            }
+        }
+    }
+    cancelled
+}
+
+/// A long sleep whose command line is unique to `delay` and this test run.
+#[cfg(target_os = "linux")]
+fn sleeper(delay: Duration) -> hook_inject::Program {
+    let mut program = hook_inject::Program::new("/bin/sleep");
+    program.arg("600").arg(sleeper_tag(delay));
+    program
+}
+
+#[cfg(target_os = "linux")]
+fn sleeper_tag(delay: Duration) -> String {
+    format!("0.{}{:06}", std::process::id(), delay.as_millis())
+}
+
+/// Wait for every live process whose arguments include `tag` to go away.
+#[cfg(target_os = "linux")]
+fn wait_for_exit(tag: &str) -> bool {
+    let running = || {
+        std::fs::read_dir("/proc")
+            .into_iter()
+            .flatten()
+            .flatten()
+            .any(|entry| {
+                std::fs::read(entry.path().join("cmdline")).is_ok_and(|cmdline| {
+                    cmdline.split(|&b| b == 0).any(|arg| arg == tag.as_bytes())
+                })
+            })
+    };
+    let deadline = Instant::now() + Duration::from_secs(5);
+    while Instant::now() < deadline {
+        if !running() {
+            return true;
+        }
+        std::thread::sleep(Duration::from_millis(50));
+    }
+    !running()
+}
+
+#[test]
+fn warm_up_reports_startup_phases() {
+    if !unix_socket_available() {
+        eprintln!("skipping inject smoke test (unix socket bind denied)");
+        return;
+    }
+
+    let first = hook_inject::warm_up().expect("warm_up should succeed");
+    assert_eq!(
+        first.total(),
+        first.frida_init()
+            + first.injector()
+            + first.device_lookup()
+            + first.helper()
+            + first.host_session()
+    );
+    assert!(
+        first.frida_init() + first.injector() > Duration::ZERO,
+        "backend initialization should be timed"
+    );
+
+    // Initialization is described once; later calls report the same phases.
+    let again = hook_inject::warm_up().expect("second warm_up should succeed");
+    assert_eq!(again.frida_init(), first.frida_init());
+    assert_eq!(again.injector(), first.injector());
+    assert_eq!(again.device_lookup(), first.device_lookup());
+}
+
+#[test]
+fn metrics_hook_reports_injection_phases() {
+    use hook_inject::{
+        InjectionOp, Library, Process, clear_metrics_hook, inject_process, set_metrics_hook,
+    };
+    use std::sync::{Arc, Mutex};
+
+    if !unix_socket_available() {
+        eprintln!("skipping inject smoke test (unix socket bind denied)");
+        return;
+    }
+
+    let root = PathBuf::from(env!("CARGO_MANIFEST_DIR"));
+    let target_bin = build_fixtures(&root);
+    let stamp = stamp_path("metrics");
+
+    let mut child = Command::new(&target_bin)
+        .arg("10000")
+        .spawn()
+        .expect("failed to spawn fixture target");
+
+    let process = Process::from_pid(child.id() as i32).expect("target pid should exist");
+    let library = Library::from_crate(root.join("fixtures/agent"))
+        .expect("fixture lib")
+        .with_data(std::ffi::CString::new(stamp.to_string_lossy().as_ref()).unwrap());
+
+    let records = Arc::new(Mutex::new(Vec::new()));
+    let sink = records.clone();
+    set_metrics_hook(move |metrics| sink.lock().unwrap().push(metrics.clone()));
+
+    let _inject = inject_process(process, library.clone()).expect("injection should succeed");
+
+    {
+        let records = records.lock().unwrap();
+        let record = records
+            .iter()
+            .find(|metrics| metrics.process() == Some(process))
+            .expect("expected a metrics record for the target");
+        assert_eq!(record.op(), InjectionOp::Process);
+        assert!(record.succeeded());
+        assert!(record.total() >= record.inject());
+        assert!(record.total() >= record.device_lookup());
+    }
+
+    // Once cleared, injections are no longer reported.
+    clear_metrics_hook();
+    let reported = || {
+        let records = records.lock().unwrap();
+        records
+            .iter()
+            .filter(|metrics| metrics.process() == Some(process))
+            .count()
+    };
+    let seen = reported();
+    let _again = inject_process(process, library).expect("second injection should succeed");
+    assert_eq!(reported(), seen);
+
+    let _ = child.kill();
+    let _ = child.wait();
+}
+
+#[test]
+fn inject_fixture_into_many_targets() {
+    use hook_inject::{Library, Process, inject_processes, uninject_all};
+
+    if !unix_socket_available() {
+        eprintln!("skipping inject smoke test (unix socket bind denied)");
+        return;
+    }
+
+    let root = PathBuf::from(env!("CARGO_MANIFEST_DIR"));
+    let target_bin = build_fixtures(&root);
+    let stamp = stamp_path("many");
+
+    let mut children: Vec<_> = (0..3)
+        .map(|_| {
+            Command::new(&target_bin)
+                .arg("10000")
+                .spawn()
+                .expect("failed to spawn fixture target")
+        })
+        .collect();
+
+    let processes: Vec<Process> = children
+        .iter()
+        .map(|child| Process::from_pid(child.id() as i32).expect("target pid should exist"))
+        .collect();
+    let library = Library::from_crate(root.join("fixtures/agent"))
+        .expect("fixture lib")
+        .with_data(std::ffi::CString::new(stamp.to_string_lossy().as_ref()).unwrap());
+
+    let results = inject_processes(&processes, library).expect("backend should be available");
+    assert_eq!(results.len(), processes.len());
+    let mut injected = Vec::new();
+    for (process, result) in processes.iter().zip(results) {
+        let handle = result.expect("injection should succeed");
+        assert_eq!(handle.process(), *process);
+        injected.push(handle);
+    }
+
+    assert!(
+        wait_for_file(&stamp),
+        "expected injection to write stamp file"
+    );
+
+    for result in uninject_all(injected) {
+        result.expect("uninject should succeed");
+    }
+
+    for child in &mut children {
+        let _ = child.kill();
+        let _ = child.wait();
+    }
+}
+
+#[test]
+fn spawn_batch_injects_every_fixture() {
+    use hook_inject::{Library, Program, spawn_batch};
+
+    if !unix_socket_available() {
+        eprintln!("skipping inject smoke test (unix socket bind denied)");
+        return;
+    }
+
+    let root = PathBuf::from(env!("CARGO_MANIFEST_DIR"));
+    let target_bin = build_fixtures(&root);
+    let stamp = stamp_path("batch");
+
+    let programs: Vec<Program> = (0..3)
+        .map(|_| {
+            let mut program = Program::new(&target_bin);
+            program.arg("1000");
+            program
+        })
+        .collect();
+    let library = Library::from_crate(root.join("fixtures/agent"))
+        .expect("fixture lib")
+        .with_data(std::ffi::CString::new(stamp.to_string_lossy().as_ref()).unwrap());
+
+    let results = spawn_batch(programs, library).expect("backend should be available");
+    assert_eq!(results.len(), 3);
+    for result in results {
+        result.expect("batch launch should succeed");
+    }
+
+    assert!(
+        wait_for_file(&stamp),
+        "expected injection to write stamp file"
+    );
+}
+
+#[test]
+fn inject_fixture_through_pool() {
+    use hook_inject::{BackendPool, Library, PoolStrategy, Process};
+
+    if !unix_socket_available() {
+        eprintln!("skipping inject smoke test (unix socket bind denied)");
+        return;
+    }
+
+    let root = PathBuf::from(env!("CARGO_MANIFEST_DIR"));
+    let target_bin = build_fixtures(&root);
+    let stamp = stamp_path("pool");
+
+    let mut children: Vec<_> = (0..4)
+        .map(|_| {
+            Command::new(&target_bin)
+                .arg("10000")
+                .spawn()
+                .expect("failed to spawn fixture target")
+        })
+        .collect();
+
+    let processes: Vec<Process> = children
+        .iter()
+        .map(|child| Process::from_pid(child.id() as i32).expect("target pid should exist"))
+        .collect();
+    let library = Library::from_crate(root.join("fixtures/agent"))
+        .expect("fixture lib")
+        .with_data(std::ffi::CString::new(stamp.to_string_lossy().as_ref()).unwrap());
+
+    let pool = BackendPool::new(2)
+        .expect("pool should start")
+        .strategy(PoolStrategy::PidHash);
+    let results = pool
+        .inject_processes(&processes, library)
+        .expect("backend should be available");
+    assert_eq!(results.len(), processes.len());
+    for (process, result) in processes.iter().zip(results) {
+        let injected = result.expect("injection should succeed");
+        assert_eq!(injected.process(), *process);
+        injected.uninject().expect("uninject should succeed");
+    }
+
+    assert!(
+        wait_for_file(&stamp),
+        "expected injection to write stamp file"
+    );
+
+    for child in &mut children {
+        let _ = child.kill();
+        let _ = child.wait();
+    }
+}
+
+#[test]
+fn process_index_tracks_fixture_target() {
+    use hook_inject::{Process, ProcessIndex};
+
+    if !unix_socket_available() {
+        eprintln!("skipping inject smoke test (unix socket bind denied)");
+        return;
+    }
 
+    let root = PathBuf::from(env!("CARGO_MANIFEST_DIR"));
+    let target_bin = build_fixtures(&root);
+
+    let mut index = ProcessIndex::new().expect("initial scan should succeed");
+    let mut child = Command::new(&target_bin)
+        .arg("10000")
+        .spawn()
+        .expect("failed to spawn fixture target");
+    let process = Process::from_pid(child.id() as i32).expect("target pid should exist");
+
+    let changes = index.refresh().expect("refresh should succeed");
+    assert!(changes.added().contains(&process));
+    let info = index.get(process).expect("fixture should be indexed");
+    assert!(info.matches_name("hook-inject-fixture-target"));
+
+    let _ = child.kill();
+    let _ = child.wait();
+    let changes = index.refresh().expect("refresh should succeed");
+    assert!(changes.removed().contains(&process));
+    assert!(index.get(process).is_none());
+}
+
+fn build_fixtures(root: &Path) -> PathBuf {
     let status = Command::new("cargo")
         .arg("build")
         .arg("-p")
         .arg("hook-inject-fixture-target")
-        .current_dir(&root)
+        .current_dir(root)
         .status()
         .expect("failed to build fixture target");
     assert!(status.success());
@@ -38,37 +705,47 @@ fn inject_fixture_into_target() {
         .arg("build")
         .arg("-p")
         .arg("hook-inject-fixture-agent")
-        .current_dir(&root)
+        .current_dir(root)
         .status()
         .expect("failed to build fixture agent");
     assert!(status.success());
 
-    let mut child = Command::new(&target_bin)
-        .arg("10000")
-        .spawn()
-        .expect("failed to spawn fixture target");
-
-    let process = Process::from_pid(child.id() as i32).expect("target pid should exist");
-    let library = Library::from_crate(root.join("fixtures/agent"))
-        .expect("fixture lib")
-        .with_data(std::ffi::CString::new(stamp.to_string_lossy().as_ref()).unwrap());
+    root.join("target")
+        .join("debug")
+        .join("hook-inject-fixture-target")
+}
 
-    let _inject = inject_process(process, library).expect("injection should succeed");
+fn stamp_path(tag: &str) -> PathBuf {
+    std::env::temp_dir().join(format!(
+        "hook-inject-{}-{tag}-{}.stamp",
+        std::process::id(),
+        std::time::SystemTime::now()
+            .duration_since(std::time::UNIX_EPOCH)
+            .unwrap()
+            .as_millis()
+    ))
+}
 
+fn wait_for_contents(path: &Path, expected: &[u8]) -> bool {
     let deadline = Instant::now() + Duration::from_secs(5);
     while Instant::now() < deadline {
-        if stamp.is_file() {
-            break;
+        if std::fs::read(path).is_ok_and(|contents| contents == expected) {
+            return true;
         }
         std::thread::sleep(Duration::from_millis(50));
     }
+    false
+}
 
-    assert!(stamp.is_file(), "expected injection to write stamp file");
-    let contents = std::fs::read(&stamp).expect("read stamp");
-    assert_eq!(contents, b"ok");
-
-    let _ = child.kill();
-    let _ = child.wait();
+fn wait_for_file(path: &Path) -> bool {
+    let deadline = Instant::now() + Duration::from_secs(5);
+    while Instant::now() < deadline {
+        if path.is_file() {
+            return true;
+        }
+        std::thread::sleep(Duration::from_millis(50));
+    }
+    path.is_file()
 }
 
 #[cfg(unix)]
@@ -19,3 +19,54 @@ fn data_sets_value() {
         .with_data(data.clone());
     assert_eq!(lib.data().to_bytes(), data.as_bytes());
 }
+
+#[test]
+fn shared_data_segment_is_private_and_removed() {
+    use hook_inject::SharedData;
+
+    let first = SharedData::new(b"binary\0config".as_slice()).expect("shared data");
+    let second = SharedData::new(b"binary\0config".as_slice()).expect("shared data");
+    assert_eq!(
+        std::fs::read(first.path()).expect("read"),
+        b"binary\0config"
+    );
+    assert_ne!(
+        first.path(),
+        second.path(),
+        "every segment gets its own name"
+    );
+
+    #[cfg(unix)]
+    {
+        use std::os::unix::fs::PermissionsExt;
+
+        let mode = |path: &std::path::Path| {
+            std::fs::metadata(path)
+                .expect("metadata")
+                .permissions()
+                .mode()
+                & 0o777
+        };
+        assert_eq!(mode(first.path()), 0o644);
+        let dir = first.path().parent().expect("segment dir");
+        assert_eq!(
+            mode(dir),
+            0o711,
+            "only this process may write the directory"
+        );
+    }
+
+    let path = first.path().to_path_buf();
+    let dir = path.parent().expect("segment dir").to_path_buf();
+    drop(first);
+    assert!(
+        !path.exists(),
+        "segment should be removed with its last handle"
+    );
+    assert!(
+        dir.exists(),
+        "directory stays while another segment uses it"
+    );
+    drop(second);
+    assert!(!dir.exists(), "directory should go with its last segment");
+}
@@ -1,6 +1,6 @@
 use std::path::PathBuf;
 
-use hook_inject::Library;
+use hook_inject::{Library, LibraryBundle, Process};
 
 #[test]
 fn from_path_rejects_dir() {
@@ -20,6 +20,85 @@ fn from_crate_finds_fixture_cdylib() {
     assert_eq!(lib.data().to_str().unwrap(), "fixture");
 }
 
+#[test]
+fn preflight_checks_fixture_against_own_process() {
+    let root = PathBuf::from(env!("CARGO_MANIFEST_DIR"));
+    let lib = Library::from_crate(root.join("fixtures/agent")).expect("fixture cdylib");
+    let own = Process::from_pid(std::process::id() as i32).expect("own pid");
+
+    lib.preflight(own)
+        .expect("fixture should match the test process");
+    let missing = lib
+        .clone()
+        .with_entrypoint(std::ffi::CString::new("hook_inject_missing_entry").unwrap());
+    let err = missing.preflight(own).unwrap_err();
+    assert!(err.to_string().contains("does not export"));
+
+    let garbage = Library::from_bytes(vec![0u8; 64]).expect("blob");
+    assert!(garbage.preflight(own).is_err());
+}
+
+#[test]
+#[cfg(any(target_os = "linux", target_os = "android"))]
+fn preflight_rejects_wrong_architecture() {
+    let root = PathBuf::from(env!("CARGO_MANIFEST_DIR"));
+    let lib = Library::from_crate(root.join("fixtures/agent")).expect("fixture cdylib");
+    let own = Process::from_pid(std::process::id() as i32).expect("own pid");
+
+    let foreign = Library::from_bytes(foreign_elf(&lib)).expect("blob");
+    let err = foreign.preflight(own).unwrap_err();
+    assert!(
+        err.to_string()
+            .contains("does not match the target process"),
+        "unexpected error: {err}"
+    );
+}
+
+#[test]
+fn bundle_selects_variant_for_own_process() {
+    let root = PathBuf::from(env!("CARGO_MANIFEST_DIR"));
+    let lib = Library::from_crate(root.join("fixtures/agent")).expect("fixture cdylib");
+    let own = Process::from_pid(std::process::id() as i32).expect("own pid");
+
+    let bundle = LibraryBundle::new()
+        .with_variant(lib.clone())
+        .expect("fixture should be a valid variant");
+    let selected = bundle.select(own).expect("fixture should match");
+    assert_eq!(selected.path(), lib.path());
+
+    let err = bundle.clone().with_variant(lib.clone()).unwrap_err();
+    assert!(err.to_string().contains("already has a variant"));
+    assert!(LibraryBundle::new().select(own).is_err());
+
+    if cfg!(any(target_os = "linux", target_os = "android")) {
+        // A synthetic build for another architecture is never chosen here.
+        let foreign = Library::from_bytes(foreign_elf(&lib)).expect("blob");
+        let mixed = LibraryBundle::new()
+            .with_variant(foreign.clone())
+            .expect("foreign variant")
+            .with_variant(lib.clone())
+            .expect("native variant");
+        assert_eq!(mixed.variants().count(), 2);
+        let selected = mixed.select(own).expect("native variant should match");
+        assert_eq!(selected.path(), lib.path());
+
+        let only_foreign = LibraryBundle::new()
+            .with_variant(foreign)
+            .expect("foreign variant");
+        let err = only_foreign.select(own).unwrap_err();
+        assert!(err.to_string().contains("no library variant matches"));
+    }
+}
+
+/// The fixture ELF with `e_machine` patched to another 64-bit architecture.
+fn foreign_elf(lib: &Library) -> Vec<u8> {
+    let mut bytes = std::fs::read(lib.path().expect("fixture path")).expect("read fixture");
+    let machine = u16::from_le_bytes([bytes[18], bytes[19]]);
+    let other: u16 = if machine == 62 { 183 } else { 62 };
+    bytes[18..20].copy_from_slice(&other.to_le_bytes());
+    bytes
+}
+
 #[test]
 fn from_crate_rejects_non_cdylib() {
     let root = PathBuf::from(env!("CARGO_MANIFEST_DIR"));
@@ -1,7 +1,34 @@
-use hook_inject::Process;
+use hook_inject::{Device, DeviceTarget, Process};
 
 #[test]
 fn from_pid_rejects_nonpositive() {
     let err = Process::from_pid(0).unwrap_err();
     assert!(err.to_string().contains("pid must be > 0"));
 }
+
+#[test]
+fn remote_device_rejects_nul_in_address() {
+    let err = Device::connect(DeviceTarget::Remote("host\0:27042".into())).unwrap_err();
+    assert!(err.to_string().contains("device address"));
+}
+
+#[test]
+#[cfg(any(target_os = "linux", target_vendor = "apple", windows))]
+fn handle_tracks_child_exit() {
+    use std::time::Duration;
+
+    let mut child = std::process::Command::new(std::env::current_exe().unwrap())
+        .arg("--list")
+        .stdout(std::process::Stdio::null())
+        .spawn()
+        .expect("spawn child");
+    let handle = Process::from_pid(child.id() as i32)
+        .unwrap()
+        .open()
+        .expect("open handle");
+    assert_eq!(handle.process().pid(), child.id() as i32);
+
+    assert!(handle.wait_timeout(Duration::from_secs(10)).unwrap());
+    assert!(!handle.is_alive().unwrap());
+    let _ = child.wait();
+}
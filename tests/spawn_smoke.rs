@@ -11,3 +11,147 @@ fn spawn_resume_smoke() {
     let suspended = spawn(program).expect("spawn suspended");
     let _child = suspended.resume().expect("resume");
 }
+
+#[test]
+fn spawn_resume_async_smoke() {
+    use hook_inject::{Program, spawn_async};
+
+    if !cfg!(target_os = "linux") {
+        eprintln!("skipping spawn smoke test (non-linux)");
+        return;
+    }
+
+    block_on(async {
+        let program = Program::new("/usr/bin/true");
+        let suspended = spawn_async(program).await.expect("spawn suspended");
+        let _child = suspended.resume_async().await.expect("resume");
+    });
+}
+
+#[test]
+fn spawn_piped_stdout_is_readable() {
+    use hook_inject::{Program, Stdio, spawn};
+    use std::io::Read;
+
+    if !cfg!(target_os = "linux") {
+        eprintln!("skipping spawn smoke test (non-linux)");
+        return;
+    }
+
+    let mut program = Program::new("/bin/echo");
+    program.arg("hook-inject");
+    let suspended = spawn(program.stdio(Stdio::Pipe)).expect("spawn suspended");
+    let mut child = suspended.resume().expect("resume");
+    assert!(child.take_stdin().is_some());
+
+    let mut stdout = child.take_stdout().expect("piped stdout");
+    let mut output = String::new();
+    stdout.read_to_string(&mut output).expect("read stdout");
+    assert_eq!(output, "hook-inject\n");
+    assert_eq!(stdout.dropped_bytes(), 0);
+}
+
+#[test]
+fn prepared_program_relaunches_with_overrides() {
+    use hook_inject::{PreparedProgram, Program, Stdio};
+    use std::io::Read;
+
+    if !cfg!(target_os = "linux") {
+        eprintln!("skipping spawn smoke test (non-linux)");
+        return;
+    }
+
+    let mut program = Program::new("/bin/echo");
+    program.arg("hook-inject");
+    let prepared = PreparedProgram::new(program.stdio(Stdio::Pipe)).expect("prepare");
+
+    let launches = [
+        (prepared.launch(), "hook-inject\n"),
+        (prepared.launch().arg("again"), "hook-inject again\n"),
+    ];
+    for (launch, expected) in launches {
+        let mut child = launch
+            .spawn()
+            .expect("spawn suspended")
+            .resume()
+            .expect("resume");
+        let mut output = String::new();
+        child
+            .take_stdout()
+            .expect("piped stdout")
+            .read_to_string(&mut output)
+            .expect("read stdout");
+        assert_eq!(output, expected);
+    }
+}
+
+#[test]
+fn prepared_program_launches_through_pool_member() {
+    use hook_inject::{BackendPool, Program, Stdio};
+    use std::io::Read;
+
+    if !cfg!(target_os = "linux") {
+        eprintln!("skipping spawn smoke test (non-linux)");
+        return;
+    }
+
+    let pool = BackendPool::new(2).expect("pool should start");
+    let mut program = Program::new("/bin/echo");
+    program.arg("pooled");
+    let prepared = pool.prepare(program.stdio(Stdio::Pipe)).expect("prepare");
+    assert!(matches!(prepared.stdio(), Stdio::Pipe));
+
+    let mut child = prepared
+        .spawn()
+        .expect("spawn suspended")
+        .resume()
+        .expect("resume");
+    let mut output = String::new();
+    child
+        .take_stdout()
+        .expect("piped stdout")
+        .read_to_string(&mut output)
+        .expect("read stdout");
+    assert_eq!(output, "pooled\n");
+}
+
+#[test]
+fn cancelled_spawn_returns_cancelled_error() {
+    use hook_inject::{Cancellation, Program, spawn_cancellable};
+    use std::time::Duration;
+
+    if !cfg!(target_os = "linux") {
+        eprintln!("skipping spawn smoke test (non-linux)");
+        return;
+    }
+
+    let expired = Cancellation::with_timeout(Duration::ZERO);
+    assert!(expired.is_cancelled());
+    let err = spawn_cancellable(Program::new("/usr/bin/true"), &expired)
+        .expect_err("spawn with an expired deadline");
+    assert!(err.is_cancelled(), "unexpected error: {err}");
+}
+
+fn block_on<F: std::future::Future>(future: F) -> F::Output {
+    use std::sync::Arc;
+    use std::task::{Context, Poll, Wake, Waker};
+    use std::thread::Thread;
+
+    struct ThreadWaker(Thread);
+
+    impl Wake for ThreadWaker {
+        fn wake(self: Arc<Self>) {
+            self.0.unpark();
+        }
+    }
+
+    let waker = Waker::from(Arc::new(ThreadWaker(std::thread::current())));
+    let mut cx = Context::from_waker(&waker);
+    let mut future = std::pin::pin!(future);
+    loop {
+        match future.as_mut().poll(&mut cx) {
+            Poll::Ready(output) => return output,
+            Poll::Pending => std::thread::park(),
+        }
+    }
+}